@@ -70,22 +70,63 @@ namespace eddl {
     void removeLayer(Net *net, string l);
     void setTrainable(model net, string lanme, bool val);
 
+    /**
+      *  @brief Sets the algorithm used by the CPU convolutions of the model.
+      *
+      *  @details
+      *   Winograd is only used by 3x3 stride 1 convolutions and the direct depthwise kernel by
+      *   convolutions with one input channel per group, the rest of them fall back to im2col.
+      *
+      *  @param net  Model
+      *  @param algo  One of "auto" (default), "im2col", "winograd" or "depthwise"
+      *  @return     (void)
+    */
+    void setConvAlgorithm(model net, const string& algo);
+
+    /**
+      *  @brief Sets the memory layout of the 4D activations of a CPU model.
+      *
+      *  @details
+      *   With "nhwc" the convolutions, poolings, batch normalizations and element-wise layers exchange
+      *   channels-last data, and only the boundaries (input convolutions, Reshape/Flatten) convert it.
+      *   Layer shapes are not affected. Must be called after build.
+      *
+      *  @param net  Model
+      *  @param layout  One of "nchw" (default) or "nhwc"
+      *  @return     (void)
+    */
+    void setLayout(model net, const string& layout);
+
     vector<vtensor> get_parameters(model net, bool deepcopy=false, bool tocpu=false);
     void set_parameters(model net, const vector<vtensor>& params);
 
-    void build(model net, optimizer o=nullptr, CompServ *cs=nullptr, bool init_weigths=true);
+    void build(model net, optimizer o=nullptr, CompServ *cs=nullptr, bool init_weigths=true, bool flat_params=false, bool inplace=false);
 
     /**
       *  @brief Tell the model which optimizer, losses, metrics and computing services use.
       *
+      *  @details
+      *   With flat_params, all the parameters of each computing service are stored in one contiguous
+      *   tensor, and so are the gradients. The layer tensors become views into them, so zeroing the
+      *   gradients, clipping, optimizer steps and weight averaging run as single operations.
+      *   With inplace (CPU), element-wise layers whose derivative only needs their output (relu,
+      *   leaky relu, sigmoid, tanh, dropout, gaussian noise, exp, sqrt) overwrite the output and
+      *   delta of their parent when nothing else reads them, so the parent output is not
+      *   available afterwards. Select and Permute layers that leave their input as it is in memory
+      *   (identities, moves of size-1 axes) become views of their parent. Any other selection or
+      *   permutation, and Transpose, is still copied.
+      *
       *  @param net  Model
       *  @param o  Optimizer
       *  @param lo  Vector with losses
       *  @param me  Vector with metrics
       *  @param cs  Computing service
+      *  @param init_weights  Whether to initialize the parameters
+      *  @param flat_params  Whether to place parameters and gradients in contiguous tensors
+      *  @param inplace  Whether to run element-wise layers in place
       *  @return     (void)
     */
-    void build(model net, optimizer o, const vector<string> &lo, const vector<string> &me, CompServ *cs=nullptr, bool init_weights=true);
+    void build(model net, optimizer o, const vector<string> &lo, const vector<string> &me, CompServ *cs=nullptr, bool init_weights=true, bool flat_params=false, bool inplace=false);
 
     // Computing services
     /**
@@ -136,13 +177,25 @@ namespace eddl {
       *  @brief Executes the code in the GPU.
       *
       *  @param g  Vector of bools to set which GPUs will be used (1=on, 0=off)
-      *  @param mem  Indicates the memory consumption of the model. One of "full_mem" (default), "mid_mem" or "low_mem".
+      *  @param mem  Indicates the memory consumption of the model. One of "full_mem" (default), "mid_mem", "low_mem" or "recompute_mem" (the activations are computed again in the backward, see set_checkpoints).
       *  @return     The computer service itself.
     */
 
     compserv CS_CPU(int th,string mem);
 
 
+    /**
+      *  @brief Executes the code in the CPU.
+      *
+      *  @param th  Indicates the number of threads to use (-1 = all available threads)
+      *  @param mem  Indicates the memory consumption of the model. One of "full_mem" (default), "mid_mem" or "low_mem".
+      *  @param grain  Minimum number of elements per thread of the element-wise kernels. Smaller tensors run in a single thread.
+      *    The CPU kernels share one grain: a net sets the grain of its computing service every time it runs
+      *  @return     The computer service itself.
+    */
+    compserv CS_CPU(int th, string mem, int grain);
+
+
     /**
       *  @brief Executes the code in the GPU.
       *
@@ -319,11 +372,25 @@ namespace eddl {
       *  @param beta_1  Coefficients used for computing running averages of gradient and its square
       *  @param beta_2  Coefficients used for computing running averages of gradient and its square
       *  @param epsilon   Term added to the denominator to improve numerical stability
-      *  @param weight_decay   Weight decay (L2 penalty)
+      *  @param weight_decay   Weight decay, added to the gradient as an L2 penalty (so it also goes through the moments; see adamw for the decoupled one)
       *  @param amsgrad   Whether to apply the AMSGrad variant of this algorithm from the paper "On the Convergence of Adam and Beyond".
       *  @return     Adam optimizer
     */
-    optimizer adam(float lr=0.01, float beta_1=0.9, float beta_2=0.999, float epsilon=0.000001, float weight_decay=0,bool amsgrad=false); //Todo: Implement
+    optimizer adam(float lr=0.01, float beta_1=0.9, float beta_2=0.999, float epsilon=0.000001, float weight_decay=0,bool amsgrad=false);
+
+    /**
+      *  @brief AdamW optimizer.
+      *  @details Adam with the weight decay applied directly to the weights instead of being added to the gradients.
+      *  @see   https://arxiv.org/abs/1711.05101
+      *
+      *  @param lr  Learning rate
+      *  @param beta_1  Coefficients used for computing running averages of gradient and its square
+      *  @param beta_2  Coefficients used for computing running averages of gradient and its square
+      *  @param epsilon   Term added to the denominator to improve numerical stability
+      *  @param weight_decay   Decoupled weight decay
+      *  @return     AdamW optimizer
+    */
+    optimizer adamw(float lr=0.01, float beta_1=0.9, float beta_2=0.999, float epsilon=0.000001, float weight_decay=0.01);
 
 
     /**
@@ -335,12 +402,11 @@ namespace eddl {
       *  @see   http://www.jmlr.org/papers/volume12/duchi11a/duchi11a.pdf
       *
       *  @param lr  Learning rate
-      *  @param rho  Smoothing constant
       *  @param epsilon   Term added to the denominator to improve numerical stability
-      *  @param weight_decay   Weight decay (L2 penalty)
+      *  @param weight_decay   Weight decay, added to the gradient as an L2 penalty
       *  @return    Adagrad optimizer
     */
-    optimizer adagrad(float lr, float epsilon, float weight_decay); //Todo: Implement
+    optimizer adagrad(float lr=0.01, float epsilon=0.000001, float weight_decay=0.0);
 
     /**
       *  @brief Adamax optimizer.
@@ -385,10 +451,10 @@ namespace eddl {
       *  @param lr  Learning rate
       *  @param rho  Smoothing constant
       *  @param epsilon   Term added to the denominator to improve numerical stability
-      *  @param weight_decay   Weight decay (L2 penalty)
+      *  @param weight_decay   Weight decay, added to the gradient as an L2 penalty
       *  @return     RMSProp optimizer
     */
-    optimizer rmsprop(float lr=0.01, float rho=0.9, float epsilon=0.00001, float weight_decay=0.0); //Todo: Implement
+    optimizer rmsprop(float lr=0.01, float rho=0.9, float epsilon=0.00001, float weight_decay=0.0);
 
 
     /**
@@ -399,7 +465,7 @@ namespace eddl {
       *
       *  @param lr  Learning rate
       *  @param momentum  Momentum factor
-      *  @param weight_decay   Value to apply to the activation function
+      *  @param weight_decay   Weight decay, added to the gradient as an L2 penalty
       *  @param nesterov   Boolean. Whether to apply Nesterov momentum
       *  @return     Stochastic gradient descent optimizer
     */
@@ -510,6 +576,30 @@ namespace eddl {
       *  @return     (void)
     */
     void set_mode(model net, int mode);
+    /**
+      *  @brief Seed the random streams of the model layers (dropout, noise, data augmentation...), so they draw the same values on every run, regardless of the number of threads.
+      *
+      *  @param net  Model
+      *  @param seed  Seed
+      *  @return     (void)
+    */
+    void set_seed(model net, uint64_t seed);
+    /**
+      *  @brief Lets the intermediate outputs of the model share a few buffers in test mode (CPU), so predict and evaluate need memory for the widest part of the graph instead of for every layer. Only the outputs of the input and output layers can be read afterwards.
+      *
+      *  @param net  Model
+      *  @param enable  Whether to plan the memory
+      *  @return     (void)
+    */
+    void plan_memory(model net, bool enable=true);
+    /**
+      *  @brief Sets the layers that end the segments of the gradient checkpointing (CS "recompute_mem"). The outputs inside a segment are dropped after the forward and computed again for the backward. Without checkpoints, the net is split every sqrt(N) layers.
+      *
+      *  @param net  Model
+      *  @param layers  Layers whose outputs are kept
+      *  @return     (void)
+    */
+    void set_checkpoints(model net, vlayer layers);
     /**
       *  @brief Resets model loss.
       *
@@ -878,7 +968,7 @@ namespace eddl {
       *  @param strides  Vector of 2 integers, specifying the strides of the convolution along the height and width
       *  @param padding  One of "none", "valid" or "same"
       *  @param use_bias  Boolean, whether the layer uses a bias vector.
-      *  @param groups  Number of blocked connections from input channels to output channels
+      *  @param groups  Number of blocked connections from input channels to output channels. Input channels and filters must be divisible by it, groups equal to the input channels is a depthwise convolution (CPU only when greater than 1)
       *  @param dilation_rate  Vector of 2 integers, specifying the dilation rate to use for dilated convolution
       *  @param name  A name for the operation
       *  @return     Convolution layer
@@ -1020,9 +1110,10 @@ namespace eddl {
       *  @param output_dim  Dimension of the dense embedding
       *  @param length (1) Length of the sequence, to connect to Dense Layers no Recurrent
       *  @param name  A name for the operation
+      *  @param sparse_grad  Keep the gradient row-sparse, so each step only updates the rows of the words in the batch (CPU, SGD and Adam)
       *  @return The embedded input
     */
-    layer Embedding(layer parent, int vocsize, int length, int output_dim,  bool mask_zeros=false, string name = ""); //Todo: Implement
+    layer Embedding(layer parent, int vocsize, int length, int output_dim,  bool mask_zeros=false, string name = "", bool sparse_grad=false); //Todo: Implement
 
     /**
       *  @brief Transposes a Layer.
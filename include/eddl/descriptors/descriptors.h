@@ -40,7 +40,7 @@ public:
     int m;
     int red_size;
 
-    vector<vector<int>> index;
+    ReduceShape rs; // strided loops of the reduction
     Tensor *I; // input
     Tensor *O; // output
     Tensor *D; // delta
@@ -61,6 +61,23 @@ public:
 
 };
 
+// CPU convolution algorithms
+// - Auto: Winograd for 3x3/s1 kernels with enough channels, im2col+GEMM otherwise
+// - Im2col: always lower the input with im2col and use a GEMM
+// - Winograd: Winograd F(2x2,3x3)/F(4x4,3x3) whenever the geometry allows it
+// - Depthwise: direct kernel for convolutions with one input channel per group (chosen by Auto too)
+enum ConvAlgorithm {ConvAlgoAuto=0, ConvAlgoIm2col=1, ConvAlgoWinograd=2, ConvAlgoDepthwise=3};
+ConvAlgorithm getConvAlgorithm(const string& algo);
+
+// Memory layout of 4D activations. Shapes are always reported as {batch, channels, rows, cols},
+// NHWC only changes the order of the data in memory (CPU only)
+enum TensorLayout {LayoutNCHW=0, LayoutNHWC=1};
+TensorLayout getTensorLayout(const string& layout);
+
+// Activations that the CPU convolution can apply on its output tiles (fused Conv+Bias+Activation)
+enum ConvActivation {ConvActNone=0, ConvActReLU=1, ConvActLeakyReLU=2, ConvActSigmoid=3, ConvActTanh=4};
+ConvActivation getConvActivation(const string& act);
+
 class ConvolDescriptor {
 public:
     vector<int> ksize;
@@ -75,8 +92,12 @@ public:
     int padrt,padrb;
     int padcl,padcr;
     int size;  // Auxiliar var
+    int groups = 1; // every group of nk/groups kernels only sees kz=iz/groups input channels
     bool use_bias;
     int mem_level; // see CS
+    int algorithm = ConvAlgoAuto; // requested CPU algorithm
+    int algo = ConvAlgoIm2col; // selected CPU algorithm (resolved in build)
+    int wino_m = 2; // Winograd output tile size (2 or 4)
 
     Tensor *I= nullptr; // Input map
     Tensor *ID= nullptr;// Delta input map
@@ -90,7 +111,18 @@ public:
     Tensor *O= nullptr; // Outputmap
 
     // CPU implementation
-    float *ptrI;
+    float *ptrI = nullptr; // im2col buffer (whole batch or per-thread workspace, see mem_level)
+    int ws_rows = 0; // rows (output pixels) of every workspace tile
+    int ws_threads = 0; // number of workspace tiles (0: whole batch lowering)
+    float *ptrWK = nullptr; // Winograd transformed kernels
+    float *ptrWV = nullptr; // per-thread Winograd workspaces (transformed tiles and their products)
+    int wv_threads = 0; // number of workspaces in ptrWV
+    float *ptrGK = nullptr; // per-thread partial kernel gradients
+    int gk_threads = 0; // number of partial kernel gradients in ptrGK
+    int layout_in = LayoutNCHW; // layout of I and ID
+    int layout_out = LayoutNCHW; // layout of O and D
+    int act = ConvActNone; // fused activation: O and D hold the activated output and its delta
+    float act_param = 0.0f; // slope of the leaky relu
     Eigen::MatrixXf matI; // input
     Eigen::MatrixXf matK; // kernels
     Eigen::MatrixXf matO; // output
@@ -114,9 +146,9 @@ public:
 
     ConvolDescriptor();
 
-    ConvolDescriptor(int filters, const vector<int> &ks, const vector<int> &st, const string& p, bool use_bias, int mem=0);
+    ConvolDescriptor(int filters, const vector<int> &ks, const vector<int> &st, const string& p, bool use_bias, int mem=0, int groups=1);
 
-    ConvolDescriptor(const vector<int> &ks, const vector<int> &st, const vector<int> &p, int mem=0);
+    ConvolDescriptor(const vector<int> &ks, const vector<int> &st, const vector<int> &p, int mem=0, int groups=1);
 
     ~ConvolDescriptor();
 
@@ -124,6 +156,14 @@ public:
     void resize(int b);
     void enable_distributed();
 
+    void alloc_lowering(int b);
+    void set_mem_level(int mem);
+
+    void set_algorithm(int a);
+    void set_layout(int in, int out);
+    void select_algorithm();
+    bool winograd_compatible();
+
     static int compute_output(const string& padding, int input_size, int kerkel_size, int stride, int dilation_rate=1);
     static int compute_output(vector<int> padding, int input_size, int kerkel_size, int stride, int dilation_rate=1);
     static vector<int> compute_padding(int output_size, int input_size, int kerkel_size, int stride, string padding="same",bool row=false);
@@ -131,11 +171,20 @@ public:
 };
 
 
+// Largest window (kr*kc) whose CPU argmax is stored as an 8-bit in-window offset
+#define POOL_ARGMAX8_SIZE 256
+
 class PoolDescriptor : public ConvolDescriptor {
 public:
-    Tensor *indX, *indY; // indexes
+    Tensor *indX = nullptr, *indY = nullptr; // indexes (GPU and FPGA)
     int mem_level; // see CS
 
+    // CPU argmax of every output: in-window offset ki*kc+kj for windows up to POOL_ARGMAX8_SIZE,
+    // flat input offset (-1: padding) otherwise
+    unsigned char *arg8 = nullptr;
+    int *arg32 = nullptr;
+    int arg_size = 0;
+
     PoolDescriptor(const vector<int> &ks, const vector<int> &st, const string& p, int mem=0);
 
     PoolDescriptor(const vector<int> &ks, const vector<int> &st, const vector<int> &p, int mem=0);
@@ -144,6 +193,8 @@ public:
 
     void build(Tensor *A);
     void resize(int b);
+
+    void alloc_argmax();
 };
 
 #endif //EDDL_DESCRIPTORS_H
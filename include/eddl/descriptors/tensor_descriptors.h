@@ -54,12 +54,27 @@ public:
 
     vector<string> indices;
 
+    // Layout of the selection in the input: nruns runs of run contiguous elements, in output
+    // order. Run r starts at base(r), walking the (merged, size-1 free) axes vshape/vstride.
+    // A single run is a contiguous block, which can be used as a view of the input
+    int offset;
+    int run;
+    int nruns;
+    vector<int> vshape;
+    vector<int> vstride;
+
     explicit SelDescriptor(int dev);
     SelDescriptor(const vector<string>& indices, int dev);
 
     virtual void build(vector<int> ishape);
+    virtual void build_layout(const vector<int>& ishape);  // Shapes and runs, without the index table
     void resize(int b) override;
     virtual void build_indices();
+
+    void build_runs(const vector<int>& shape, const vector<int>& stride, int offset);
+    int base(int r) const;
+    bool is_view() const { return nruns == 1; }
+    bool is_identity() const;  // The whole input in memory order (only size-1 axes move)
 };
 
 class PermuteDescriptor : public SelDescriptor {
@@ -68,22 +83,51 @@ public:
 
     PermuteDescriptor(const vector<int>& dims, int dev);
 
-    void build(vector<int> ishape) override;
+    void build_layout(const vector<int>& ishape) override;
     void resize(int b) override;
     void build_indices() override;
 };
 
 
+// Reduction of a row-major tensor over some of its axes, as strided loops. Outputs are the
+// kept positions in row-major order; each one reduces nred inputs. Neighbour axes of the same
+// kind are merged (and size-1 axes dropped), so reducing the last axes is a single
+// contiguous run and no per-element index is ever stored.
+class ReduceShape {
+public:
+    vector<int> kshape;   // Kept axes (merged) and their input strides
+    vector<int> kstride;
+    vector<int> rshape;   // Reduced axes (merged) and their input strides
+    vector<int> rstride;
+    vector<int> raxes;    // Reduced axes as given (sorted, unmerged) and their input strides
+    vector<int> raxes_stride;
+    int nout;             // Number of reductions
+    int nred;             // Elements per reduction
+
+    ReduceShape();
+
+    void build(const vector<int>& ishape, const vector<int>& axis);
+
+    // Input offset of the first element of reduction i
+    int base(int i) const;
+    // Offset (from its base) of the m-th element of a reduction, in memory order
+    int offset(int m) const;
+    // Position of the m-th element (memory order) when the first reduced axis runs fastest.
+    // This is the order of the positions returned by argmax/argmin
+    int position(int m) const;
+    // Input addresses of all the reductions, one after the other, each one in position order
+    void addresses(int *ind) const;
+};
+
 class ReduceDescriptor2 : public TensorDescriptor {
 
 private:
     void compute_output();
-    void build_indices();
 
 public:
     vector<int> axis;
     bool keepdims;
-    vector<vector<int>> index;
+    ReduceShape rs;
     vector<int> ishape;
     vector<int> oshape;
     int size_reduction;
@@ -148,8 +148,25 @@
 #define _CPU_REPEAT_NN             144
 #define _CPU_D_REPEAT_NN           145
 #define _CPU_FLIP                  146
+#define _CPU_WINOGRAD              147
+#define _CPU_CONV2D_ACT_BACK       148
+#define _CPU_DEPTHWISE             149
+#define _CPU_EXPR                  150
+#define _CPU_SGD                   151
+#define _CPU_ADAM                  152
+#define _CPU_RMSPROP               153
+#define _CPU_ADAGRAD               154
+#define _CPU_BATCHNORM_FORWARD     155
+#define _CPU_BATCHNORM_BACKWARD    156
+#define _CPU_LAYERNORM_FORWARD     157
+#define _CPU_LAYERNORM_BACKWARD    158
+#define _CPU_LSTM_FORWARD          159
+#define _CPU_LSTM_BACKWARD         160
+#define _CPU_SGD_ROWS              161
+#define _CPU_ADAM_ROWS             162
+#define _CPU_D_ACTIVATION_INPLACE  163
 
-#define _NUM_CPU_FUNCS       147
+#define _NUM_CPU_FUNCS       164
 extern int num_instances[_NUM_CPU_FUNCS];
 void _profile(int f_id, int end);
 void _profile_add_tensor(unsigned long int size);
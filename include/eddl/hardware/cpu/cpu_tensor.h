@@ -20,6 +20,19 @@
 #define MIN_FLOAT -std::numeric_limits<float>::max()
 #define PRECISION_FLOAT -std::numeric_limits<float>::max()
 
+// CPU: Parallelism
+// Every thread gets at least cpu_grain elements: loops fork onto at most work/cpu_grain threads,
+// and small tensors (biases, gates, optimizer states of small layers) run inline:
+//   #pragma omp parallel for CPU_PARALLEL(n)
+// cpu_grain is global to the process. Each net sets the one of its CompServ when it runs.
+#define CPU_GRAIN_DEFAULT 4096
+#define CPU_PARALLEL(work) num_threads(cpu_threads(work)) if(cpu_parallel(work))
+
+extern long int cpu_grain;
+void cpu_set_grain(long int grain);
+inline bool cpu_parallel(long int work) { return work >= 2*cpu_grain; }
+int cpu_threads(long int work);  // min(available threads, work/cpu_grain), at least 1
+
 // CPU: Core (static)
 void cpu_transpose(Tensor *A, Tensor *B);
 void cpu_copy(Tensor *A, Tensor *B);
@@ -107,6 +120,23 @@ void cpu_tan(Tensor *A, Tensor *B);
 void cpu_tanh(Tensor *A, Tensor *B);
 void cpu_trunc(Tensor *A, Tensor *B);
 
+// CPU: Math (vectorized, contiguous arrays)
+// Polynomial approximations with AVX2 or AVX-512, chosen at runtime (scalar libm elsewhere).
+// Max error measured against double precision (also with BUILD_HPC): exp 1.5 ulp, log 1 ulp,
+// tanh 2 ulp, sigmoid and softplus 4.5 ulp. x and y can be the same array.
+#define CPU_ISA_SCALAR 0
+#define CPU_ISA_AVX2   1
+#define CPU_ISA_AVX512 2
+#define CPU_VBLOCK  4096  // Elements per task when a tensor is split among threads
+
+int cpu_isa();
+int cpu_set_isa(int isa);  // Clamped to what the processor supports. Returns the ISA in use
+void cpu_vexp(const float *x, float *y, long int n);
+void cpu_vlog(const float *x, float *y, long int n);
+void cpu_vtanh(const float *x, float *y, long int n);
+void cpu_vsigmoid(const float *x, float *y, long int n);
+void cpu_vsoftplus(const float *x, float *y, long int n);
+
 // CPU: Math (static)
 void cpu_add(float scA, Tensor *A, float scB, Tensor *B, Tensor *C, int incC);
 void cpu_inc(Tensor *A, Tensor *B);
@@ -51,6 +51,9 @@ void cpu_d_exp(Tensor *D, Tensor *I, Tensor *PD);
 void cpu_tanh(Tensor *A, Tensor *B);
 void cpu_d_tanh(Tensor *D, Tensor *I, Tensor *PD);
 
+// D = D * f'(O) for a ConvActivation f, from its output O
+void cpu_d_activation_inplace(Tensor *D, Tensor *O, int act, float param);
+
 void cpu_softmax(Tensor *A, Tensor *B);
 void cpu_d_softmax(Tensor *D, Tensor *I, Tensor *PD);
 
@@ -58,6 +61,7 @@ void cpu_full_softmax(Tensor *A, Tensor *B, int axis, bool stable);
 void cpu_full_softmax_batched_2d(Tensor *A, Tensor *B, bool stable);  // TODO: Temp. function
 void cpu_full_softmax_nd(Tensor *A, Tensor *B, int axis, bool stable);  // TODO: Temp. function
 void cpu_d_full_softmax(Tensor *D, Tensor *I, Tensor *PD, int axis);
+void cpu_softmax_lse(Tensor *A, Tensor *B, Tensor *LSE);
 void cpu_d_full_softmax_batched_2d(Tensor *D, Tensor *I, Tensor *PD);  // TODO: Temp. function
 void cpu_d_full_softmax_nd(Tensor *D, Tensor *I, Tensor *PD, int axis); // TODO: Temp. function
 
@@ -71,6 +75,7 @@ void cpu_bin_cent(Tensor *A, Tensor *B, Tensor *C);
 
 float cpu_categorical_cross_entropy(Tensor* y_true, Tensor* y_pred);
 void cpu_d_categorical_cross_entropy(Tensor* y_true, Tensor* y_pred, Tensor* delta);
+float cpu_softmax_cross_entropy(Tensor* y_true, Tensor* X, Tensor* LSE);
 
 float cpu_binary_cross_entropy(Tensor* y_true, Tensor* y_pred);
 void cpu_d_binary_cross_entropy(Tensor* y_true, Tensor* y_pred, Tensor* delta);
@@ -85,6 +90,19 @@ int cpu_bin_accuracy(Tensor *A, Tensor *B);
 void cpu_conv2D(ConvolDescriptor *D);
 void cpu_conv2D_grad(ConvolDescriptor *D);
 void cpu_conv2D_back(ConvolDescriptor *D);
+void cpu_conv2D_act_back(ConvolDescriptor *D);
+
+// Bias and fused activation, applied by every forward kernel right after it writes the outputs:
+// pixels [ini, ini+rows) of a sample, or n outputs of channel k in a row
+void cpu_conv2D_epilogue(ConvolDescriptor *D, float *ptrO, int ini, int rows);
+void cpu_conv2D_epilogue_row(ConvolDescriptor *D, float *ptrO, int k, int n);
+
+void cpu_conv2D_winograd(ConvolDescriptor *D);
+void cpu_conv2D_back_winograd(ConvolDescriptor *D);
+
+void cpu_conv2D_depthwise(ConvolDescriptor *D);
+void cpu_conv2D_grad_depthwise(ConvolDescriptor *D);
+void cpu_conv2D_back_depthwise(ConvolDescriptor *D);
 
 // MaxPool
 void cpu_mpool2D(PoolDescriptor*D);
@@ -108,4 +126,23 @@ void cpu_permute_channels_first(Tensor *A,Tensor *B);
 void cpu_permute_channels_last(Tensor *A,Tensor *B);
 void cpu_permute_batch_first(Tensor *A,Tensor *B);
 void cpu_permute_batch_last(Tensor *A,Tensor *B);
+// Welford statistics plus fused normalize/affine, and the two-pass backward (no permutations)
+void cpu_batchnorm_forward(Tensor *X, Tensor *Y, Tensor *opa, Tensor *mean, Tensor *variance, Tensor *bn_g, Tensor *bn_b,
+                           Tensor *bn_mean, Tensor *bn_var, bool trmode, float epsilon, float momentum, bool channels_last);
+void cpu_batchnorm_backward(Tensor *D, Tensor *opa, Tensor *PD, Tensor *bn_g, Tensor *bn_var, Tensor *gbn_g, Tensor *gbn_b, bool channels_last);
+// Row-wise normalization (LayerNorm, GroupNorm) with fused affine
+void cpu_layernorm_forward(Tensor *X, Tensor *Y, Tensor *opa, Tensor *mean, Tensor *sd, Tensor *g, Tensor *b, float epsilon);
+void cpu_layernorm_backward(Tensor *D, Tensor *opa, Tensor *PD, Tensor *sd, Tensor *g, Tensor *gg, Tensor *gb);
+
+// LSTM (fused gate activations and state update over {N, 4*units} gate blocks)
+void cpu_lstm_forward(Tensor *X, Tensor *G, Tensor *bias, Tensor *cprev, Tensor *hprev, Tensor *mask, Tensor *C, Tensor *H, Tensor *TC);
+void cpu_lstm_backward(Tensor *G, Tensor *TC, Tensor *cprev, Tensor *mask, Tensor *DH, Tensor *DC, Tensor *DHprev, Tensor *DCprev);
+
+// Optimizers (single pass over param, grad and state)
+void cpu_sgd_step(Tensor *P, Tensor *G, Tensor *M, float lr, float mu, float weight_decay, bool nesterov);
+void cpu_adam_step(Tensor *P, Tensor *G, Tensor *M, Tensor *V, float lr, float beta_1, float beta_2, float epsilon, float weight_decay, bool decoupled, int t);
+void cpu_rmsprop_step(Tensor *P, Tensor *G, Tensor *V, float lr, float rho, float epsilon, float weight_decay);
+void cpu_adagrad_step(Tensor *P, Tensor *G, Tensor *V, float lr, float epsilon, float weight_decay);
+void cpu_sgd_step_rows(Tensor *P, Tensor *G, Tensor *M, const vector<int> &rows, float lr, float mu, float weight_decay, bool nesterov);
+void cpu_adam_step_rows(Tensor *P, Tensor *G, Tensor *M, Tensor *V, const vector<int> &rows, float lr, float beta_1, float beta_2, float epsilon, float weight_decay, bool decoupled, int t);
 #endif //EDDL_CPU_TENSOR_NN_H
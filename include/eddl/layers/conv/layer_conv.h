@@ -57,6 +57,11 @@ public:
 
     void resize(int batch) override;
 
+    void set_mem_level(int mem) override;
+
+    int layout_support() override { return LAYOUT_CONVERT; }
+    void set_layout(int l) override;
+
 	void update_weights(Tensor* w, Tensor* bias=nullptr) override;
 
 	void accumulate_accumulated_gradients(Tensor* gw, Tensor* gbias=nullptr) override;
@@ -108,6 +113,8 @@ public:
 
     void resize(int batch) override;
 
+    void set_mem_level(int mem) override;
+
 	void update_weights(Tensor* w, Tensor* bias=nullptr) override;
 
 	void accumulate_accumulated_gradients(Tensor* gw, Tensor* gbias=nullptr) override;
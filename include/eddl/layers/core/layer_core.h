@@ -71,6 +71,8 @@ public:
 
     void free_delta() override;
 
+    void resize(int batch) override;
+
     void forward() override;
 
     void backward() override;
@@ -91,7 +93,14 @@ public:
     vector<int> sind;
     static int total_layers;
 
-    LEmbedding(Layer *parent, int vocsize, int lenght, int dim, bool mask_zeros, string name, int dev, int mem);
+    // Row-sparse gradient (CPU): gE is only non-zero at the rows in grows, which the optimizers
+    // update alone. Unrolled steps record their rows in the root layer, the one owning E and gE
+    bool sparse_grad;
+    LEmbedding *root;
+    vector<int> grows;
+    vector<char> gtouched;
+
+    LEmbedding(Layer *parent, int vocsize, int lenght, int dim, bool mask_zeros, string name, int dev, int mem, bool sparse_grad=false);
 
     ~LEmbedding() override;
 
@@ -103,6 +112,10 @@ public:
 
     void backward() override;
 
+    void zeroGrads() override;
+
+    const vector<int> *grad_rows(int i) override;
+
     string plot(int c) override;
 
 };
@@ -161,8 +174,11 @@ public:
     string act;
     static int total_layers;
     vector<float> params;
+    bool fused; // computed by the parent convolution, output and delta are views of the parent ones
+    Tensor *lse; // softmax feeding a cross-entropy loss: log-sum-exp of each row (see LSoftmaxCrossEntropy)
 
     LActivation(Layer *parent, string act, vector<float> params, string name, int dev, int mem);
+    ~LActivation() override;
 
     Layer *share(int c, int bs, vector<Layer *> p) override;
 
@@ -171,6 +187,16 @@ public:
     void save(std::ofstream &ofs, string format) override;
     void load(std::ifstream &ifs, string format) override;
 
+    int layout_support() override;
+
+    void fuse();
+    bool can_inplace() override;
+
+    void mem_delta() override;
+    void free_delta() override;
+
+    void resize(int batch) override;
+
     void forward() override;
 
     void backward() override;
@@ -184,6 +210,8 @@ class LReshape : public LinLayer {
 public:
     static int total_layers;
     vector<int> ls;
+    bool permute; // parent is channels-last: output and delta are converted copies, not views
+    Tensor *nhwc_delta; // channels-last delta for the parent, with permute
 
     // constructors and clones
     LReshape(Layer *parent, vector<int> shape, string name, int dev, int mem);
@@ -197,6 +225,9 @@ public:
     void mem_delta() override;
     void free_delta() override;
 
+    int layout_support() override { return LAYOUT_BOUNDARY; }
+    void set_layout(int l) override;
+
     void forward() override;
 
     void backward() override;
@@ -246,10 +277,14 @@ public:
     float df;
     Tensor *mask;
 
+    int layout_support() override { return LAYOUT_KEEP; }
+
     // implementation
     void forward() override;
 
     void backward() override;
+
+    bool can_inplace() override { return true; }
     void resize(int batch) override;
     string plot(int c) override;
 
@@ -266,6 +301,8 @@ public:
 
     ~LSelect() override;
 
+    bool can_view() override { return sd->is_identity(); }
+
     void forward() override;
 
     void backward() override;
@@ -289,6 +326,8 @@ public:
 
     ~LPermute() override;
 
+    bool can_view() override { return sd->is_identity(); }
+
     void forward() override;
 
     void backward() override;
@@ -20,11 +20,18 @@
 #include "eddl/tensor/tensor_reduction.h"
 #include "eddl/tensor/nn/tensor_nn.h"
 #include "eddl/regularizers/regularizer.h"
+#include "eddl/random.h"
 
 
 #define TRMODE 1
 #define TSMODE 0
 
+// Channels-last support of a layer (see Net::setLayout)
+#define LAYOUT_FIXED 0     // channels-first inputs and output
+#define LAYOUT_KEEP 1      // any layout, the output follows the inputs
+#define LAYOUT_CONVERT 2   // any input layout, any output layout
+#define LAYOUT_BOUNDARY 3  // any input layout, channels-first output
+
 using namespace std;
 
 class Net;
@@ -45,6 +52,8 @@ public:
     bool iscloned;
     bool isnorm;
     bool isdecoder;
+    int layout; // memory layout of output and delta (TensorLayout)
+    bool inplace; // runs on the output and delta of its parent, which are views (see set_inplace)
 
     vector<Tensor *> params;
     vector<Tensor *> gradients;
@@ -61,6 +70,9 @@ public:
     Regularizer *reg;
     Initializer *init;
 
+    // Random stream of the layer while it runs (nullptr: the default one), see set_seed
+    PhiloxStream *rng;
+
     int mode;
     int dev;
     int lin, lout;
@@ -84,18 +96,34 @@ public:
     void clamp(float min,float max);
     void set_detach();
 
-    void set_mem_level(int mem);
+    virtual void set_mem_level(int mem);
+
+    virtual int layout_support() { return LAYOUT_FIXED; }
+    virtual void set_layout(int l);
 
     virtual void mem_delta_parent();
     virtual void mem_delta();
     virtual void free_delta();
 
+    // Moves the output to the memory ptr (its own memory again when nullptr). The views of it that
+    // the children made when they were created (LReshape and the like) follow it
+    void repoint_output(float *ptr);
+
+    // Element-wise layers whose backward only needs their output (or their own state, such as a
+    // dropout mask) can overwrite the output of their parent
+    virtual bool can_inplace() { return false; }
+    // Layers that only rearrange the axes of their input, keeping its memory order, can be a view
+    // of their parent (through set_inplace too) and do nothing in forward and backward
+    virtual bool can_view() { return false; }
+    void set_inplace();
+
 
     //virtual
     virtual void copy(Layer *l2);
 
     virtual void resize(int batch);
     virtual void setTrainable(bool value);
+    void set_seed(uint64_t seed);
 
     virtual void save(std::ofstream &ofs, string format="");
     virtual void load(std::ifstream &ifs, string format="");
@@ -103,6 +131,8 @@ public:
     virtual void reset();
     virtual int get_trainable_params_count();
     virtual void zeroGrads();
+    // Rows of gradients[i] that can be non-zero when the layer keeps it row-sparse (nullptr: dense)
+    virtual const vector<int> *grad_rows(int i) { return nullptr; }
     virtual string plot(int c) { return ""; }
 
     virtual void addchild(Layer *l) {}
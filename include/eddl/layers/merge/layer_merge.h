@@ -34,6 +34,8 @@ public:
 
     Layer *clone(int c, int bs, vector<Layer *> p, int todev) override;
 
+    int layout_support() override { return LAYOUT_KEEP; }
+
     void forward() override;
 
     void backward() override;
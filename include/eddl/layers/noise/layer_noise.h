@@ -36,6 +36,8 @@ public:
 
     Layer *clone(int c, int bs, vector<Layer *> p, int todev) override;
 
+    bool can_inplace() override { return true; }
+
     void resize(int batch) override;
 
     void mem_delta() override;
@@ -71,6 +71,8 @@ public:
 
     int get_trainable_params_count() override;
 
+    int layout_support() override { return (input->ndim == 4) ? LAYOUT_KEEP : LAYOUT_FIXED; }
+
     string plot(int c) override;
 };
 
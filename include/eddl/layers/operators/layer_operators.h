@@ -112,6 +112,8 @@ public:
 
     LExp(Layer *l, string name, int dev, int mem);
 
+    bool can_inplace() override { return true; }
+
     void forward() override;
 
     void backward() override;
@@ -230,6 +232,8 @@ public:
 
     LSqrt(Layer *l, string name, int dev, int mem);
 
+    bool can_inplace() override { return true; }
+
     void forward() override;
 
     void backward() override;
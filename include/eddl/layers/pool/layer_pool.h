@@ -36,6 +36,9 @@ public:
 
     void mem_delta() override;
 
+    int layout_support() override { return LAYOUT_KEEP; }
+    void set_layout(int l) override;
+
     void resize(int batch) override;
 };
 
@@ -118,6 +118,17 @@ public:
     Tensor *psh;
     Tensor *psc;
 
+    // Layer that owns the params: this one, or the one shared by an unrolled step
+    LLSTM *root;
+
+    // CPU: the gate weights packed side by side (input, forget, output, candidate) so each step
+    // is one GEMM per input. They belong to the root layer and are shared by its unrolled steps
+    Tensor *Wx4, *Wh4, *b4;
+    Tensor *gWx4, *gWh4, *gb4;
+
+    // CPU step workspace, kept for the backward: gates {N,4*units}, tanh(state_c) and the masked rows
+    Tensor *gates, *tc, *rmask;
+
 
     LLSTM(vector<Layer *> in, int units,  bool mask_zeros, bool bidirectional, string name, int dev, int mem);
 
@@ -136,6 +147,13 @@ public:
     void backward() override;
 
     string plot(int c) override;
+
+    bool first_step();
+    void pack_weights();
+    void unpack_gradients();
+    void reserve_workspace(int batch);
+    void fused_forward();
+    void fused_backward();
 };
 
 
@@ -128,6 +128,23 @@ public:
     Loss* clone() override;
 };
 
+// Softmax output layer + cross-entropy, set up by Net::build. The loss is computed from the
+// logits of the softmax and the log-sum-exp of its rows (kept by the softmax forward), and the
+// delta is softmax - target, which the softmax layer passes through. For categorical_cross_entropy
+// this assumes that every target row sums to one (one-hot or a distribution); otherwise the exact
+// gradient would be softmax * sum(target) - target.
+class LSoftmaxCrossEntropy : public Loss {
+public:
+    Tensor *logits;
+    Tensor *lse;  // nullptr: the loss is computed from the softmax output
+
+    LSoftmaxCrossEntropy(string name, Tensor *logits, Tensor *lse);
+
+    void delta(Tensor *T, Tensor *Y, Tensor *D) override;
+    float value(Tensor *T, Tensor *Y) override;
+    Loss* clone() override;
+};
+
 class LMin : public Loss {
 public:
     LMin();
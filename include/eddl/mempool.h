@@ -0,0 +1,44 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_MEMPOOL_H
+#define EDDL_MEMPOOL_H
+
+#include <cstddef>
+
+// Caching allocator behind get_fmem/free_fmem (CPU tensors and buffers).
+//
+// Blocks are 64-byte aligned and rounded up to a size class (four classes per power of two, so
+// at most 25% is wasted). Freed blocks are kept in a free list of the thread that frees them
+// and reused by the next request of the same class; when a thread holds too many, the rest
+// go to a shared list. Memory is only given back to the system with mempool_release, or when
+// a budget is set and a request would not fit in it otherwise.
+
+struct MemPoolStats {
+    unsigned long long hits;          // Requests served from a free list
+    unsigned long long misses;        // Requests that allocated new memory
+    unsigned long long bytes_in_use;  // Bytes of the blocks in use (size classes)
+    unsigned long long bytes_cached;  // Bytes of the blocks in the free lists
+    unsigned long long peak_bytes;    // Maximum of bytes_in_use
+};
+
+void *mempool_alloc(size_t bytes);
+void mempool_free(void *ptr);
+
+// Limit of bytes in use plus cached (0: no limit). Requests over it throw
+void mempool_set_budget(size_t bytes);
+size_t mempool_get_budget();
+
+// Returns the cached blocks (of every thread) to the system
+void mempool_release();
+
+MemPoolStats mempool_stats();
+void mempool_reset_peak();
+
+#endif //EDDL_MEMPOOL_H
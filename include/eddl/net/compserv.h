@@ -34,8 +34,13 @@ public:
     // 0: full memory. better performance in terms of speed
     // 1: mid memory. some memory improvements to save memory
     // 2: low memory. save memory as much as possible
+    // 3: recompute. low memory, and the forward activations are dropped and recomputed in the
+    //    backward (CPU, see Net::make_checkpoints)
     int mem_level;
 
+    // minimum elements per thread of the CPU element-wise kernels (see cpu_parallel)
+    long int cpu_grain;
+
 
 
     CompServ();
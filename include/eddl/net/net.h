@@ -87,13 +87,52 @@ public:
     vtensor Xs[MAX_THREADS];
     vtensor Ys[MAX_THREADS];
 
+    // Contiguous storage of all the params and gradients, when built with flat params.
+    // The trainable ones come first, in the order of the optimizer state
+    Tensor *param_arena;
+    Tensor *grad_arena;
+
+    // Softmax + cross-entropy losses created by build in place of the given ones (see build)
+    vloss fused_losses;
+
+    // Seeds the streams of the layers when set (see set_seed)
+    PhiloxStream *rng;
+
+    // Layout of the 4D activations asked for with setLayout, also used by the unrolled net
+    int layout;
+
+    // Inference memory plan (see make_memory_plan): in TSMODE the outputs of the planned layers
+    // live in a few shared buffers. plan_source is the layer a planned view points to (nullptr
+    // for the ones that got a buffer)
+    bool memory_plan;
+    vtensor plan_buffers;
+    vlayer plan_layers;
+    vlayer plan_source;
+
+    // Gradient checkpointing (mem_level 3, see make_checkpoints): the outputs of the layers in
+    // ckpt_drop[s] are dropped after segment s runs forward, and computed again for its backward
+    vlayer checkpoints;             // Layers that end a segment (every sqrt(N) layers if none)
+    vector<int> ckpt_fseg;          // Segment of each layer of vfts
+    vector<int> ckpt_bseg;          // Segment of each layer of vbts
+    vector<int> ckpt_source;        // Layer of vfts whose output each dropped view points to
+    vector<vector<int> > ckpt_drop;
+    vector<uint64_t> ckpt_counter;  // Position of the stream of each layer before its forward
+
     Net();
     Net(vlayer in, vlayer out);
     Net(vector <Net *> vnets);
     ~Net();
 
 
-    void build(Optimizer *opt, vloss lo, vmetrics me, CompServ *cs, bool initialize=true);
+    void build(Optimizer *opt, vloss lo, vmetrics me, CompServ *cs, bool initialize=true, bool flat_params=false, bool inplace=false);
+    void make_arenas();
+    void make_memory_plan();
+    void drop_memory_plan();
+    void make_checkpoints();
+    void set_checkpoints(vlayer l);
+    bool restore_segment(int s);
+    void drop_segment(int s);
+    void recompute_segment(int s);
     void toGPU(vector<int> g,int lsb,int mem);
     void toCPU(int t);
 
@@ -109,6 +148,10 @@ public:
     Layer* getLayer(string l);
     void removeLayer(string l);
     void setTrainable(string lanme, bool val);
+    void setConvAlgorithm(int algo);
+    void setLayout(int layout);
+    void fuse_layers();
+    void inplace_layers();
 
 
     int inNet(Layer *l);
@@ -124,6 +167,8 @@ public:
     void plot(string fname,string mode);
 
     void setmode(int m);
+    void set_seed(uint64_t seed);
+    void plan_memory(bool enable);
 
 
     void save(const string& filename, string format="");
@@ -32,11 +32,21 @@ public:
     float clip_val;
     Optimizer *orig;
 
+    // Trainable params and gradients of the net as two contiguous tensors (see Net::make_arenas)
+    Tensor *flat_params;
+    Tensor *flat_grads;
+
     Optimizer();
+    virtual ~Optimizer();
 
     void set_clip_val(float v);
     void clip();
 
+    // Packs the optimizer state with the same layout as the flat params
+    virtual void set_flat(Tensor *params, Tensor *grads);
+    // The flat tensors are set and every layer with params is trainable
+    bool use_flat();
+
     virtual void setlayers(vlayer l) {}
 
     virtual void applygrads(int batch) {}
@@ -56,6 +66,7 @@ public:
     bool nesterov;
 
     vtensor mT;
+    Tensor *mT_flat;
 
     explicit SGD(float lr=0.01f, float momentum=0.0f, float weight_decay=0.0f, bool nesterov=false);
     ~SGD();
@@ -64,6 +75,7 @@ public:
     Optimizer *share() override;
 
     void setlayers(vlayer l) override;
+    void set_flat(Tensor *params, Tensor *grads) override;
 
     void applygrads(int batch) override;
 
@@ -79,12 +91,13 @@ public:
     float epsilon;
     float weight_decay;
     bool amsgrad;
+    bool decoupled;  // Weight decay applied to the weights (AdamW) instead of the gradients
     int t;
 
     vtensor mT;
     vtensor vT;
-    vtensor mCap;
-    vtensor vCap;
+    Tensor *mT_flat;
+    Tensor *vT_flat;
 
     explicit Adam(float lr=0.01f, float beta_1=0.9f, float beta_2=0.999f, float epsilon=1e-8f, float weight_decay=0.0f, bool amsgrad=false);
     ~Adam();
@@ -93,12 +106,22 @@ public:
     Optimizer *share() override;
 
     void setlayers(vlayer l) override;
+    void set_flat(Tensor *params, Tensor *grads) override;
 
     void applygrads(int batch) override;
 
     void change(vector<float> &p) override;
 };
 
+// ---- AdamW ----
+class AdamW: public Adam {
+public:
+    explicit AdamW(float lr=0.01f, float beta_1=0.9f, float beta_2=0.999f, float epsilon=1e-8f, float weight_decay=0.01f);
+
+    Optimizer *clone() override;
+    Optimizer *share() override;
+};
+
 
 // ---- AdaDelta ----
 class AdaDelta : public Optimizer {
@@ -130,17 +153,20 @@ public:
     float weight_decay;
 
     vtensor mT;
+    Tensor *mT_flat;
 
     explicit Adagrad(float lr=0.01f, float epsilon=1e-8f, float weight_decay=0.0f);
     ~Adagrad();
 
-//    Optimizer *clone();
-//
-//    void setlayers(vlayer l);
-//
-//    void applygrads(int batch);
-//
-//    void change(const vector<float> &p);
+    Optimizer *clone() override;
+    Optimizer *share() override;
+
+    void setlayers(vlayer l) override;
+    void set_flat(Tensor *params, Tensor *grads) override;
+
+    void applygrads(int batch) override;
+
+    void change(vector<float> &p) override;
 };
 
 // ---- Adamax ----
@@ -199,7 +225,7 @@ public:
     float weight_decay;
 
     vtensor gT;
-    vtensor gT1;
+    Tensor *gT_flat;
 
     explicit RMSProp(float lr=0.01f, float rho=0.9f, float epsilon=1e-8f, float weight_decay=0.0f);
 
@@ -209,6 +235,7 @@ public:
     Optimizer *share() override;
 
     void setlayers(vlayer l) override;
+    void set_flat(Tensor *params, Tensor *grads) override;
 
     void applygrads(int batch) override;
 
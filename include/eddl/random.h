@@ -10,6 +10,9 @@
 #ifndef EDDL_RANDOM_H
 #define EDDL_RANDOM_H
 
+#include <cstdint>
+#include <atomic>
+
 float gaussgen();
 void build_randn_table();
 
@@ -20,4 +23,59 @@ float slow_randn(float mean, float sd);
 float fast_randn(float mean, float sd, int seed);
 
 
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as
+// 1, 2, 3"). Block c of a stream is four numbers that only depend on (key, c), so a tensor is
+// filled in parallel, without shared state, and with the same values for any number of threads.
+inline void philox4x32(uint64_t key, uint64_t block, uint32_t out[4]) {
+    uint32_t c0 = (uint32_t)block, c1 = (uint32_t)(block >> 32), c2 = 0, c3 = 0;
+    uint32_t k0 = (uint32_t)key, k1 = (uint32_t)(key >> 32);
+    for (int r = 0; r < 10; r++) {
+        uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+// Uniform in [0, 1) from the 24 high bits
+inline float philox_unit(uint32_t x) {
+    return (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+inline void philox_uniform4(uint64_t key, uint64_t block, float u[4]) {
+    uint32_t r[4];
+    philox4x32(key, block, r);
+    for (int k = 0; k < 4; k++) u[k] = philox_unit(r[k]);
+}
+
+class PhiloxStream {
+public:
+    uint64_t key;
+    std::atomic<uint64_t> counter;  // Next unused block
+
+    explicit PhiloxStream(uint64_t seed);
+
+    void seed(uint64_t seed);
+    // Reserves n consecutive blocks and returns the first one
+    uint64_t take(uint64_t n);
+    // A 64-bit number from the stream, to seed other streams
+    uint64_t next_seed();
+};
+
+// Stream used by the random fills and the random data augmentation of the calling thread: the
+// one set with set_random_stream (e.g. the stream of the layer being run) or the default one
+PhiloxStream &random_stream();
+void set_random_stream(PhiloxStream *s);
+
+// Seeds the default stream and the generator behind uniform()
+void set_random_seed(uint64_t seed);
+
+
 #endif //EDDL_RANDOM_H
@@ -21,6 +21,11 @@ namespace tensorNN{
     float categorical_cross_entropy(Tensor* y_true, Tensor* y_pred);
     void d_categorical_cross_entropy(Tensor* y_true, Tensor* y_pred, Tensor* delta);
 
+    // Softmax + categorical cross-entropy, from the logits X and the log-sum-exp of their rows
+    // (see SoftmaxLSE). The delta w.r.t. the logits is softmax - target
+    float softmax_cross_entropy(Tensor* y_true, Tensor* X, Tensor* LSE);
+    void d_softmax_cross_entropy(Tensor* y_true, Tensor* y_pred, Tensor* delta);
+
     float binary_cross_entropy(Tensor* y_true, Tensor* y_pred);
     void d_binary_cross_entropy(Tensor* y_true, Tensor* y_pred, Tensor* delta);
 
@@ -72,11 +77,16 @@ namespace tensorNN{
 // Full Softmax
     void FullSoftmax(Tensor *A, Tensor *B, int axis);
     void D_FullSoftmax(Tensor *D, Tensor *I, Tensor *PD, int axis);
+    // Softmax over the last axis that also keeps the log-sum-exp of each row (CPU)
+    void SoftmaxLSE(Tensor *A, Tensor *B, Tensor *LSE);
 
 // Tanh
     void Tanh(Tensor *A, Tensor *B);
     void D_Tanh(Tensor *D, Tensor *I, Tensor *PD);
 
+// Derivative of a ConvActivation taken from its output O, in place: D = D * f'(O) (CPU)
+    void D_Activation_(Tensor *D, Tensor *O, int act, float param);
+
 //Linear
     void Linear(Tensor *A, Tensor *B, float param);
     void D_Linear(Tensor *D, Tensor *I, Tensor *PD, float param);
@@ -86,6 +96,7 @@ namespace tensorNN{
     void Conv2D(ConvolDescriptor *D);
     void Conv2D_grad(ConvolDescriptor *D);
     void Conv2D_back(ConvolDescriptor *D);
+    void Conv2D_act_back(ConvolDescriptor *D);
 
 // MaxPool
     void MPool2D(PoolDescriptor *D);
@@ -110,6 +121,34 @@ namespace tensorNN{
     void permute_channels_first(Tensor *A,Tensor *B);
     void permute_batch_last(Tensor *A,Tensor *B);
     void permute_batch_first(Tensor *A,Tensor *B);
+    // Native BatchNorm over {N,C} or {N,C,H,W} (channels_last: memory is {N,H,W,C}) (CPU).
+    // bn_g/bn_b (and gbn_g/gbn_b) are nullptr when there is no affine transform
+    void BatchNormForward(Tensor *X, Tensor *Y, Tensor *opa, Tensor *mean, Tensor *variance, Tensor *bn_g, Tensor *bn_b,
+                          Tensor *bn_mean, Tensor *bn_var, bool trmode, float epsilon, float momentum, bool channels_last);
+    void BatchNormBackward(Tensor *D, Tensor *opa, Tensor *PD, Tensor *bn_g, Tensor *bn_var, Tensor *gbn_g, Tensor *gbn_b, bool channels_last);
+    // Native LayerNorm over the mean->size rows of X (CPU). g/b have K entries, each one applied to
+    // L/K consecutive values of a row (K=L for LayerNorm, channels per group for GroupNorm)
+    void LayerNormForward(Tensor *X, Tensor *Y, Tensor *opa, Tensor *mean, Tensor *sd, Tensor *g, Tensor *b, float epsilon);
+    void LayerNormBackward(Tensor *D, Tensor *opa, Tensor *PD, Tensor *sd, Tensor *g, Tensor *gg, Tensor *gb);
+
+// ***** LSTM ********************
+// G holds the gate pre-activations {N, 4*units} (input, forget, output, candidate) and is turned
+// into the activations, then (backward) into their deltas. cprev/hprev/DHprev/DCprev are nullptr
+// for the first step; mask (optional, {N}) flags the all-zero rows of X, which keep the previous state (CPU)
+    void LSTMForward(Tensor *X, Tensor *G, Tensor *bias, Tensor *cprev, Tensor *hprev, Tensor *mask, Tensor *C, Tensor *H, Tensor *TC);
+    void LSTMBackward(Tensor *G, Tensor *TC, Tensor *cprev, Tensor *mask, Tensor *DH, Tensor *DC, Tensor *DHprev, Tensor *DCprev);
+
+// ***** Optimizers ********************
+// Update P in place from its gradient G and the optimizer state (M, V), reading each element once
+    void sgd_step(Tensor *P, Tensor *G, Tensor *M, float lr, float mu, float weight_decay, bool nesterov);
+    void adam_step(Tensor *P, Tensor *G, Tensor *M, Tensor *V, float lr, float beta_1, float beta_2, float epsilon, float weight_decay, bool decoupled, int t);
+    void rmsprop_step(Tensor *P, Tensor *G, Tensor *V, float lr, float rho, float epsilon, float weight_decay);
+    void adagrad_step(Tensor *P, Tensor *G, Tensor *V, float lr, float epsilon, float weight_decay);
+
+    // Row-sparse steps: only the given rows (first axis) of P and its state are updated, the
+    // others keep their moments until they get a gradient again (lazy updates, CPU)
+    void sgd_step_rows(Tensor *P, Tensor *G, Tensor *M, const vector<int> &rows, float lr, float mu, float weight_decay, bool nesterov);
+    void adam_step_rows(Tensor *P, Tensor *G, Tensor *M, Tensor *V, const vector<int> &rows, float lr, float beta_1, float beta_2, float epsilon, float weight_decay, bool decoupled, int t);
 
 }
 
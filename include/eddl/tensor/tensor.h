@@ -389,6 +389,19 @@ public:
      */
     static Tensor* zeros_like(Tensor *A);
 
+    /**
+      *  @brief Move the data of several tensors into a single contiguous tensor.
+      *
+      *  @details
+      *   The tensors keep their shape but become views into the returned tensor, each one starting
+      *   at a multiple of 16 floats (64 bytes) from its beginning. The gaps are filled with zeros.
+      *   The returned tensor owns the memory and must outlive the views.
+      *
+      *  @param tensors  Distinct tensors to pack, all of them in the same device.
+      *  @return     1D tensor with the data of all the tensors, in the given order
+     */
+    static Tensor* pack(const vector<Tensor*> &tensors);
+
     /**
       *  @brief Create a tensor of the specified shape and filled with ones.
       *
@@ -2844,12 +2857,22 @@ public:
     static Tensor* stack(vector<Tensor*> A, unsigned int axis=0, Tensor* output=nullptr);
 
     /**
-      *  @brief Returns an array with the selected indices of the tensor.
+      *  @brief Returns an array with the selected indices of the tensor. The selection is always copied.
       *
       *  @param indices  Vector of strings representing the indices to be selected. These indices must follow a Python-like syntax. Some examples: ``"0"`` , ``":5"`` , ``":"`` , ``"3:6"``.
       *  @return     Tensor
     */
     Tensor* select(const vector<string>& indices);
+
+    /**
+      *  @brief Returns a view of the selected indices, without copying them. The view shares the memory of the tensor, so it must not outlive it.
+      *  Tensors are dense, so only a contiguous block can be viewed, such as a range of the first axis (e.g. a batch of samples out of a dataset).
+      *  Any other selection is rejected: use ``select``, which copies.
+      *
+      *  @param indices  Vector of strings representing the indices to be selected. These indices must follow a Python-like syntax. Some examples: ``"0"`` , ``":5"`` , ``"3:6"``.
+      *  @return     Tensor
+    */
+    Tensor* slice(const vector<string>& indices);
     static void select(Tensor *A, Tensor *B, SelDescriptor *sd);
     static void select_back(Tensor *A, Tensor *B, SelDescriptor *sd);
 
@@ -0,0 +1,225 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_TENSOR_EXPR_H
+#define EDDL_TENSOR_EXPR_H
+
+#include <cmath>
+#include <vector>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
+
+// Lazy element-wise expressions.
+//
+// Chaining the static Tensor ops (add, el_mult, sqrt_, div_...) walks the whole tensor once per
+// op. An expression instead records the chain and evaluates it in a single loop:
+//
+//     using namespace expr;
+//     eval(mT, beta_1 * var(mT) + (1 - beta_1) * var(g));
+//     eval(p, var(p) - lr * var(mT) / (sqrt(var(vT)) + epsilon));
+//
+// All the tensors of an expression must have the same size and live in the same device as
+// the output. The output may also appear in the expression, since every element only reads
+// its own position. CPU tensors are evaluated in one fused loop; other devices fall back to
+// the regular Tensor ops, one op at a time.
+
+namespace expr {
+
+    // Op codes, used by the per-op fallback of non-CPU devices
+    enum {
+        EXPR_NEG, EXPR_ABS, EXPR_SQR, EXPR_SQRT, EXPR_RSQRT, EXPR_EXP, EXPR_LOG, EXPR_TANH, EXPR_SIGMOID,
+        EXPR_ADD, EXPR_SUB, EXPR_MULT, EXPR_DIV, EXPR_MAX, EXPR_MIN
+    };
+
+    // A = op(A)
+    void apply_unary(int op, Tensor *A);
+    // A = A op B
+    void apply_binary(int op, Tensor *A, Tensor *B);
+    // Size and device checks of eval() and sum()
+    void check(Tensor *C, const vector<Tensor*> &leaves, const string &caller);
+
+    template<typename E>
+    struct Expr {
+        const E &self() const { return static_cast<const E&>(*this); }
+    };
+
+    struct Var : public Expr<Var> {
+        Tensor *t;
+        const float *p;
+
+        explicit Var(Tensor *t) : t(t), p(t->ptr) {}
+        float operator()(unsigned long int i) const { return p[i]; }
+        void leaves(vector<Tensor*> &l) const { l.push_back(t); }
+        void materialize(Tensor *out) const { Tensor::copy(t, out); }
+    };
+
+    struct Scalar : public Expr<Scalar> {
+        float v;
+
+        explicit Scalar(float v) : v(v) {}
+        float operator()(unsigned long int i) const { return v; }
+        void leaves(vector<Tensor*> &l) const {}
+        void materialize(Tensor *out) const { out->fill_(v); }
+    };
+
+    template<typename Op, typename A>
+    struct Unary : public Expr<Unary<Op, A>> {
+        A a;
+
+        explicit Unary(const A &a) : a(a) {}
+        float operator()(unsigned long int i) const { return Op::apply(a(i)); }
+        void leaves(vector<Tensor*> &l) const { a.leaves(l); }
+        void materialize(Tensor *out) const {
+            a.materialize(out);
+            apply_unary(Op::id, out);
+        }
+    };
+
+    template<typename Op, typename A, typename B>
+    struct Binary : public Expr<Binary<Op, A, B>> {
+        A a;
+        B b;
+
+        Binary(const A &a, const B &b) : a(a), b(b) {}
+        float operator()(unsigned long int i) const { return Op::apply(a(i), b(i)); }
+        void leaves(vector<Tensor*> &l) const { a.leaves(l); b.leaves(l); }
+        void materialize(Tensor *out) const {
+            a.materialize(out);
+            Tensor *aux = Tensor::empty_like(out);
+            b.materialize(aux);
+            apply_binary(Op::id, out, aux);
+            delete aux;
+        }
+    };
+
+    // Element-wise ops
+    struct OpNeg { enum { id = EXPR_NEG }; static float apply(float x) { return -x; } };
+    struct OpAbs { enum { id = EXPR_ABS }; static float apply(float x) { return std::fabs(x); } };
+    struct OpSqr { enum { id = EXPR_SQR }; static float apply(float x) { return x*x; } };
+    struct OpSqrt { enum { id = EXPR_SQRT }; static float apply(float x) { return std::sqrt(x); } };
+    struct OpRsqrt { enum { id = EXPR_RSQRT }; static float apply(float x) { return 1.0f/std::sqrt(x); } };
+    struct OpExp { enum { id = EXPR_EXP }; static float apply(float x) { return std::exp(x); } };
+    struct OpLog { enum { id = EXPR_LOG }; static float apply(float x) { return std::log(x); } };
+    struct OpTanh { enum { id = EXPR_TANH }; static float apply(float x) { return std::tanh(x); } };
+    struct OpSigmoid { enum { id = EXPR_SIGMOID }; static float apply(float x) { return 1.0f/(1.0f+std::exp(-x)); } };
+
+    struct OpAdd { enum { id = EXPR_ADD }; static float apply(float x, float y) { return x+y; } };
+    struct OpSub { enum { id = EXPR_SUB }; static float apply(float x, float y) { return x-y; } };
+    struct OpMult { enum { id = EXPR_MULT }; static float apply(float x, float y) { return x*y; } };
+    struct OpDiv { enum { id = EXPR_DIV }; static float apply(float x, float y) { return x/y; } };
+    struct OpMax { enum { id = EXPR_MAX }; static float apply(float x, float y) { return (x>y) ? x : y; } };
+    struct OpMin { enum { id = EXPR_MIN }; static float apply(float x, float y) { return (x<y) ? x : y; } };
+
+    /**
+    *   @brief Wraps a tensor as the leaf of an expression. Nothing is computed until eval() or sum()
+    *
+    *   @param t  Tensor
+    *   @return   Expression reading t
+    */
+    inline Var var(Tensor *t) { return Var(t); }
+
+#define EXPR_UNARY(fn, Op) \
+    template<typename A> \
+    Unary<Op, A> fn(const Expr<A> &a) { return Unary<Op, A>(a.self()); }
+
+    EXPR_UNARY(operator-, OpNeg)
+    EXPR_UNARY(abs, OpAbs)
+    EXPR_UNARY(sqr, OpSqr)
+    EXPR_UNARY(sqrt, OpSqrt)
+    EXPR_UNARY(rsqrt, OpRsqrt)
+    EXPR_UNARY(exp, OpExp)
+    EXPR_UNARY(log, OpLog)
+    EXPR_UNARY(tanh, OpTanh)
+    EXPR_UNARY(sigmoid, OpSigmoid)
+
+#undef EXPR_UNARY
+
+#define EXPR_BINARY(fn, Op) \
+    template<typename A, typename B> \
+    Binary<Op, A, B> fn(const Expr<A> &a, const Expr<B> &b) { return Binary<Op, A, B>(a.self(), b.self()); } \
+    template<typename A> \
+    Binary<Op, A, Scalar> fn(const Expr<A> &a, float b) { return Binary<Op, A, Scalar>(a.self(), Scalar(b)); } \
+    template<typename B> \
+    Binary<Op, Scalar, B> fn(float a, const Expr<B> &b) { return Binary<Op, Scalar, B>(Scalar(a), b.self()); }
+
+    EXPR_BINARY(operator+, OpAdd)
+    EXPR_BINARY(operator-, OpSub)
+    EXPR_BINARY(operator*, OpMult)
+    EXPR_BINARY(operator/, OpDiv)
+    EXPR_BINARY(maximum, OpMax)
+    EXPR_BINARY(minimum, OpMin)
+
+#undef EXPR_BINARY
+
+    /**
+    *   @brief Evaluates an expression into C, in a single pass on CPU
+    *
+    *   @param C  Output tensor. It can also be read by the expression
+    *   @param e  Expression
+    */
+    template<typename E>
+    void eval(Tensor *C, const Expr<E> &e) {
+        const E &x = e.self();
+        vector<Tensor*> leaves;
+        x.leaves(leaves);
+        check(C, leaves, "expr::eval");
+
+        if (C->isCPU()) {
+            _profile(_CPU_EXPR, 0);
+            float *out = C->ptr;
+            long int size = C->size;
+            #pragma omp parallel for simd CPU_PARALLEL(size)
+            for (long int i = 0; i < size; i++) out[i] = x(i);
+            _profile(_CPU_EXPR, 1);
+        }
+        else {
+            // The output can be read by the expression, so it is only written at the end
+            Tensor *aux = Tensor::empty_like(C);
+            x.materialize(aux);
+            Tensor::copy(aux, C);
+            delete aux;
+        }
+    }
+
+    /**
+    *   @brief Sum of all the elements of an expression, without storing it on CPU
+    *
+    *   @param e  Expression with at least one tensor
+    *   @return   Sum of the elements
+    */
+    template<typename E>
+    float sum(const Expr<E> &e) {
+        const E &x = e.self();
+        vector<Tensor*> leaves;
+        x.leaves(leaves);
+        if (leaves.empty()) msg("The expression has no tensors", "expr::sum");
+        check(leaves[0], leaves, "expr::sum");
+
+        Tensor *A = leaves[0];
+        if (A->isCPU()) {
+            _profile(_CPU_EXPR, 0);
+            long int size = A->size;
+            double s = 0.0;
+            #pragma omp parallel for simd reduction(+:s) CPU_PARALLEL(size)
+            for (long int i = 0; i < size; i++) s += x(i);
+            _profile(_CPU_EXPR, 1);
+            return (float)s;
+        }
+
+        Tensor *aux = Tensor::empty_like(A);
+        x.materialize(aux);
+        float s = aux->sum();
+        delete aux;
+        return s;
+    }
+
+}
+
+#endif //EDDL_TENSOR_EXPR_H
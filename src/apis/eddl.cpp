@@ -65,6 +65,16 @@ namespace eddl {
         net->setTrainable(lname,val);
     }
 
+    void setConvAlgorithm(model net, const string& algo)
+    {
+        net->setConvAlgorithm(getConvAlgorithm(algo));
+    }
+
+    void setLayout(model net, const string& layout)
+    {
+        net->setLayout(getTensorLayout(layout));
+    }
+
     vector<vtensor> get_parameters(model net, bool deepcopy, bool tocpu){
         return net->get_parameters(deepcopy, tocpu);
     }
@@ -73,7 +83,7 @@ namespace eddl {
         net->set_parameters(params);
     }
 
-    void build(model net, optimizer o, CompServ *cs, bool init_weights){
+    void build(model net, optimizer o, CompServ *cs, bool init_weights, bool flat_params, bool inplace){
         // Assign default computing service
         if (cs== nullptr){
             cs = new CompServ(std::thread::hardware_concurrency(), {}, {});
@@ -82,10 +92,10 @@ namespace eddl {
             o = new SGD(0.001,0.9);
         }
 
-        net->build(o, {}, {}, cs, init_weights);
+        net->build(o, {}, {}, cs, init_weights, flat_params, inplace);
     }
 
-    void build(model net, optimizer o, const vector<string> &lo, const vector<string> &me, CompServ *cs, bool init_weights){
+    void build(model net, optimizer o, const vector<string> &lo, const vector<string> &me, CompServ *cs, bool init_weights, bool flat_params, bool inplace){
         vector<Loss *> l;
         vector<Metric *> m;
 
@@ -112,7 +122,7 @@ namespace eddl {
         }
 
 
-        net->build(o, l, m, cs, init_weights);
+        net->build(o, l, m, cs, init_weights, flat_params, inplace);
     }
 
     // Computing services
@@ -167,13 +177,21 @@ namespace eddl {
     }
 
     compserv CS_CPU(int th,string mem){
-      if (mem=="low_mem") return new CompServ(th, {}, {}, 0, 2);
+      if (mem=="recompute_mem") return new CompServ(th, {}, {}, 0, 3);
+      else if (mem=="low_mem") return new CompServ(th, {}, {}, 0, 2);
       else if (mem=="mid_mem") return new CompServ(th, {}, {}, 0, 1);
       else if (mem=="full_mem") return new CompServ(th, {}, {}, 0, 0);
       else msg("Error mem param","CS_CPU"); // Exits
       return nullptr; // To silent warnings
     }
 
+    compserv CS_CPU(int th, string mem, int grain){
+        if (grain<=0) msg("The grain size must be > 0","CS_CPU");
+        compserv cs=CS_CPU(th, mem);
+        cs->cpu_grain=grain;
+        return cs;
+    }
+
     compserv CS_GPU(const vector<int> g){
         return CS_GPU(g, 1, "full_mem");
     }
@@ -248,12 +266,14 @@ namespace eddl {
     }
 
     optimizer adam(float lr, float beta_1, float beta_2, float epsilon, float weight_decay, bool amsgrad){
-        //Todo: Implement
         return new Adam(lr, beta_1, beta_2, epsilon, weight_decay, amsgrad);
     }
 
+    optimizer adamw(float lr, float beta_1, float beta_2, float epsilon, float weight_decay){
+        return new AdamW(lr, beta_1, beta_2, epsilon, weight_decay);
+    }
+
     optimizer adagrad(float lr, float epsilon, float weight_decay){
-        //Todo: Implement
         return new Adagrad(lr, epsilon, weight_decay);
     }
 
@@ -268,7 +288,6 @@ namespace eddl {
     }
 
     optimizer rmsprop(float lr, float rho, float epsilon, float weight_decay){
-        //Todo: Implement
         return new RMSProp(lr, rho, epsilon, weight_decay);
     }
 
@@ -342,6 +361,15 @@ namespace eddl {
     void set_mode(model net, int mode){
         net->setmode(mode);
     }
+    void set_seed(model net, uint64_t seed){
+        net->set_seed(seed);
+    }
+    void plan_memory(model net, bool enable){
+        net->plan_memory(enable);
+    }
+    void set_checkpoints(model net, vlayer layers){
+        net->set_checkpoints(layers);
+    }
     vlayer forward(model net,vector<Layer*> in)
     {
         net->reset();
@@ -632,8 +660,8 @@ namespace eddl {
     return new LDropout(parent, rate, iw, name, DEV_CPU, 0);
     }
 
-    layer Embedding(layer parent, int vocsize, int length, int output_dim,  bool mask_zeros, string name){
-        return new LEmbedding(parent, vocsize, length, output_dim, mask_zeros, name, DEV_CPU, 0);
+    layer Embedding(layer parent, int vocsize, int length, int output_dim,  bool mask_zeros, string name, bool sparse_grad){
+        return new LEmbedding(parent, vocsize, length, output_dim, mask_zeros, name, DEV_CPU, 0, sparse_grad);
     }
 
     layer Input(const vector<int> &shape, string name){
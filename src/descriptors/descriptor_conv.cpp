@@ -14,6 +14,13 @@
 
 #include "eddl/hardware/cpu/cpu_profile.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Floats per thread of the CPU im2col workspace (1MB, fits in L2)
+#define IM2COL_TILE_SIZE 262144
+
 #ifdef cGPU
 #include "eddl/hardware/gpu/gpu_tensor.h"
 #include "eddl/hardware/gpu/gpu_hw.h"
@@ -25,19 +32,21 @@
 
 ConvolDescriptor::ConvolDescriptor() {}
 
-ConvolDescriptor::ConvolDescriptor(const vector<int> &ks, const vector<int> &st, const vector<int> &p, int mem) {
+ConvolDescriptor::ConvolDescriptor(const vector<int> &ks, const vector<int> &st, const vector<int> &p, int mem, int groups) {
     ksize = vector<int>(ks.begin(), ks.end());
     stride = vector<int>(st.begin(), st.end());
     pad = vector<int>(p.begin(), p.end());
     mem_level=mem;
+    this->groups=groups;
 
     this->padding = "custom";
 
     if (ksize.size() != 3) msg("Kernels must have 3 dimensions", "ConvolDescriptor::ConvolDescriptor");
     if (stride.size() != 2) msg("Strides must have 2 dimensions", "ConvolDescriptor::ConvolDescriptor");
+    if (groups < 1) msg("The number of groups must be positive", "ConvolDescriptor::ConvolDescriptor");
 }
 
-ConvolDescriptor::ConvolDescriptor(int filters, const vector<int> &ks, const vector<int> &st, const string& p, bool ub, int mem) {
+ConvolDescriptor::ConvolDescriptor(int filters, const vector<int> &ks, const vector<int> &st, const string& p, bool ub, int mem, int groups) {
     if (ks.size() != 2) { msg("Kernels must have 3 dimensions", "ConvolDescriptor::ConvolDescriptor"); }
     if (st.size() != 2) { msg("Strides must have 2 dimensions", "ConvolDescriptor::ConvolDescriptor"); }
 
@@ -47,6 +56,9 @@ ConvolDescriptor::ConvolDescriptor(int filters, const vector<int> &ks, const vec
     stride = vector<int>(st.begin(), st.end());
     use_bias=ub;
     mem_level=mem;
+    this->groups=groups;
+
+    if (groups < 1) msg("The number of groups must be positive", "ConvolDescriptor::ConvolDescriptor");
 
     if (p=="same" || p =="none" || p =="valid" || p =="zeros" || p=="same,none" || p=="none,same") {
         this->padding=p;
@@ -59,6 +71,49 @@ ConvolDescriptor::ConvolDescriptor(int filters, const vector<int> &ks, const vec
 
 ConvolDescriptor::~ConvolDescriptor(){
     // input, output, delta, params[], and gradients[], acc_gradients[] => deleted in ~Layer()
+    free_fmem(ptrI);
+    free_fmem(ptrWK);
+    free_fmem(ptrWV);
+    free_fmem(ptrGK);
+}
+
+ConvAlgorithm getConvAlgorithm(const string& algo){
+    if(algo == "auto"){
+        return ConvAlgorithm::ConvAlgoAuto;
+    }else if (algo == "im2col"){
+        return ConvAlgorithm::ConvAlgoIm2col;
+    }else if (algo == "winograd"){
+        return ConvAlgorithm::ConvAlgoWinograd;
+    }else if (algo == "depthwise"){
+        return ConvAlgorithm::ConvAlgoDepthwise;
+    }else{
+        msg("Unknown convolution algorithm (" + algo + "). Use one of: auto, im2col, winograd or depthwise", "getConvAlgorithm");
+    }
+    return ConvAlgorithm::ConvAlgoAuto;  // To silent warnings
+}
+
+TensorLayout getTensorLayout(const string& layout){
+    if(layout == "nchw" || layout == "channels_first"){
+        return TensorLayout::LayoutNCHW;
+    }else if (layout == "nhwc" || layout == "channels_last"){
+        return TensorLayout::LayoutNHWC;
+    }else{
+        msg("Unknown layout (" + layout + "). Use one of: nchw (channels_first) or nhwc (channels_last)", "getTensorLayout");
+    }
+    return TensorLayout::LayoutNCHW;  // To silent warnings
+}
+
+ConvActivation getConvActivation(const string& act){
+    if(act == "relu"){
+        return ConvActivation::ConvActReLU;
+    }else if (act == "leaky_relu"){
+        return ConvActivation::ConvActLeakyReLU;
+    }else if (act == "sigmoid"){
+        return ConvActivation::ConvActSigmoid;
+    }else if (act == "tanh"){
+        return ConvActivation::ConvActTanh;
+    }
+    return ConvActivation::ConvActNone;  // Not fusable
 }
 
 void ConvolDescriptor::build(Tensor *A) {
@@ -70,7 +125,12 @@ void ConvolDescriptor::build(Tensor *A) {
     nk = ksize[0];
     kr = ksize[1];
     kc = ksize[2];
-    kz = A->shape[1];
+
+    if ((A->shape[1] % groups) || (nk % groups)) {
+        msg("Input channels (" + to_string(A->shape[1]) + ") and filters (" + to_string(nk) + ") must be divisible by the number of groups (" + to_string(groups) + ")", "ConvolDescriptor::build");
+    }
+    if ((groups > 1) && (!A->isCPU())) msg("Grouped convolutions are only available on CPU", "ConvolDescriptor::build");
+    kz = A->shape[1] / groups;
 
     sr = stride[0];
     sc = stride[1];
@@ -116,6 +176,8 @@ void ConvolDescriptor::build(Tensor *A) {
         msg("Invalid output shape", "ConvolDescriptor::build");
     }
 
+    select_algorithm();
+
     O = new Tensor(vector<int>{A->shape[0], z, r, c}, A->device);
 //    if (!mem_level) { D = new Tensor(O->shape, A->device); }
 
@@ -128,9 +190,7 @@ void ConvolDescriptor::build(Tensor *A) {
 
     if (I->isCPU()) {
         // mem for ptr, lowering im2col
-        ptrI=get_fmem(A->shape[0] * r * c * kr * kc * kz,"ConvolDescriptor::build");
-	 _profile_add_tensor(A->shape[0] * r * c * kr * kc * kz);
-	 matI=Eigen::Map<Eigen::MatrixXf>(ptrI, r*c,kz*kr*kc);
+        alloc_lowering(A->shape[0]);
   	 //matK=Eigen::Map<Eigen::MatrixXf>(K->ptr, kr * kc * kz, nk);
          //matgK=Eigen::Map<Eigen::MatrixXf>(gK->ptr, kr * kc * kz, nk);
         // convolution: matC=matA*matK
@@ -193,9 +253,8 @@ void ConvolDescriptor::resize(int b)
     unsigned long int l_size =  (unsigned long)(b * r * c) * (unsigned long)(kr * kc * kz);
 
     if (I->isCPU()) {
-        delete[] ptrI;
-        ptrI=get_fmem(l_size, "ConvolDescriptor::build");
-	 _profile_add_tensor(l_size);
+        // The workspace does not depend on the batch size
+        if (mem_level == 0) alloc_lowering(b);
     }
 #ifdef cGPU
     else if (I->isGPU()) {
@@ -215,7 +274,7 @@ void ConvolDescriptor::resize(int b)
 	fpga_sizeI = l_size * sizeof(float);
         fpga_ptrI = fpga_create_memory(fpga_sizeI);
         // We do the same on the CPU side (for smooth cpuemu)
-	delete[] ptrI;
+	free_fmem(ptrI);
         ptrI=get_fmem(l_size, "ConvolDescriptor::build");
     }
 #endif
@@ -223,6 +282,49 @@ void ConvolDescriptor::resize(int b)
 
 }
 
+void ConvolDescriptor::alloc_lowering(int b) {
+    // The lowered input holds the columns of every group
+    unsigned long int ncols = (unsigned long)(kr * kc * iz);
+    unsigned long int l_size;
+
+    free_fmem(ptrI);
+    ptrI = nullptr;
+
+    if (algo == ConvAlgoDepthwise) {
+        // The direct kernel reads the input maps, there is nothing to lower
+        ws_threads = 0;
+        ws_rows = r * c;
+        return;
+    }
+
+    if (mem_level > 0) {
+        // Workspace: one tile of "ws_rows" output pixels per thread, reused across samples and tiles
+#ifdef _OPENMP
+        ws_threads = omp_get_max_threads();
+#else
+        ws_threads = 1;
+#endif
+        ws_rows = std::max(1, std::min(r * c, (int)(IM2COL_TILE_SIZE / ncols)));
+        l_size = (unsigned long)(ws_threads * ws_rows) * ncols;
+    }
+    else {
+        // Whole batch lowering, shared by the forward and the gradient passes
+        ws_threads = 0;
+        ws_rows = r * c;
+        l_size = (unsigned long)(b * r * c) * ncols;
+    }
+
+    ptrI=get_fmem(l_size, "ConvolDescriptor::alloc_lowering");
+    _profile_add_tensor(l_size);
+}
+
+void ConvolDescriptor::set_mem_level(int mem) {
+    if (mem == mem_level) return;
+
+    mem_level = mem;
+    if ((I != nullptr) && (I->isCPU())) alloc_lowering(O->shape[0]);
+}
+
 void ConvolDescriptor::enable_distributed() {
     // Create and initialize the tensors for accumulating gradients in distributed training
     acc_gK = new Tensor(vector<int>{nk, kz, kr, kc}, I->device);
@@ -231,6 +333,57 @@ void ConvolDescriptor::enable_distributed() {
     acc_gbias->fill_(0.0);
 }
 
+bool ConvolDescriptor::winograd_compatible() {
+    // 3x3 stride 1 kernels. The backward pass is computed as a "full" convolution of
+    // the delta, so the padding must not exceed the kernel border (kr-1 / kc-1)
+    return (groups == 1) && (kr == 3) && (kc == 3) && (sr == 1) && (sc == 1) && (padrt <= 2) && (padcl <= 2);
+}
+
+void ConvolDescriptor::select_algorithm() {
+    algo = ConvAlgoIm2col;
+
+    if (groups > 1) {
+        // Depthwise convolutions do a few MACs per output, so lowering them would only move memory
+        if ((kz == 1) && (algorithm != ConvAlgoIm2col)) algo = ConvAlgoDepthwise;
+    }
+    // The Winograd transforms only read/write channels-first maps
+    else if ((layout_in != LayoutNCHW) || (layout_out != LayoutNCHW)) {}
+    else if (algorithm == ConvAlgoWinograd) {
+        if (winograd_compatible()) algo = ConvAlgoWinograd;
+    }
+    else if (algorithm == ConvAlgoAuto) {
+        // The input/output transforms do not pay off for very thin layers
+        if (winograd_compatible() && (kz >= 8) && (nk >= 8)) algo = ConvAlgoWinograd;
+    }
+
+    // Bigger tiles save more multiplications but are less accurate and waste work on small maps
+    wino_m = ((r >= 16) && (c >= 16)) ? 4 : 2;
+
+    if (ptrWK != nullptr) {
+        free_fmem(ptrWK);
+        ptrWK = nullptr;
+    }
+}
+
+void ConvolDescriptor::set_algorithm(int a) {
+    if ((a < ConvAlgoAuto) || (a > ConvAlgoDepthwise)) msg("Unknown convolution algorithm", "ConvolDescriptor::set_algorithm");
+    algorithm = a;
+    if (I != nullptr) {
+        select_algorithm();
+        // Switching from/to the depthwise kernel changes the lowering needs
+        if (I->isCPU()) alloc_lowering(O->shape[0]);
+    }
+}
+
+void ConvolDescriptor::set_layout(int in, int out) {
+    if ((in != LayoutNCHW) || (out != LayoutNCHW)) {
+        if ((I != nullptr) && (!I->isCPU())) msg("Channels-last layout is only available on CPU", "ConvolDescriptor::set_layout");
+    }
+    layout_in = in;
+    layout_out = out;
+    if (I != nullptr) select_algorithm();
+}
+
 int ConvolDescriptor::compute_output(const string& padding, int input_size, int kerkel_size, int stride, int dilation_rate){
     if (padding=="same" || padding =="zeros") {
         return std::ceil((float)input_size/(float)stride);
@@ -17,13 +17,16 @@ PermuteDescriptor::PermuteDescriptor(const vector<int>& dims, int dev) : SelDesc
 }
 
 
-void PermuteDescriptor::build(vector<int> ishape){
+void PermuteDescriptor::build_layout(const vector<int>& ishape){
     // Get input/output shapes
     this->ishape = ishape;
     this->oshape = permute_shape(ishape, this->dims);
 
-    // Build indices
-    this->build_indices();
+    // Output axis d walks the input axis dims[d]
+    vector<int> istride = shape2stride(ishape);
+    vector<int> pstride;
+    for(auto &d : this->dims) pstride.push_back(istride[d]);
+    this->build_runs(this->oshape, pstride, 0);
 }
 
 void PermuteDescriptor::resize(int b){
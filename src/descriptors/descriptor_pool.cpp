@@ -45,6 +45,8 @@ PoolDescriptor::PoolDescriptor(const vector<int> &ks, const vector<int> &st, con
 PoolDescriptor::~PoolDescriptor(){
     delete indX;
     delete indY;
+    delete[] arg8;
+    delete[] arg32;
 }
 
 void PoolDescriptor::build(Tensor *A) {
@@ -100,6 +102,15 @@ void PoolDescriptor::build(Tensor *A) {
         for(int j=-padcl;j<=ic+padcr-kc;j+=sc,size++) {}
 }
 
+void PoolDescriptor::alloc_argmax() {
+    delete[] arg8; arg8 = nullptr;
+    delete[] arg32; arg32 = nullptr;
+
+    arg_size = O->size;
+    if (kr * kc <= POOL_ARGMAX8_SIZE) arg8 = new unsigned char[arg_size];
+    else arg32 = new int[arg_size];
+}
+
 void PoolDescriptor::resize(int b) {
   if (b == O->shape[0]) return;
 
@@ -93,50 +93,8 @@ ReduceDescriptor::~ReduceDescriptor(){
 }
 
 void ReduceDescriptor::build_index() {
-  // indexes
-  // get indexes for reduction
-  index.clear();
-
-  vector<int> ind;
-  ind.push_back(0);
-  for(int i=0;i<I->ndim;i++) {
-      // Check if "this" dimension is going to be reduced
-      bool isFound = find(axis.begin(), axis.end(), i) != axis.end();
-      if (!isFound) {  // Dims to not be reduced...
-          int s=ind.size();
-          for(int j=0;j<s;j++){
-              for(int k=0; k<I->shape[i]-1; k++){
-                  ind.push_back(ind[j]+(k+1)*I->stride[i]);
-              }
-          }
-      }
-  }
-
-  sort(ind.begin(), ind.end());
-
-  // reduce through axis to be reduced
-  float max,sum;
-  int imax;
-  for(int i=0;i<ind.size();i++){
-      // get axis to be reduced
-      index.push_back(vector<int>());
-
-      index[i].push_back(ind[i]);
-      for(int l=0;l<I->ndim;l++) {
-          // Check if "this" dimension is going to be reduced
-          bool isFound = find(axis.begin(), axis.end(), l) != axis.end();
-          if (isFound) {  // Dims to be reduced...
-              int s=index[i].size();
-              for(int j=0;j<s;j++){
-                  for(int k=0;k<I->shape[l]-1;k++){
-                      index[i].push_back(index[i][j]+(k+1)*I->stride[l]);
-                  }
-              }
-          }
-      }
-
-    }
-    //////
+  rs.build(I->shape, axis);
+  red_size=rs.nred;
 }
 
 
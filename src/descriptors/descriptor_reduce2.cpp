@@ -38,54 +38,6 @@ void ReduceDescriptor2::compute_output(){
     }
 }
 
-void ReduceDescriptor2::build_indices() {
-    vector<int> istride = shape2stride(this->ishape);
-
-    // indexes
-    // get indexes for reduction
-    index.clear();
-
-    vector<int> ind;
-    ind.push_back(0);
-    for(int i=0; i<this->ishape.size(); i++) {
-        // Check if "this" dimension is going to be reduced
-        bool isFound = find(axis.begin(), axis.end(), i) != axis.end();
-        if (!isFound) {  // Dims to not be reduced...
-            int s=ind.size();
-            for(int j=0;j<s;j++){
-                for(int k=0; k<this->ishape[i]-1; k++){
-                    ind.push_back(ind[j]+(k+1)*istride[i]);
-                }
-            }
-        }
-    }
-
-    sort(ind.begin(), ind.end());
-
-    // reduce through axis to be reduced
-    float max,sum;
-    int imax;
-    for(int i=0;i<ind.size();i++){
-        // get axis to be reduced
-        index.push_back(vector<int>());
-
-        index[i].push_back(ind[i]);
-        for(int l=0;l<this->ishape.size();l++) {
-            // Check if "this" dimension is going to be reduced
-            bool isFound = find(axis.begin(), axis.end(), l) != axis.end();
-            if (isFound) {  // Dims to be reduced...
-                int s=index[i].size();
-                for(int j=0;j<s;j++){
-                    for(int k=0;k<this->ishape[l]-1;k++){
-                        index[i].push_back(index[i][j]+(k+1)*istride[l]);
-                    }
-                }
-            }
-        }
-
-    }
-}
-
 void ReduceDescriptor2::build(const vector<int>& t_ishape){
     this->ishape = vector<int>(t_ishape);
 
@@ -104,8 +56,8 @@ void ReduceDescriptor2::build(const vector<int>& t_ishape){
     // Compute output dimension
     compute_output();
 
-    // Compute indices to reduce
-    build_indices();
+    // Strided loops of the reduction
+    this->rs.build(this->ishape, this->axis);
 
     // Compute size reduction
     this->size_reduction = (int)shape2size(this->ishape)/shape2size(this->oshape);
@@ -130,17 +82,13 @@ void ReduceDescriptor2::build_map(bool reverse){
 
     if (!reverse){ // Non-contiguous addresses to reduce.
         #pragma omp parallel for
-        for(int i=0; i<index.size(); i++) {  // Reduce index
-            for(int j=0; j<index[i].size(); j++){  // Addresses to reduce
-                cpu_addresses[index[i][j]] = i;  // A[Original address to reduce] = reduction address
-            }
-        }
-    }else{ // Contiguous addresses to reduce.
-        int k=0;
-        for(int i=0; i<index.size(); i++) {  // Reduce index
-            for(int j=0; j<index[i].size(); j++){  // Addresses to reduce
-                cpu_addresses[k++] = index[i][j];  // A[0,1,2...] = [Original address to reduce]
+        for(int i=0; i<rs.nout; i++) {  // Reduce index
+            int b = rs.base(i);
+            for(int m=0; m<rs.nred; m++){  // Addresses to reduce
+                cpu_addresses[b + rs.offset(m)] = i;  // A[Original address to reduce] = reduction address
             }
         }
+    }else{ // Contiguous addresses to reduce: A[0,1,2...] = [Original address to reduce]
+        rs.addresses(cpu_addresses);
     }
-}
\ No newline at end of file
+}
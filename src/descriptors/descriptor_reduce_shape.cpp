@@ -0,0 +1,98 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+
+#include "eddl/descriptors/tensor_descriptors.h"
+#include "eddl/utils.h"
+#include <algorithm>
+
+
+ReduceShape::ReduceShape() {
+    this->nout = 1;
+    this->nred = 1;
+}
+
+void ReduceShape::build(const vector<int>& ishape, const vector<int>& axis){
+    vector<int> istride = shape2stride(ishape);
+
+    kshape.clear(); kstride.clear();
+    rshape.clear(); rstride.clear();
+    raxes.clear(); raxes_stride.clear();
+    nout = 1;
+    nred = 1;
+
+    int last = -1;  // Kind of the previous axis (0=kept, 1=reduced), size-1 axes excluded
+    for(int i=0; i<ishape.size(); i++) {
+        int reduced = find(axis.begin(), axis.end(), i) != axis.end();
+        if (reduced) {
+            raxes.push_back(ishape[i]);
+            raxes_stride.push_back(istride[i]);
+            nred *= ishape[i];
+        } else {
+            nout *= ishape[i];
+        }
+        if (ishape[i] == 1) continue;
+
+        // Row-major: an axis next to another one of the same kind merges with it
+        vector<int> &s = reduced ? rshape : kshape;
+        vector<int> &st = reduced ? rstride : kstride;
+        if (last == reduced) {
+            s.back() *= ishape[i];
+            st.back() = istride[i];
+        } else {
+            s.push_back(ishape[i]);
+            st.push_back(istride[i]);
+        }
+        last = reduced;
+    }
+}
+
+int ReduceShape::base(int i) const {
+    int b = 0;
+    for(int d=(int)kshape.size()-1; d>=0; d--) {
+        b += (i % kshape[d]) * kstride[d];
+        i /= kshape[d];
+    }
+    return b;
+}
+
+int ReduceShape::offset(int m) const {
+    int o = 0;
+    for(int d=(int)rshape.size()-1; d>=0; d--) {
+        o += (m % rshape[d]) * rstride[d];
+        m /= rshape[d];
+    }
+    return o;
+}
+
+int ReduceShape::position(int m) const {
+    int p = 0, w = nred;
+    for(int k=(int)raxes.size()-1; k>=0; k--) {
+        w /= raxes[k];
+        p += (m % raxes[k]) * w;
+        m /= raxes[k];
+    }
+    return p;
+}
+
+void ReduceShape::addresses(int *ind) const {
+    #pragma omp parallel for
+    for(int i=0; i<nout; i++) {
+        int b = base(i);
+        int *o = ind + (long int)i*nred;
+        for(int q=0; q<nred; q++) {
+            int a = b, r = q;
+            for(int k=0; k<raxes.size(); k++) {
+                a += (r % raxes[k]) * raxes_stride[k];
+                r /= raxes[k];
+            }
+            o[q] = a;
+        }
+    }
+}
@@ -12,14 +12,23 @@
 #include "eddl/utils.h"
 
 SelDescriptor::SelDescriptor(int dev) : TensorDescriptor(dev) {
-
+    this->offset = 0;
+    this->run = 1;
+    this->nruns = 1;
 }
 
-SelDescriptor::SelDescriptor(const vector<string>& indices, int dev) : TensorDescriptor(dev) {
+SelDescriptor::SelDescriptor(const vector<string>& indices, int dev) : SelDescriptor(dev) {
     this->indices = vector<string>(indices);
 }
 
 void SelDescriptor::build(vector<int> ishape){
+    this->build_layout(ishape);
+
+    // Build indices
+    this->build_indices();
+}
+
+void SelDescriptor::build_layout(const vector<int>& ishape){
     // Compute ranges
     this->idxs_range = parse_indices(this->indices, ishape);
 
@@ -27,8 +36,48 @@ void SelDescriptor::build(vector<int> ishape){
     this->ishape = ishape;
     this->oshape = indices2shape(this->idxs_range);
 
-    // Build indices
-    this->build_indices();
+    // Each output axis walks its input axis, starting at the first index of its range
+    vector<int> istride = shape2stride(ishape);
+    int off = 0;
+    for(int d=0; d<ishape.size(); d++) off += this->idxs_range[d][0] * istride[d];
+    this->build_runs(this->oshape, istride, off);
+}
+
+void SelDescriptor::build_runs(const vector<int>& shape, const vector<int>& stride, int offset){
+    this->offset = offset;
+    vshape.clear(); vstride.clear();
+
+    // Row-major: an axis merges with the previous one when they are contiguous in the input
+    for(int d=0; d<shape.size(); d++) {
+        if (shape[d] == 1) continue;
+        if (!vshape.empty() && vstride.back() == shape[d] * stride[d]) {
+            vshape.back() *= shape[d];
+            vstride.back() = stride[d];
+        } else {
+            vshape.push_back(shape[d]);
+            vstride.push_back(stride[d]);
+        }
+    }
+
+    // The innermost axis is copied as a whole when it is contiguous
+    this->run = 1;
+    if (!vshape.empty() && vstride.back() == 1) {
+        this->run = vshape.back();
+        vshape.pop_back();
+        vstride.pop_back();
+    }
+
+    this->nruns = 1;
+    for(auto s : vshape) this->nruns *= s;
+}
+
+int SelDescriptor::base(int r) const {
+    int b = offset;
+    for(int d=(int)vshape.size()-1; d>=0; d--) {
+        b += (r % vshape[d]) * vstride[d];
+        r /= vshape[d];
+    }
+    return b;
 }
 
 void SelDescriptor::resize(int b){
@@ -52,3 +101,7 @@ void SelDescriptor::build_indices(){
     // Compute index translation (output=>input)
     this->cpu_addresses = ranges2indices(this->ishape, this->idxs_range);
 }
+
+bool SelDescriptor::is_identity() const {
+    return (nruns == 1) && (offset == 0) && (run == shape2size(ishape));
+}
@@ -18,7 +18,7 @@ bool cpu_all(Tensor *A){
 
     _profile(_CPU_ALL, 0);
 
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         if (A->ptr[i] != 1.0f){
             #pragma omp critical
@@ -40,7 +40,7 @@ bool cpu_any(Tensor *A){
     _profile(_CPU_ANY, 0);
 
 
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         if (A->ptr[i] == 1.0f){
             #pragma omp critical
@@ -59,7 +59,7 @@ bool cpu_any(Tensor *A){
 // CPU: Logic functions: Comparisons
 void cpu_isfinite(Tensor *A, Tensor* B){
     _profile(_CPU_ISFINITE, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = std::isfinite(A->ptr[i]);
     }
@@ -68,7 +68,7 @@ void cpu_isfinite(Tensor *A, Tensor* B){
 
 void cpu_isinf(Tensor *A, Tensor* B){
     _profile(_CPU_ISINF, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = std::isinf(A->ptr[i]);
     }
@@ -77,7 +77,7 @@ void cpu_isinf(Tensor *A, Tensor* B){
 
 void cpu_isnan(Tensor *A, Tensor* B){
     _profile(_CPU_ISNAN, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = std::isnan(A->ptr[i]);
     }
@@ -87,7 +87,7 @@ void cpu_isnan(Tensor *A, Tensor* B){
 
 void cpu_isneginf(Tensor *A, Tensor* B){
     _profile(_CPU_ISNEGINF, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = std::isinf(A->ptr[i]) && A->ptr[i] < 0.0f;
     }
@@ -96,7 +96,7 @@ void cpu_isneginf(Tensor *A, Tensor* B){
 
 void cpu_isposinf(Tensor *A, Tensor* B){
     _profile(_CPU_ISPOSINF, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = std::isinf(A->ptr[i]) && A->ptr[i] > 0.0f;
     }
@@ -107,7 +107,7 @@ void cpu_isposinf(Tensor *A, Tensor* B){
 // CPU: Logic functions: Comparisons
 void cpu_logical_and(Tensor *A, Tensor *B, Tensor *C){
     _profile(_CPU_LOGICAL_AND, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         C->ptr[i] = (bool)A->ptr[i] & (bool)B->ptr[i];
     }
@@ -116,7 +116,7 @@ void cpu_logical_and(Tensor *A, Tensor *B, Tensor *C){
 
 void cpu_logical_or(Tensor *A, Tensor *B, Tensor *C){
     _profile(_CPU_LOGICAL_OR, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         C->ptr[i] = (bool)A->ptr[i] | (bool)B->ptr[i];
     }
@@ -125,7 +125,7 @@ void cpu_logical_or(Tensor *A, Tensor *B, Tensor *C){
 
 void cpu_logical_not(Tensor *A, Tensor *B){
     _profile(_CPU_LOGICAL_NOT, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = !((bool)A->ptr[i]);  // why not use "~"
     }
@@ -134,7 +134,7 @@ void cpu_logical_not(Tensor *A, Tensor *B){
 
 void cpu_logical_xor(Tensor *A, Tensor *B, Tensor *C){
     _profile(_CPU_LOGICAL_XOR, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         C->ptr[i] = (bool)A->ptr[i] ^ (bool)B->ptr[i];
     }
@@ -149,7 +149,7 @@ bool cpu_allclose(Tensor *A, Tensor *B, float rtol, float atol, bool equal_nan){
     int first_idx = -1;
 
     _profile(_CPU_ALLCLOSE, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         bool close = ::fabsf(A->ptr[i] - B->ptr[i]) <= (atol + rtol * ::fabsf(B->ptr[i]));
         if (!close){
@@ -179,7 +179,7 @@ bool cpu_allclose(Tensor *A, Tensor *B, float rtol, float atol, bool equal_nan){
 
 void cpu_isclose(Tensor *A, Tensor *B, Tensor *C, float rtol, float atol, bool equal_nan){
     _profile(_CPU_ISCLOSE, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         C->ptr[i] = ::fabsf(A->ptr[i] - B->ptr[i]) <= (atol + rtol * ::fabsf(B->ptr[i]));
     }
@@ -188,7 +188,7 @@ void cpu_isclose(Tensor *A, Tensor *B, Tensor *C, float rtol, float atol, bool e
 
 
 void cpu_greater(Tensor *A, Tensor *B, float v){
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = A->ptr[i] > v;
     }
@@ -197,7 +197,7 @@ void cpu_greater(Tensor *A, Tensor *B, float v){
 void cpu_greater(Tensor *A, Tensor *B, Tensor *C){
     _profile(_CPU_GREATER, 0);
 
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         C->ptr[i] = A->ptr[i] > B->ptr[i];
     }
@@ -206,7 +206,7 @@ void cpu_greater(Tensor *A, Tensor *B, Tensor *C){
 
 
 void cpu_greater_equal(Tensor *A, Tensor *B, float v){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = A->ptr[i] >= v;
     }
@@ -215,7 +215,7 @@ void cpu_greater_equal(Tensor *A, Tensor *B, float v){
 void cpu_greater_equal(Tensor *A, Tensor *B, Tensor *C){
     _profile(_CPU_GREATER_EQUAL, 0);
 
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         C->ptr[i] = A->ptr[i] >= B->ptr[i];
     }
@@ -223,7 +223,7 @@ void cpu_greater_equal(Tensor *A, Tensor *B, Tensor *C){
 }
 
 void cpu_less(Tensor *A, Tensor *B, float v){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = A->ptr[i] < v;
     }
@@ -232,7 +232,7 @@ void cpu_less(Tensor *A, Tensor *B, float v){
 void cpu_less(Tensor *A, Tensor *B, Tensor *C){
     _profile(_CPU_LESS, 0);
 
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         C->ptr[i] = A->ptr[i] < B->ptr[i];
     }
@@ -240,7 +240,7 @@ void cpu_less(Tensor *A, Tensor *B, Tensor *C){
 }
 
 void cpu_less_equal(Tensor *A, Tensor *B, float v){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = A->ptr[i] <= v;
     }
@@ -248,7 +248,7 @@ void cpu_less_equal(Tensor *A, Tensor *B, float v){
 
 void cpu_less_equal(Tensor *A, Tensor *B, Tensor *C){
     _profile(_CPU_LESS_EQUAL, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         C->ptr[i] = A->ptr[i] <= B->ptr[i];
     }
@@ -256,7 +256,7 @@ void cpu_less_equal(Tensor *A, Tensor *B, Tensor *C){
 }
 
 void cpu_equal(Tensor *A, Tensor *B, float v){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = A->ptr[i] == v;
     }
@@ -264,7 +264,7 @@ void cpu_equal(Tensor *A, Tensor *B, float v){
 
 void cpu_equal(Tensor *A, Tensor *B, Tensor *C){
     _profile(_CPU_EQUAL, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         C->ptr[i] = A->ptr[i] == B->ptr[i];
     }
@@ -272,7 +272,7 @@ void cpu_equal(Tensor *A, Tensor *B, Tensor *C){
 }
 
 void cpu_not_equal(Tensor *A, Tensor *B, float v){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         B->ptr[i] = A->ptr[i] != v;
     }
@@ -280,7 +280,7 @@ void cpu_not_equal(Tensor *A, Tensor *B, float v){
 
 void cpu_not_equal(Tensor *A, Tensor *B, Tensor *C){
     _profile(_CPU_NOT_EQUAL, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         C->ptr[i] = A->ptr[i] != B->ptr[i];
     }
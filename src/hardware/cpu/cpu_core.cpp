@@ -11,10 +11,23 @@
 #include "eddl/profiling.h"
 #include <algorithm>
 #include <numeric>
+#include <omp.h>
 
 int num_instances[_NUM_CPU_FUNCS];
 float mb_memory_needed;
 
+long int cpu_grain = CPU_GRAIN_DEFAULT;
+
+void cpu_set_grain(long int grain) {
+    if (grain <= 0) msg("The grain size must be > 0", "cpu_set_grain");
+    cpu_grain = grain;
+}
+
+int cpu_threads(long int work) {
+    long int n = std::min((long int)omp_get_max_threads(), work / cpu_grain);
+    return (n > 1) ? (int)n : 1;
+}
+
 void _profile_funcname(int i, char *name) {
   switch(i) {
 case _CPU_ALL             : strcpy(name, "all"); break; 
@@ -155,6 +168,23 @@ case _CPU_IM2COL                 : strcpy(name, "im2col"); break;
 case _CPU_CONV2D                 : strcpy(name, "conv2d"); break;
 case _CPU_CONV2D_GRAD            : strcpy(name, "conv2d_grad"); break;
 case _CPU_CONV2D_BACK            : strcpy(name, "conv2d_back"); break;
+case _CPU_WINOGRAD               : strcpy(name, "winograd"); break;
+case _CPU_CONV2D_ACT_BACK        : strcpy(name, "conv2D_act_back"); break;
+case _CPU_DEPTHWISE              : strcpy(name, "depthwise"); break;
+case _CPU_EXPR                   : strcpy(name, "expr"); break;
+case _CPU_SGD                    : strcpy(name, "sgd"); break;
+case _CPU_ADAM                   : strcpy(name, "adam"); break;
+case _CPU_RMSPROP                : strcpy(name, "rmsprop"); break;
+case _CPU_ADAGRAD                : strcpy(name, "adagrad"); break;
+case _CPU_BATCHNORM_FORWARD      : strcpy(name, "batchnorm_forward"); break;
+case _CPU_BATCHNORM_BACKWARD     : strcpy(name, "batchnorm_backward"); break;
+case _CPU_LAYERNORM_FORWARD      : strcpy(name, "layernorm_forward"); break;
+case _CPU_LAYERNORM_BACKWARD     : strcpy(name, "layernorm_backward"); break;
+case _CPU_LSTM_FORWARD           : strcpy(name, "lstm_forward"); break;
+case _CPU_LSTM_BACKWARD          : strcpy(name, "lstm_backward"); break;
+case _CPU_SGD_ROWS               : strcpy(name, "sgd_rows"); break;
+case _CPU_ADAM_ROWS              : strcpy(name, "adam_rows"); break;
+case _CPU_D_ACTIVATION_INPLACE   : strcpy(name, "d_activation_inplace"); break;
 case _CPU_CENT                   : strcpy(name, "cent"); break;
 case _CPU_ACCURACY               : strcpy(name, "accuracy"); break;
 case _CPU_MPOOL2D               : strcpy(name, "mpool2d"); break;
@@ -207,7 +237,7 @@ void _profile_remove_tensor(unsigned long int size) {
 
 void cpu_transpose(Tensor * A, Tensor * B) {
     _profile(_CPU_TRANSPOSE, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++){
         B->ptr[i] = A->ptr[i];
     }
@@ -216,7 +246,7 @@ void cpu_transpose(Tensor * A, Tensor * B) {
 
 void cpu_copy(Tensor * A, Tensor * B){
     _profile(_CPU_COPY, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++){
         B->ptr[i] = A->ptr[i];
     }
@@ -225,7 +255,7 @@ void cpu_copy(Tensor * A, Tensor * B){
 
 void cpu_fill_(Tensor *A, float v){
     _profile(_CPU_FILL_, 0);
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         A->ptr[i] = v;
     }
@@ -243,7 +273,7 @@ void cpu_fill(Tensor * A, int aini, int aend, Tensor * B, int bini, int bend, in
     for (int i = 2; i < A->ndim; i++)
         t *= A->shape[i];
 
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->shape[0]; i++) {
         int ap = (i * at) + (aini * t);
         int bp = (i * bt) + (bini * t);
@@ -258,37 +288,79 @@ void cpu_fill(Tensor * A, int aini, int aend, Tensor * B, int bini, int bend, in
 }
 
 
+// Selections whose innermost axis is contiguous in the input (see SelDescriptor::build_runs)
+// move whole runs instead of looking up every address
 void cpu_select(Tensor *A, Tensor *B, SelDescriptor *sd){
     _profile(_CPU_SELECT, 0);
-    #pragma omp parallel for
-    for (int i = 0; i < B->size; i++) {
-        B->ptr[i] = A->ptr[sd->cpu_addresses[i]];
+    if (sd->run > 1) {
+        int run = sd->run;
+        #pragma omp parallel for CPU_PARALLEL(B->size)
+        for (int r = 0; r < sd->nruns; r++) {
+            float *pa = A->ptr + sd->base(r);
+            float *pb = B->ptr + (long int)r * run;
+            for (int i = 0; i < run; i++) pb[i] = pa[i];
+        }
+    } else {
+        #pragma omp parallel for CPU_PARALLEL(B->size)
+        for (int i = 0; i < B->size; i++) {
+            B->ptr[i] = A->ptr[sd->cpu_addresses[i]];
+        }
     }
     _profile(_CPU_SELECT, 1);
 }
 
 void cpu_select_back(Tensor *A, Tensor *B, SelDescriptor *sd){
     _profile(_CPU_SELECT_BACK, 0);
-    #pragma omp parallel for
-    for (int i = 0; i < A->size; i++) {  // walk stride
-        B->ptr[sd->cpu_addresses[i]] += A->ptr[i];  // delta_parent += delta
+    if (sd->run > 1) {
+        int run = sd->run;
+        #pragma omp parallel for CPU_PARALLEL(A->size)
+        for (int r = 0; r < sd->nruns; r++) {
+            float *pa = A->ptr + (long int)r * run;
+            float *pb = B->ptr + sd->base(r);
+            for (int i = 0; i < run; i++) pb[i] += pa[i];  // delta_parent += delta
+        }
+    } else {
+        #pragma omp parallel for CPU_PARALLEL(A->size)
+        for (int i = 0; i < A->size; i++) {  // walk stride
+            B->ptr[sd->cpu_addresses[i]] += A->ptr[i];  // delta_parent += delta
+        }
     }
     _profile(_CPU_SELECT_BACK, 1);
 }
 
 void cpu_set_select(Tensor *A, Tensor *B, SelDescriptor *sd){
     _profile(_CPU_SET_SELECT, 0);
-    #pragma omp parallel for
-    for (int i = 0; i < B->size; i++) {
-        A->ptr[sd->cpu_addresses[i]] = B->ptr[i];
+    if (sd->run > 1) {
+        int run = sd->run;
+        #pragma omp parallel for CPU_PARALLEL(B->size)
+        for (int r = 0; r < sd->nruns; r++) {
+            float *pa = A->ptr + sd->base(r);
+            float *pb = B->ptr + (long int)r * run;
+            for (int i = 0; i < run; i++) pa[i] = pb[i];
+        }
+    } else {
+        #pragma omp parallel for CPU_PARALLEL(B->size)
+        for (int i = 0; i < B->size; i++) {
+            A->ptr[sd->cpu_addresses[i]] = B->ptr[i];
+        }
     }
     _profile(_CPU_SET_SELECT, 1);
 }
 void cpu_set_select_back(Tensor *A, Tensor *B, SelDescriptor *sd){
     _profile(_CPU_SET_SELECT_BACK, 0);
-    #pragma omp parallel for
-    for (int i = 0; i < B->size; i++) {
-        B->ptr[i] += A->ptr[sd->cpu_addresses[i]];
+    if (sd->run > 1) {
+        int run = sd->run;
+        #pragma omp parallel for CPU_PARALLEL(B->size)
+        for (int r = 0; r < sd->nruns; r++) {
+            float *pa = A->ptr + sd->base(r);
+            float *pb = B->ptr + (long int)r * run;
+            for (int i = 0; i < run; i++) pb[i] += pa[i];
+        }
+    } else {
+        #pragma omp parallel for CPU_PARALLEL(B->size)
+        for (int i = 0; i < B->size; i++) {
+            B->ptr[i] += A->ptr[sd->cpu_addresses[i]];
+        }
     }
     _profile(_CPU_SET_SELECT_BACK, 1);
 }
@@ -298,7 +370,7 @@ void cpu_select(Tensor * A, Tensor * B, vector<int> sind, int ini, int end,bool
     _profile(_CPU_SELECT2, 0);
     int s = A->size / A->shape[0];
 
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL((end-ini)*s)
     for (int i = ini; i < end; i++) {
         int p  = sind[i] * s;
         int pb = (i - ini) * s;
@@ -313,7 +385,7 @@ void cpu_deselect(Tensor * A, Tensor * B, vector<int> sind, int ini, int end,int
     _profile(_CPU_DESELECT, 0);
     int s = A->size / A->shape[0];
 
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL((end-ini)*s)
     for (int i = ini; i < end; i++) {
         int p  = sind[i] * s;
         int pb = (i - ini) * s;
@@ -344,7 +416,7 @@ void cpu_concat(Tensor *A, vector<Tensor*> t, unsigned int axis, bool derivative
         float *src = t[i]->ptr;
 
         // Walk tensor i
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(t[i]->size)
         for (int j = 0; j < t[i]->size; j++) {
             unsigned int k = j % src_stride;  // Pos (index) in the stride (src)
             unsigned int stride_idx = j / src_stride;  // Index of the stride (src/dst)
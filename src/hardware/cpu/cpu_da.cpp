@@ -274,14 +274,25 @@ void cpu_crop_scale(Tensor *A, Tensor *B, vector<int> coords_from, vector<int> c
 
 
 // CPU: Data augmentation (2D Optimized) ********************************************
+// The random kernels take one block of the current stream per sample (see random.h), which
+// gives up to four uniforms each, independently of the threads
+
+static inline float in_range(float u, const vector<float> &range) {
+    return range[0] + (range[1] - range[0]) * u;
+}
+
 void cpu_shift_random(Tensor *A, Tensor *B, vector<float> factor_x, vector<float> factor_y, int mode, float constant) {
     // https://docs.scipy.org/doc/scipy/reference/generated/scipy.ndimage.shift.html
 
     _profile(_CPU_SHIFT_RANDOM, 0);
+    PhiloxStream &rs = random_stream();
+    uint64_t key = rs.key, first = rs.take(B->shape[0]);
 #pragma omp parallel for
     for(int b=0; b<B->shape[0]; b++) {
-        int shift_y = (int)(A->shape[2] * uniform(factor_y[0], factor_y[1]));
-        int shift_x = (int)(A->shape[3] * uniform(factor_x[0], factor_x[1]));
+        float u[4];
+        philox_uniform4(key, first + b, u);
+        int shift_y = (int)(A->shape[2] * in_range(u[0], factor_y));
+        int shift_x = (int)(A->shape[3] * in_range(u[1], factor_x));
 
         cpu_single_shift(b, A, B, {shift_y, shift_x}, mode, constant);
     }
@@ -291,9 +302,13 @@ void cpu_shift_random(Tensor *A, Tensor *B, vector<float> factor_x, vector<float
 void cpu_rotate_random(Tensor *A, Tensor *B, vector<float> factor, vector<int> offset_center, int mode, float constant){
     // https://docs.scipy.org/doc/scipy/reference/generated/scipy.ndimage.rotate.html
     _profile(_CPU_ROTATE_RANDOM, 0);
+    PhiloxStream &rs = random_stream();
+    uint64_t key = rs.key, first = rs.take(B->shape[0]);
 #pragma omp parallel for
     for(int b=0; b<B->shape[0]; b++) {
-        float angle =  uniform(factor[0], factor[1]);
+        float u[4];
+        philox_uniform4(key, first + b, u);
+        float angle =  in_range(u[0], factor);
         cpu_single_rotate(b, A, B, angle, offset_center, mode, constant);
     }
     _profile(_CPU_ROTATE_RANDOM, 1);
@@ -305,9 +320,13 @@ void cpu_scale_random(Tensor *A, Tensor *B, vector<float> factor, int mode, floa
     // If the factor is less than 1.0f, performs a downscale with padding
 
     _profile(_CPU_SCALE_RANDOM, 0);
+    PhiloxStream &rs = random_stream();
+    uint64_t key = rs.key, first = rs.take(B->shape[0]);
 #pragma omp parallel for
     for(int b=0; b<B->shape[0]; b++) {
-        float scale = uniform(factor[0], factor[1]);
+        float u[4];
+        philox_uniform4(key, first + b, u);
+        float scale = in_range(u[0], factor);
         int new_shape_y = (int)(A->shape[2] * scale);
         int new_shape_x = (int)(A->shape[3] * scale);
 
@@ -326,9 +345,13 @@ void cpu_flip_random(Tensor *A, Tensor *B, int axis){
 
 
     _profile(_CPU_FLIP_RANDOM, 0);
+    PhiloxStream &rs = random_stream();
+    uint64_t key = rs.key, first = rs.take(B->shape[0]);
 #pragma omp parallel for
     for(int b=0; b<B->shape[0]; b++) {
-        bool apply = uniform(0.0f, 1.0f) >= 0.5f;
+        float u[4];
+        philox_uniform4(key, first + b, u);
+        bool apply = u[0] >= 0.5f;
         cpu_single_flip(b, apply, A, B, axis);
     }
     _profile(_CPU_FLIP_RANDOM, 1);
@@ -339,14 +362,18 @@ void cpu_crop_random(Tensor *A, Tensor *B){
     // Performs a crop with padding (Keeps the original size)
 
     _profile(_CPU_CROP_RANDOM, 0);
+    PhiloxStream &rs = random_stream();
+    uint64_t key = rs.key, first = rs.take(B->shape[0]);
 #pragma omp parallel for
     for(int b=0; b<B->shape[0]; b++) {
+        float u[4];
+        philox_uniform4(key, first + b, u);
 
         // Compute random coordinates
         int w = B->shape[3];
         int h = B->shape[2];
-        int x = (int)((A->shape[3]-w) * uniform(0.0f, 1.0f));
-        int y = (int)((A->shape[2]-h) * uniform(0.0f, 1.0f));
+        int x = (int)((A->shape[3]-w) * u[0]);
+        int y = (int)((A->shape[2]-h) * u[1]);
 
         int coords_from_x = x;
         int coords_to_x = x+w;
@@ -365,15 +392,19 @@ void cpu_crop_random(Tensor *A, Tensor *B){
 void cpu_crop_scale_random(Tensor *A, Tensor *B, vector<float> factor, int mode, float constant){
 
     _profile(_CPU_CROP_SCALE_RANDOM, 0);
+    PhiloxStream &rs = random_stream();
+    uint64_t key = rs.key, first = rs.take(B->shape[0]);
 #pragma omp parallel for
     for(int b=0; b<B->shape[0]; b++) {
+        float u[4];
+        philox_uniform4(key, first + b, u);
 
         // Compute random coordinates
-        float scale = uniform(factor[0], factor[1]);
+        float scale = in_range(u[0], factor);
         int h = (int)(A->shape[2] * scale);
         int w = (int)(A->shape[3] * scale);
-        int y = (int)((A->shape[2]-h) * uniform(0.0f, 1.0f));
-        int x = (int)((A->shape[3]-w) * uniform(0.0f, 1.0f));
+        int y = (int)((A->shape[2]-h) * u[1]);
+        int x = (int)((A->shape[3]-w) * u[2]);
 
         int coords_from_x = x;
         int coords_to_x = x+w;
@@ -390,14 +421,18 @@ void cpu_cutout_random(Tensor *A, Tensor *B, vector<float> factor_x, vector<floa
     // Performs a crop with padding (Keeps the original size)
 
     _profile(_CPU_CUTOUT_RANDOM, 0);
+    PhiloxStream &rs = random_stream();
+    uint64_t key = rs.key, first = rs.take(B->shape[0]);
 #pragma omp parallel for
     for(int b=0; b<B->shape[0]; b++) {
+        float u[4];
+        philox_uniform4(key, first + b, u);
 
         // Compute random coordinates
-        int h = (int)(A->shape[2] * uniform(factor_y[0], factor_y[1]));
-        int w = (int)(A->shape[3] * uniform(factor_x[0], factor_x[1]));
-        int y = (int)((A->shape[2]-h) * uniform(0.0f, 1.0f));
-        int x = (int)((A->shape[3]-w) * uniform(0.0f, 1.0f));
+        int h = (int)(A->shape[2] * in_range(u[0], factor_y));
+        int w = (int)(A->shape[3] * in_range(u[1], factor_x));
+        int y = (int)((A->shape[2]-h) * u[2]);
+        int x = (int)((A->shape[3]-w) * u[3]);
 
         int coords_from_x = x;
         int coords_to_x = x+w;
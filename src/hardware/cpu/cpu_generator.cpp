@@ -8,43 +8,74 @@
 */
 
 
+#include <cmath>
+
 #include "eddl/random.h"
 #include "eddl/hardware/cpu/cpu_tensor.h"
 
+// Element i takes lane i%4 of block i/4 of the current stream (see random.h), so the values
+// do not depend on the threads. F(u, out) maps the four uniforms of a block to four values.
+template<typename F>
+static void philox_fill(Tensor *A, const F &f) {
+    PhiloxStream &s = random_stream();
+    long int size = A->size;
+    long int nblocks = (size + 3) / 4;
+    uint64_t key = s.key, first = s.take(nblocks);
+    float *ptr = A->ptr;
+
+    #pragma omp parallel for CPU_PARALLEL(size)
+    for (long int j = 0; j < nblocks; j++) {
+        float u[4], v[4];
+        philox_uniform4(key, first + j, u);
+        f(u, v);
+
+        long int i = 4 * j;
+        if (i + 4 <= size) {
+            for (int k = 0; k < 4; k++) ptr[i + k] = v[k];
+        } else {
+            for (int k = 0; i + k < size; k++) ptr[i + k] = v[k];
+        }
+    }
+}
+
 void cpu_rand_uniform(Tensor * A, float v)
 {
     _profile(_CPU_RAND_UNIFORM, 0);
-#pragma omp parallel for
-    for (int i = 0; i < A->size; ++i) A->ptr[i] = uniform() * v;
+    philox_fill(A, [v](const float *u, float *o) {
+        for (int k = 0; k < 4; k++) o[k] = u[k] * v;
+    });
     _profile(_CPU_RAND_UNIFORM, 1);
 }
 
 void cpu_rand_signed_uniform(Tensor * A, float v)
 {
     _profile(_CPU_RAND_SIGNED_UNIFORM, 0);
-    #pragma omp parallel for
-    for (int i = 0; i < A->size; ++i) A->ptr[i] = signed_uniform() * v;
+    philox_fill(A, [v](const float *u, float *o) {
+        for (int k = 0; k < 4; k++) o[k] = (2.0f * u[k] - 1.0f) * v;
+    });
     _profile(_CPU_RAND_SIGNED_UNIFORM, 1);
 }
 
 void cpu_rand_binary(Tensor * A, float v)
 {
     _profile(_CPU_BINARY, 0);
-    #pragma omp parallel for
-    for (int i = 0; i < A->size; ++i)
-        if (uniform() < v) A->ptr[i] = 1.0;
-        else A->ptr[i] = 0.0;
+    philox_fill(A, [v](const float *u, float *o) {
+        for (int k = 0; k < 4; k++) o[k] = (u[k] < v) ? 1.0f : 0.0f;
+    });
     _profile(_CPU_BINARY, 1);
 }
 
+// Box-Muller over the two pairs of each block. fast_math is not needed anymore, as this is
+// as fast as the old lookup table and has no period
 void cpu_rand_normal(Tensor * A, float m, float s, bool fast_math) {
     _profile(_CPU_RAND_NORMAL, 0);
-    int r = rand();
-
-    if (fast_math) {
-        for (int i = 0; i < A->size; ++i) A->ptr[i] = fast_randn(m, s, r++);
-    } else  {
-        for (int i = 0; i < A->size; ++i) A->ptr[i] = slow_randn(m, s);
-    }
-    _profile(_CPU_RAND_NORMAL, 0);
+    const float two_pi = 6.28318530718f;
+    philox_fill(A, [=](const float *u, float *o) {
+        for (int k = 0; k < 4; k += 2) {
+            float r = std::sqrt(-2.0f * std::log(1.0f - u[k]));  // 1-u is in (0, 1]
+            o[k] = m + s * r * std::cos(two_pi * u[k + 1]);
+            o[k + 1] = m + s * r * std::sin(two_pi * u[k + 1]);
+        }
+    });
+    _profile(_CPU_RAND_NORMAL, 1);
 }
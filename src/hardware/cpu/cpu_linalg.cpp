@@ -15,6 +15,7 @@
 
 #include "eddl/hardware/cpu/cpu_tensor.h"
 #include "eddl/random.h"
+#include "cpu_reduce.h"
 
 
 
@@ -24,10 +25,10 @@ float cpu_norm(Tensor *A, string ord){
 
 
 void cpu_norm(Tensor *A, Tensor *B, ReduceDescriptor2 *rd, string ord){
-#pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        B->ptr[i] = cpu_norm_(A->ptr, rd->index[i].size(), rd->index[i].data(), ord);
-    }
+    if(ord!="fro") msg("Not yet implemented", "cpu_norm");
+
+    float *b = B->ptr;
+    strided::run(A->ptr, rd->rs, strided::SumSqr(), [b](int i, float t){ b[i] = ::sqrtf(t); });
 }
 
 float cpu_norm_(float *ptr, int size, int *map, string ord){
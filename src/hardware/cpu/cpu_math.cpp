@@ -9,43 +9,45 @@
 
 
 #include "eddl/hardware/cpu/cpu_tensor.h"
+#include "cpu_reduce.h"
 #include <unordered_map>
+#include <algorithm>
 
 // CPU: Math (in-place) ********************************************
 
 void cpu_abs(Tensor *A, Tensor *B) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::fabs(A->ptr[i]);
 }
 
 void cpu_acos(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::acosf(A->ptr[i]);
 }
 
 void cpu_add(Tensor *A, Tensor *B, float v) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = A->ptr[i] + v;
 }
 
 
 void cpu_asin(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::asinf(A->ptr[i]);
 }
 
 void cpu_atan(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::atanf(A->ptr[i]);
 }
 
 void cpu_ceil(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::ceilf(A->ptr[i]);
 }
 
 void cpu_clamp(Tensor *A, Tensor *B, float min, float max){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i){
         if (A->ptr[i] < min){
             B->ptr[i] = min;
@@ -59,58 +61,60 @@ void cpu_clamp(Tensor *A, Tensor *B, float min, float max){
 
 
 void cpu_cos(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::cosf(A->ptr[i]);
 }
 
 void cpu_cosh(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::coshf(A->ptr[i]);
 }
 
 void cpu_exp(Tensor *A, Tensor *B) {
-#pragma omp parallel for
-    for (int i = 0; i < A->size; ++i) B->ptr[i] = ::expf(A->ptr[i]);
+    long int size = A->size;
+#pragma omp parallel for CPU_PARALLEL(size)
+    for (long int i = 0; i < size; i += CPU_VBLOCK) cpu_vexp(A->ptr + i, B->ptr + i, std::min<long int>(CPU_VBLOCK, size - i));
 }
 
 void cpu_floor(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::floorf(A->ptr[i]);
 }
 
 void cpu_inv(Tensor *A, Tensor *B, float v){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = v/A->ptr[i];
 }
 
 void cpu_log(Tensor *A, Tensor *B) {
-#pragma omp parallel for
-    for (int i = 0; i < A->size; ++i) B->ptr[i] = ::logf(A->ptr[i]);
+    long int size = A->size;
+#pragma omp parallel for CPU_PARALLEL(size)
+    for (long int i = 0; i < size; i += CPU_VBLOCK) cpu_vlog(A->ptr + i, B->ptr + i, std::min<long int>(CPU_VBLOCK, size - i));
 }
 
 void cpu_log2(Tensor *A, Tensor *B) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::log2f(A->ptr[i]);
 }
 
 void cpu_log10(Tensor *A, Tensor *B) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::log10f(A->ptr[i]);
 }
 
 void cpu_logn(Tensor *A, Tensor *B, float n) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::logf(A->ptr[i])/::logf(n);
 }
 
 
 void cpu_mod(Tensor *A, Tensor *B, float v){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::fmod(A->ptr[i], v);
 }
 
 void cpu_mult(Tensor *A, Tensor *B, float v) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = A->ptr[i] * v;
 }
 
@@ -120,7 +124,7 @@ void cpu_normalize(Tensor *A, Tensor *B, float min, float max){
     float max_ori = A->max();
     float min_ori = A->min();
 
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) {
         B->ptr[i] = (max-min)/(max_ori-min_ori) * (A->ptr[i]-min_ori) + min;
     }
@@ -130,37 +134,38 @@ void cpu_pow(Tensor *A, Tensor *B, float exp) {
     // To compute the power, std uses real floating-point number with the formurla: e^(y*log_(x))
     // Quite inefficient (x100 slower) in g++ except for pow_(x, 2) which is inlined as x*x
     // speed: 0.057887s
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::powf(A->ptr[i], exp);
 }
 
 void cpu_powb(Tensor *A, Tensor *B, float base) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::powf(base, A->ptr[i]);
 }
 
 void cpu_remainder(Tensor *A, Tensor *B, float v) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = fmod((v + fmod(A->ptr[i], v)), v);
 }
 
 void cpu_round(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::roundf(A->ptr[i]);
 }
 
 void cpu_rsqrt(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = 1.0f/::sqrtf(A->ptr[i]);
 }
 
 void cpu_sigmoid(Tensor *A, Tensor *B){
-#pragma omp parallel for
-    for (int i = 0; i < A->size; ++i) B->ptr[i] = 1.0f/(1.0f + ::expf(-A->ptr[i]));
+    long int size = A->size;
+#pragma omp parallel for CPU_PARALLEL(size)
+    for (long int i = 0; i < size; i += CPU_VBLOCK) cpu_vsigmoid(A->ptr + i, B->ptr + i, std::min<long int>(CPU_VBLOCK, size - i));
 }
 
 void cpu_sign(Tensor *A, Tensor *B, float zero_sign){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) {
         if(A->ptr[i] > 0.0f){
             B->ptr[i] = 1.0f;
@@ -174,24 +179,24 @@ void cpu_sign(Tensor *A, Tensor *B, float zero_sign){
 
 
 void cpu_sin(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::sinf(A->ptr[i]);
 }
 
 void cpu_sinh(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::sinhf(A->ptr[i]);
 }
 
 void cpu_sqr(Tensor *A, Tensor *B) {
     // pow(x, 2) == x*x  To know more, read comments in pow_'s function
     // speed: 0.000497s
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = A->ptr[i] * A->ptr[i];
 }
 
 void cpu_sqrt(Tensor *A, Tensor *B) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::sqrtf(A->ptr[i]);
 }
 
@@ -208,12 +213,13 @@ void cpu_tan(Tensor *A, Tensor *B){
 }
 
 void cpu_tanh(Tensor *A, Tensor *B){
-#pragma omp parallel for
-    for (int i = 0; i < A->size; ++i) B->ptr[i] = ::tanhf(A->ptr[i]);
+    long int size = A->size;
+#pragma omp parallel for CPU_PARALLEL(size)
+    for (long int i = 0; i < size; i += CPU_VBLOCK) cpu_vtanh(A->ptr + i, B->ptr + i, std::min<long int>(CPU_VBLOCK, size - i));
 }
 
 void cpu_trunc(Tensor *A, Tensor *B){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) B->ptr[i] = ::truncf(A->ptr[i]);
 }
 
@@ -222,7 +228,7 @@ void cpu_trunc(Tensor *A, Tensor *B){
 // CPU: Math (static) ***************************
 
 void cpu_add(float scA, Tensor *A, float scB, Tensor *B, Tensor *C, int incC) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++)
         if (incC) C->ptr[i] += scA * A->ptr[i] + scB * B->ptr[i];
         else C->ptr[i] = scA * A->ptr[i] + scB * B->ptr[i];
@@ -232,7 +238,7 @@ void cpu_add(float scA, Tensor *A, float scB, Tensor *B, Tensor *C, int incC) {
 void cpu_inc(Tensor *A, Tensor *B) {
 
 
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++){
         B->ptr[i] += A->ptr[i];
     }
@@ -261,7 +267,7 @@ void cpu_mult2D(Tensor *A, int tA, Tensor *B, int tB, Tensor *C, int incC) {
 }
 
 void cpu_el_div(Tensor *A, Tensor *B, Tensor *C, int incC) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++)
         if (incC) C->ptr[i] += A->ptr[i] / B->ptr[i];
         else C->ptr[i] = A->ptr[i] / B->ptr[i];
@@ -269,7 +275,7 @@ void cpu_el_div(Tensor *A, Tensor *B, Tensor *C, int incC) {
 
 
 void cpu_el_mult(Tensor *A, Tensor *B, Tensor *C, int incC) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++)
         if (incC) C->ptr[i] += A->ptr[i] * B->ptr[i];
         else C->ptr[i] = A->ptr[i] * B->ptr[i];
@@ -277,7 +283,7 @@ void cpu_el_mult(Tensor *A, Tensor *B, Tensor *C, int incC) {
 
 
 void cpu_sum2D_rowwise(Tensor *A, Tensor *B, Tensor *C) {
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->shape[0]; i++) {
         int p=i*A->shape[1];
         for (int j = 0; j < A->shape[1]; j++, p++)
@@ -287,7 +293,7 @@ void cpu_sum2D_rowwise(Tensor *A, Tensor *B, Tensor *C) {
 
 void cpu_sum2D_colwise(Tensor *A, Tensor *B, Tensor *C) {
 
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->shape[0]; i++) {
         int p=i*A->shape[1];
         for (int j = 0; j < A->shape[1]; j++, p++)
@@ -297,28 +303,28 @@ void cpu_sum2D_colwise(Tensor *A, Tensor *B, Tensor *C) {
 
 
 void cpu_maximum(Tensor* A, Tensor* B, float v){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) {
         B->ptr[i] = ::max(A->ptr[i], v);
     }
 }
 
 void cpu_maximum(Tensor* A, Tensor* B, Tensor* C){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) {
         C->ptr[i] = ::max(A->ptr[i], B->ptr[i]);
     }
 }
 
 void cpu_minimum(Tensor* A, Tensor* B, float v){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) {
         B->ptr[i] = ::min(A->ptr[i], v);
     }
 }
 
 void cpu_minimum(Tensor* A, Tensor* B, Tensor* C){
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; ++i) {
         C->ptr[i] = ::min(A->ptr[i], B->ptr[i]);
     }
@@ -335,11 +341,10 @@ float cpu_max(Tensor *A) {
 
 
 void cpu_max(Tensor *A, Tensor *B, ReduceDescriptor2 *rd){
-    #pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        auto t = cpu_max(A->ptr, rd->index[i].size(), rd->index[i].data());
-        B->ptr[i] = std::get<0>(t);  // get max
-    }
+    float *b = B->ptr;
+    strided::run(A->ptr, rd->rs, strided::ArgMax(rd->rs, true), [b](int i, const strided::ArgMax::T &t){
+        b[i] = t.v;  // get max
+    });
 }
 
 int cpu_argmax(Tensor *A) {
@@ -349,16 +354,16 @@ int cpu_argmax(Tensor *A) {
 
 
 void cpu_argmax(Tensor *A, Tensor *B, ReduceDescriptor2 *rd){
-    #pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        auto t = cpu_max(A->ptr, rd->index[i].size(), rd->index[i].data());
-        B->ptr[i] = std::get<1>(t);  // get argmax
-    }
+    float *b = B->ptr;
+    const ReduceShape &rs = rd->rs;
+    strided::run(A->ptr, rs, strided::ArgMax(rs, true), [b, &rs](int i, const strided::ArgMax::T &t){
+        b[i] = rs.position(t.m);  // get argmax
+    });
 }
 
 void cpu_argmax_d(Tensor *D, Tensor *O, Tensor *PD){
     int reduction_size = PD->size/D->size;
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++){
         int argmax = (int)O->ptr[i];  // local
         int offset = i*reduction_size;
@@ -415,11 +420,10 @@ float cpu_min(Tensor *A) {
 
 
 void cpu_min(Tensor *A, Tensor *B, ReduceDescriptor2 *rd){
-    #pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        auto t = cpu_min(A->ptr, rd->index[i].size(), rd->index[i].data());
-        B->ptr[i] = std::get<0>(t);  // get min
-    }
+    float *b = B->ptr;
+    strided::run(A->ptr, rd->rs, strided::ArgMin(rd->rs, true), [b](int i, const strided::ArgMin::T &t){
+        b[i] = t.v;  // get min
+    });
 }
 
 
@@ -430,11 +434,11 @@ int cpu_argmin(Tensor *A) {
 
 
 void cpu_argmin(Tensor *A, Tensor *B, ReduceDescriptor2 *rd){
-    #pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        auto t = cpu_min(A->ptr, rd->index[i].size(), rd->index[i].data());
-        B->ptr[i] = std::get<1>(t);  // get argmmin
-    }
+    float *b = B->ptr;
+    const ReduceShape &rs = rd->rs;
+    strided::run(A->ptr, rs, strided::ArgMin(rs, true), [b, &rs](int i, const strided::ArgMin::T &t){
+        b[i] = rs.position(t.m);  // get argmin
+    });
 }
 
 
@@ -486,10 +490,8 @@ float cpu_sum(Tensor *A) {
 
 
 void cpu_sum(Tensor *A, Tensor *B, ReduceDescriptor2 *rd){
-    #pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        B->ptr[i] = cpu_sum(A->ptr, rd->index[i].size(), rd->index[i].data());
-    }
+    float *b = B->ptr;
+    strided::run(A->ptr, rd->rs, strided::Sum(), [b](int i, float t){ b[i] = t; });
 }
 
 float cpu_sum(float *ptr, int size, int *map) {
@@ -514,10 +516,8 @@ float cpu_sum_abs(Tensor *A) {
 
 
 void cpu_sum_abs(Tensor *A, Tensor *B, ReduceDescriptor2 *rd){
-#pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        B->ptr[i] = cpu_sum_abs(A->ptr, rd->index[i].size(), rd->index[i].data());
-    }
+    float *b = B->ptr;
+    strided::run(A->ptr, rd->rs, strided::SumAbs(), [b](int i, float t){ b[i] = t; });
 }
 
 float cpu_sum_abs(float *ptr, int size, int *map) {
@@ -542,10 +542,8 @@ float cpu_prod(Tensor *A) {
 
 
 void cpu_prod(Tensor *A, Tensor *B, ReduceDescriptor2 *rd){
-#pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        B->ptr[i] = cpu_prod(A->ptr, rd->index[i].size(), rd->index[i].data());
-    }
+    float *b = B->ptr;
+    strided::run(A->ptr, rd->rs, strided::Prod(), [b](int i, float t){ b[i] = t; });
 }
 
 float cpu_prod(float *ptr, int size, int *map) {
@@ -569,10 +567,9 @@ float cpu_mean(Tensor *A) {
 
 
 void cpu_mean(Tensor *A, Tensor *B, ReduceDescriptor2 *rd){
-    #pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        B->ptr[i] = cpu_sum(A->ptr, rd->index[i].size(), rd->index[i].data()) / rd->index[i].size();
-    }
+    float *b = B->ptr;
+    float d = (float)rd->rs.nred;
+    strided::run(A->ptr, rd->rs, strided::Sum(), [b, d](int i, float t){ b[i] = t / d; });
 }
 
 
@@ -582,10 +579,11 @@ float cpu_var(Tensor *A, bool unbiased){
 
 
 void cpu_var(Tensor *A, Tensor *B, ReduceDescriptor2 *rd, bool unbiased){
-#pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        B->ptr[i] = cpu_var(A->ptr, rd->index[i].size(), rd->index[i].data(), unbiased);
-    }
+    float *b = B->ptr;
+    int n = rd->rs.nred;
+    strided::gather(A->ptr, rd->rs, [b, n, unbiased](int i, float *buf){
+        b[i] = cpu_var(buf, n, nullptr, unbiased);
+    });
 }
 
 float cpu_var(float *ptr, int size, int *map, bool unbiased){
@@ -615,10 +613,11 @@ float cpu_std(Tensor *A, bool unbiased) {
 }
 
 void cpu_std(Tensor *A, Tensor *B, ReduceDescriptor2 *rd, bool unbiased){
-#pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        B->ptr[i] = ::sqrtf(cpu_var(A->ptr, rd->index[i].size(), rd->index[i].data(), unbiased));
-    }
+    float *b = B->ptr;
+    int n = rd->rs.nred;
+    strided::gather(A->ptr, rd->rs, [b, n, unbiased](int i, float *buf){
+        b[i] = ::sqrtf(cpu_var(buf, n, nullptr, unbiased));
+    });
 }
 
 
@@ -628,10 +627,11 @@ int cpu_mode(Tensor *A) {
 
 
 void cpu_mode(Tensor *A, Tensor *B, ReduceDescriptor2 *rd){
-#pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        B->ptr[i] = cpu_mode(A->ptr, rd->index[i].size(), rd->index[i].data());
-    }
+    float *b = B->ptr;
+    int n = rd->rs.nred;
+    strided::gather(A->ptr, rd->rs, [b, n](int i, float *buf){
+        b[i] = cpu_mode(buf, n, nullptr);
+    });
 }
 
 int cpu_mode(float *ptr, int size, int *map) {
@@ -665,10 +665,11 @@ float cpu_median(Tensor *A) {
 
 
 void cpu_median(Tensor *A, Tensor *B, ReduceDescriptor2 *rd){
-    #pragma omp parallel for
-    for(int i=0; i<rd->index.size(); i++){
-        B->ptr[i] = cpu_median(A->ptr, rd->index[i].size(), rd->index[i].data());
-    }
+    float *b = B->ptr;
+    int n = rd->rs.nred;
+    strided::gather(A->ptr, rd->rs, [b, n](int i, float *buf){
+        b[i] = cpu_median(buf, n, nullptr);
+    });
 }
 
 float cpu_median(float *ptr, int size, int *map) {
@@ -677,10 +678,10 @@ float cpu_median(float *ptr, int size, int *map) {
 
     // Copy data
     if(map == nullptr){
-        #pragma omp parallel for
+        #pragma omp parallel for CPU_PARALLEL(size)
         for (int i = 0; i < size; ++i) { sorted_data[i] = ptr[i]; }
     }else{
-        #pragma omp parallel for
+        #pragma omp parallel for CPU_PARALLEL(size)
         for (int i = 0; i < size; ++i) { sorted_data[i] = ptr[map[i]]; }
     }
 
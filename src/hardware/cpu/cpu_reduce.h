@@ -0,0 +1,250 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_CPU_REDUCE_H
+#define EDDL_CPU_REDUCE_H
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+
+#include "eddl/hardware/cpu/cpu_tensor.h"
+
+// Strided reductions over a ReduceShape (see tensor_descriptors.h), shared by the reductions
+// of the Tensor API (ReduceDescriptor2) and the reduction layers (ReduceDescriptor).
+//
+// Every reduction walks its input as runs of the innermost reduced axis, which are contiguous
+// when the last axes are reduced. Parallelism depends on the shape:
+//  - Many reductions: one thread per group of reductions. When the innermost axis is kept
+//    (e.g. mean over the batch), neighbour reductions are accumulated together, so the loads
+//    are still contiguous.
+//  - Few long reductions: each one is split in chunks, one per thread, merged in order.
+//
+// An op has a state T and:
+//   T init()                                    Empty state
+//   void run(T&, const float *p, int n, int s, int m)   Adds p[0], p[s]... p[(n-1)*s], which are
+//                                               the elements m...m+n-1 (memory order) of the reduction
+//   void add(T&, float x, int m)                Adds the m-th element
+//   void merge(T&, const T&)                    Joins the state of the elements that follow
+
+namespace strided {
+
+    // Sum of f(x) over a strided run
+    template<typename F>
+    inline float sum_run(const float *p, int n, int s, const F &f) {
+        float sum = 0.0f;
+        if (s == 1) {
+            #pragma omp simd reduction(+:sum)
+            for (int j = 0; j < n; j++) sum += f(p[j]);
+        } else {
+            #pragma omp simd reduction(+:sum)
+            for (int j = 0; j < n; j++) sum += f(p[(long int)j*s]);
+        }
+        return sum;
+    }
+
+    struct FnId { float operator()(float x) const { return x; } };
+    struct FnAbs { float operator()(float x) const { return std::fabs(x); } };
+    struct FnSqr { float operator()(float x) const { return x*x; } };
+
+    template<typename F>
+    struct SumOf {
+        typedef float T;
+        F f;
+
+        T init() const { return 0.0f; }
+        void run(T &acc, const float *p, int n, int s, int m) const { acc += sum_run(p, n, s, f); }
+        void add(T &acc, float x, int m) const { acc += f(x); }
+        void merge(T &acc, const T &b) const { acc += b; }
+    };
+
+    typedef SumOf<FnId> Sum;
+    typedef SumOf<FnAbs> SumAbs;
+    typedef SumOf<FnSqr> SumSqr;
+
+    struct Prod {
+        typedef float T;
+
+        T init() const { return 1.0f; }
+        void run(T &acc, const float *p, int n, int s, int m) const {
+            float prod = 1.0f;
+            #pragma omp simd reduction(*:prod)
+            for (int j = 0; j < n; j++) prod *= p[(long int)j*s];
+            acc *= prod;
+        }
+        void add(T &acc, float x, int m) const { acc *= x; }
+        void merge(T &acc, const T &b) const { acc *= b; }
+    };
+
+    // Max (or min) and the memory index of the first element that reaches it. With by_position,
+    // ties go to the first element in position order (ReduceShape::position), as argmax expects.
+    template<bool Min>
+    struct Arg {
+        struct T { float v; int m; };
+        const ReduceShape *R;
+        bool ties;
+
+        Arg(const ReduceShape &R, bool by_position) : R(&R) {
+            int n = 0;  // Position and memory order only differ with two or more reduced axes
+            for (int k : R.raxes) n += (k > 1);
+            ties = by_position && n > 1;
+        }
+
+        static bool better(float x, float y) { return Min ? x < y : x > y; }
+        bool wins(float x, int m, const T &acc) const {
+            return better(x, acc.v) || (ties && x == acc.v && R->position(m) < R->position(acc.m));
+        }
+
+        T init() const { return {Min ? MAX_FLOAT : MIN_FLOAT, 0}; }
+        void run(T &acc, const float *p, int n, int s, int m) const {
+            // Vectorized scan for the extreme; the position is only searched if it changes
+            float best = acc.v;
+            if (Min) {
+                #pragma omp simd reduction(min:best)
+                for (int j = 0; j < n; j++) best = std::min(best, p[(long int)j*s]);
+            } else {
+                #pragma omp simd reduction(max:best)
+                for (int j = 0; j < n; j++) best = std::max(best, p[(long int)j*s]);
+            }
+            if (!better(best, acc.v) && !(ties && best == acc.v)) return;
+            for (int j = 0; j < n; j++) add(acc, p[(long int)j*s], m + j);
+        }
+        void add(T &acc, float x, int m) const {
+            if (wins(x, m, acc)) { acc.v = x; acc.m = m; }
+        }
+        void merge(T &acc, const T &b) const {
+            if (wins(b.v, b.m, acc)) acc = b;
+        }
+    };
+
+    typedef Arg<false> ArgMax;
+    typedef Arg<true> ArgMin;
+
+    // Elements m0...m1-1 (memory order) of the reduction that starts at p
+    template<typename Op>
+    inline void run_range(const float *p, const ReduceShape &R, const Op &op, typename Op::T &acc, int m0, int m1) {
+        if (R.rshape.empty()) {  // Nothing to reduce (size-1 axes)
+            if (m0 < m1) op.run(acc, p, 1, 1, 0);
+            return;
+        }
+        int n = R.rshape.back(), s = R.rstride.back();
+        for (int m = m0; m < m1; ) {
+            int len = std::min(n - m % n, m1 - m);
+            op.run(acc, p + R.offset(m), len, s, m);
+            m += len;
+        }
+    }
+
+    /**
+    *   @brief Runs every reduction of R over in, and calls store(i, state) with the result of each one
+    */
+    template<typename Op, typename Store>
+    void run(const float *in, const ReduceShape &R, const Op &op, const Store &store) {
+        typedef typename Op::T T;
+        long int total = (long int)R.nout * R.nred;
+        if (R.nout == 0) return;
+
+        // Few long reductions: split each one in ordered chunks
+        int nth = omp_get_max_threads();
+        if (R.nout < nth && cpu_parallel(R.nred)) {
+            int nchunks = (int)std::min((long int)nth, R.nred / cpu_grain);
+            std::vector<T> part(nchunks);
+            for (int i = 0; i < R.nout; i++) {
+                const float *p = in + R.base(i);
+                #pragma omp parallel for schedule(static)
+                for (int c = 0; c < nchunks; c++) {
+                    part[c] = op.init();
+                    run_range(p, R, op, part[c], (int)((long int)R.nred*c/nchunks), (int)((long int)R.nred*(c+1)/nchunks));
+                }
+                T acc = part[0];
+                for (int c = 1; c < nchunks; c++) op.merge(acc, part[c]);
+                store(i, acc);
+            }
+            return;
+        }
+
+        // Innermost axis kept: blocks of neighbour reductions advance together
+        if (!R.kshape.empty() && !R.rshape.empty() && R.kstride.back() == 1) {
+            const int BL = 64;
+            int K = R.kshape.back();
+            int nblk = (K + BL - 1) / BL;
+            long int nwork = (long int)(R.nout / K) * nblk;
+            #pragma omp parallel for CPU_PARALLEL(total)
+            for (long int w = 0; w < nwork; w++) {
+                int l0 = (int)(w % nblk) * BL;
+                int len = std::min(BL, K - l0);
+                int i0 = (int)(w / nblk) * K + l0;
+                const float *p0 = in + R.base(i0);
+
+                T acc[BL];
+                for (int l = 0; l < len; l++) acc[l] = op.init();
+                for (int m = 0; m < R.nred; m++) {
+                    const float *p = p0 + R.offset(m);
+                    #pragma omp simd
+                    for (int l = 0; l < len; l++) op.add(acc[l], p[l], m);
+                }
+                for (int l = 0; l < len; l++) store(i0 + l, acc[l]);
+            }
+            return;
+        }
+
+        #pragma omp parallel for CPU_PARALLEL(total)
+        for (int i = 0; i < R.nout; i++) {
+            T acc = op.init();
+            run_range(in + R.base(i), R, op, acc, 0, R.nred);
+            store(i, acc);
+        }
+    }
+
+    /**
+    *   @brief Calls f(i, a) for every input address a of every reduction i
+    */
+    template<typename F>
+    void foreach(const ReduceShape &R, const F &f) {
+        int n = R.rshape.empty() ? 1 : R.rshape.back();
+        int s = R.rshape.empty() ? 1 : R.rstride.back();
+        int rows = R.nred / n;
+        long int nwork = (long int)R.nout * rows;
+
+        #pragma omp parallel for CPU_PARALLEL((long int)R.nout * R.nred)
+        for (long int w = 0; w < nwork; w++) {
+            int i = (int)(w / rows);
+            int a = R.base(i) + R.offset((int)(w % rows) * n);
+            for (int j = 0; j < n; j++) f(i, a + j*s);
+        }
+    }
+
+    /**
+    *   @brief Calls f(i, buf) for every reduction i, with its elements copied to buf in position order
+    */
+    template<typename F>
+    void gather(const float *in, const ReduceShape &R, const F &f) {
+        #pragma omp parallel CPU_PARALLEL((long int)R.nout * R.nred)
+        {
+            std::vector<float> buf(R.nred);
+            #pragma omp for
+            for (int i = 0; i < R.nout; i++) {
+                const float *p = in + R.base(i);
+                for (int q = 0; q < R.nred; q++) {
+                    int a = 0, r = q;
+                    for (int k = 0; k < R.raxes.size(); k++) {
+                        a += (r % R.raxes[k]) * R.raxes_stride[k];
+                        r /= R.raxes[k];
+                    }
+                    buf[q] = p[a];
+                }
+                f(i, buf.data());
+            }
+        }
+    }
+
+}
+
+#endif //EDDL_CPU_REDUCE_H
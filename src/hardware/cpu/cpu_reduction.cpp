@@ -10,6 +10,7 @@
 #include <stdexcept>
 
 #include "eddl/hardware/cpu/cpu_tensor.h"
+#include "cpu_reduce.h"
 
 void cpu_reduce(Tensor *A, Tensor *B,string mode,int* map)
 {
@@ -113,109 +114,61 @@ void cpu_reduce_sum2D(Tensor *A, Tensor *B, int axis, int incB) {
 
 
 void cpu_reduction(ReduceDescriptor *RD){
-
     _profile(_CPU_REDUCTION, 0);
+    const ReduceShape &rs = RD->rs;
+    float *o = RD->O->ptr;
+
+    if (RD->m<2) { // mean or sum
+        float d = (RD->m==0) ? (float)rs.nred : 1.0f;
+        if (RD->keepdims) {
+            vector<float> red(rs.nout);
+            strided::run(RD->I->ptr, rs, strided::Sum(), [&red, d](int i, float t){ red[i] = t / d; });
+            strided::foreach(rs, [&red, o](int i, int a){ o[a] = red[i]; });
+        }
+        else strided::run(RD->I->ptr, rs, strided::Sum(), [o, d](int i, float t){ o[i] = t / d; });
+    }
+    else { // max or min: S keeps the input address
+        vector<float> val(rs.nout), ind(rs.nout);
+        auto store = [&rs, &val, &ind](int i, float v, int m){
+            val[i] = v;
+            ind[i] = rs.base(i) + rs.offset(m);
+        };
+        if (RD->m==2) strided::run(RD->I->ptr, rs, strided::ArgMax(rs, false), [&store](int i, const strided::ArgMax::T &t){ store(i, t.v, t.m); });
+        else strided::run(RD->I->ptr, rs, strided::ArgMin(rs, false), [&store](int i, const strided::ArgMin::T &t){ store(i, t.v, t.m); });
+
+        float *sp = RD->S->ptr;
+        if (RD->keepdims) {
+            strided::foreach(rs, [&val, &ind, o, sp](int i, int a){ o[a] = val[i]; sp[a] = ind[i]; });
+        }
+        else {
+            #pragma omp parallel for CPU_PARALLEL(rs.nout)
+            for (int i = 0; i < rs.nout; i++) { o[i] = val[i]; sp[i] = ind[i]; }
+        }
+    }
+    _profile(_CPU_REDUCTION, 1);
+}
 
-      float val,sum;
-      int ind;
-      int d;
-      int i,j,k,l,s;
-
-      // [MEAN]: Compute items to be reduced
-      if (RD->m==0) {
-          d=1;
-          for(i=0;i<RD->axis.size();i++){
-              d *= RD->I->shape[RD->axis[i]];
-          }
-      }
-
-      //reduce
-      for(i=0;i<RD->index.size();i++)
-      {
-          sum=0;
-
-          for(j=0;j<RD->index[i].size();j++) {
-
-              float v=RD->I->ptr[RD->index[i][j]];
-              if (RD->m==2) {
-                  if (j==0) {val=v;ind=RD->index[i][j];}
-                  else if (v>val) {
-                      val=v;
-                      ind=RD->index[i][j];
-                  }
-              }
-              else if (RD->m==3) {
-                if (j==0) {val=v;ind=RD->index[i][j];}
-                else if (v<val) {
-                    val=v;
-                    ind=RD->index[i][j];
-                }
-              }
-              else sum+=v;
-          }
-
-          // set in Output
-          if (RD->m<2) { // mean or sum
-              if (RD->m==0) sum/=d;
-              if (RD->keepdims) {
-                  for(j=0;j<RD->index[i].size();j++) {
-                      RD->O->ptr[RD->index[i][j]]=sum;
-                    }
-              }
-              else RD->O->ptr[i]=sum;
-          }
-          else { // max or min
-              if (RD->keepdims) {
-                  for(j=0;j<RD->index[i].size();j++) {
-                      RD->O->ptr[RD->index[i][j]]=val;
-                      RD->S->ptr[RD->index[i][j]]=ind;
-                  }
-              }
-              else {
-                  RD->O->ptr[i]=val;
-                  RD->S->ptr[i]=ind;
-              }
-          }
-
-      }// i
-      _profile(_CPU_REDUCTION, 1);
-  }
+void cpu_reduction_back(ReduceDescriptor *RD){
+    _profile(_CPU_REDUCTION_BACK, 0);
+    const ReduceShape &rs = RD->rs;
+
+    if (RD->m>=2) {
+        for (int i = 0; i < rs.nout; i++) {
+            int p = RD->S->ptr[i];
+            RD->ID->ptr[p] += RD->D->ptr[i];
+        }
+    }
+    else {
+        float d = (RD->m==0) ? (float)rs.nred : 1.0f;
+        vector<float> val(rs.nout);
+        if (RD->keepdims) strided::run(RD->D->ptr, rs, strided::Sum(), [&val, d](int i, float t){ val[i] = t / d; });
+        else {
+            float *dp = RD->D->ptr;
+            for (int i = 0; i < rs.nout; i++) val[i] = dp[i] / d;
+        }
 
-  void cpu_reduction_back(ReduceDescriptor *RD){
-
-  _profile(_CPU_REDUCTION_BACK, 0);
-
-      float val,sum;
-      int ind;
-      int d;
-      int i,j,k,l,s;
-
-      if (RD->m==0) {
-          d=1;
-          for(i=0;i<RD->axis.size();i++){
-              d *= RD->I->shape[RD->axis[i]];
-          }
-      }
-
-      for(i=0;i<RD->index.size();i++)
-        {
-            if (RD->m>=2) {
-                int p=RD->S->ptr[i];
-                RD->ID->ptr[p]+=RD->D->ptr[i];
-            }
-            else {
-              val=0;
-              if(RD->keepdims) {
-                for(j=0;j<RD->index[i].size();j++)
-                  val+=RD->D->ptr[RD->index[i][j]];
-              }
-              else val=RD->D->ptr[i];
-
-              if (RD->m==0) val/=d;
-              for(j=0;j<RD->index[i].size();j++)
-                RD->ID->ptr[RD->index[i][j]]+=val;
-            }
-        }//i
-
-        _profile(_CPU_REDUCTION_BACK, 1);
+        float *id = RD->ID->ptr;
+        strided::foreach(rs, [&val, id](int i, int a){ id[a] += val[i]; });
     }
+    _profile(_CPU_REDUCTION_BACK, 1);
+}
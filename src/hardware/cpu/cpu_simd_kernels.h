@@ -0,0 +1,176 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+// Body of the vectorized math kernels, included once per instruction set by cpu_simd_math.cpp.
+// The includer defines the vector types (V, M), the lane count W and the primitive ops
+// (set1, load, store, add, sub, mul, div, fma, vmin, vmax, vabs, vround, pow2i, exponent,
+// mantissa, lt, gt, unord, mor, select, sign, bits) inside its own namespace.
+// Polynomials and reduction constants follow Cephes (expf, logf, tanhf).
+
+#define SIMD_EXP_HI 88.3762626647949f
+#define SIMD_EXP_LO -87.3365447504f
+
+// exp(x) for x in [SIMD_EXP_LO, SIMD_EXP_HI]
+static inline V exp_core(V x) {
+    V fx = vround(mul(x, set1(1.44269504088896341f)));
+    V r = fma(fx, set1(-0.693359375f), x);
+    r = fma(fx, set1(2.12194440e-4f), r);
+
+    V y = set1(1.9875691500E-4f);
+    y = fma(y, r, set1(1.3981999507E-3f));
+    y = fma(y, r, set1(8.3334519073E-3f));
+    y = fma(y, r, set1(4.1665795894E-2f));
+    y = fma(y, r, set1(1.6666665459E-1f));
+    y = fma(y, r, set1(5.0000001201E-1f));
+    y = fma(y, mul(r, r), add(r, set1(1.0f)));
+    return mul(y, pow2i(fx));
+}
+
+// log(x) for positive, normal and finite x
+static inline V log_core(V x) {
+    V one = set1(1.0f);
+    V zero = set1(0.0f);
+    V e = exponent(x);  // x = m * 2^e, m in [0.5, 1)
+    V m = mantissa(x);
+
+    M lo = lt(m, set1(0.707106781186547524f));
+    e = sub(e, select(lo, one, zero));
+    m = add(sub(m, one), select(lo, m, zero));
+    V z = mul(m, m);
+
+    V y = set1(7.0376836292E-2f);
+    y = fma(y, m, set1(-1.1514610310E-1f));
+    y = fma(y, m, set1(1.1676998740E-1f));
+    y = fma(y, m, set1(-1.2420140846E-1f));
+    y = fma(y, m, set1(1.4249322787E-1f));
+    y = fma(y, m, set1(-1.6668057665E-1f));
+    y = fma(y, m, set1(2.0000714765E-1f));
+    y = fma(y, m, set1(-2.4999993993E-1f));
+    y = fma(y, m, set1(3.3333331174E-1f));
+    y = mul(mul(y, m), z);
+
+    y = fma(e, set1(-2.12194440e-4f), y);
+    y = fma(z, set1(-0.5f), y);
+    V r = add(m, y);
+    return fma(e, set1(0.693359375f), r);
+}
+
+// log(1+t) for t in [0, 1], as 2*atanh(s) with s = t/(2+t) <= 1/3.
+// 2s is kept as such, since s itself is denormal when t is close to the smallest normal
+static inline V log1p_core(V t) {
+    V s = div(add(t, t), add(t, set1(2.0f)));
+    V s2 = mul(mul(s, s), set1(0.25f));
+    V y = set1(1.0f/17.0f);
+    y = fma(y, s2, set1(1.0f/15.0f));
+    y = fma(y, s2, set1(1.0f/13.0f));
+    y = fma(y, s2, set1(1.0f/11.0f));
+    y = fma(y, s2, set1(1.0f/9.0f));
+    y = fma(y, s2, set1(1.0f/7.0f));
+    y = fma(y, s2, set1(1.0f/5.0f));
+    y = fma(y, s2, set1(1.0f/3.0f));
+    y = fma(y, s2, set1(1.0f));
+    return mul(y, s);
+}
+
+struct KExp {
+    static V run(V x, M &bad) {
+        bad = mor(mor(lt(x, set1(SIMD_EXP_LO)), gt(x, set1(SIMD_EXP_HI))), unord(x));
+        return exp_core(vmin(vmax(x, set1(SIMD_EXP_LO)), set1(SIMD_EXP_HI)));
+    }
+    static float scalar(float x) { return scalar_exp(x); }
+};
+
+struct KLog {
+    static V run(V x, M &bad) {
+        bad = mor(mor(lt(x, set1(1.17549435e-38f)), gt(x, set1(3.40282347e+38f))), unord(x));
+        return log_core(select(bad, set1(1.0f), x));
+    }
+    static float scalar(float x) { return scalar_log(x); }
+};
+
+struct KTanh {
+    static V run(V x, M &bad) {
+        bad = unord(x);
+        V a = vabs(x);
+
+        // |x| < 0.625: odd polynomial, free of the cancellation of the exp form
+        V z = mul(x, x);
+        V p = set1(-5.70498872745E-3f);
+        p = fma(p, z, set1(2.06390887954E-2f));
+        p = fma(p, z, set1(-5.37397155531E-2f));
+        p = fma(p, z, set1(1.33314422036E-1f));
+        p = fma(p, z, set1(-3.33332819422E-1f));
+        V ys = fma(mul(p, z), x, x);
+
+        // Otherwise 1 - 2/(exp(2|x|)+1), which rounds to 1 beyond |x| = 9.1
+        V e = exp_core(vmin(add(a, a), set1(20.0f)));
+        V yl = sign(sub(set1(1.0f), div(set1(2.0f), add(e, set1(1.0f)))), x);
+        return select(lt(a, set1(0.625f)), ys, yl);
+    }
+    static float scalar(float x) { return scalar_tanh(x); }
+};
+
+struct KSigmoid {
+    static V run(V x, M &bad) {
+        bad = mor(lt(x, set1(-SIMD_EXP_HI)), unord(x));
+        V e = exp_core(vmin(vmax(sub(set1(0.0f), x), set1(SIMD_EXP_LO)), set1(SIMD_EXP_HI)));
+        return div(set1(1.0f), add(set1(1.0f), e));
+    }
+    static float scalar(float x) { return scalar_sigmoid(x); }
+};
+
+struct KSoftplus {
+    static V run(V x, M &bad) {
+        // max(x, 0) + log(1 + exp(-|x|))
+        bad = mor(lt(x, set1(SIMD_EXP_LO)), unord(x));
+        V t = exp_core(vmax(sub(set1(0.0f), vabs(x)), set1(SIMD_EXP_LO)));
+        return add(vmax(x, set1(0.0f)), log1p_core(t));
+    }
+    static float scalar(float x) { return scalar_softplus(x); }
+};
+
+// y[i] = K(x[i]), i < n. x and y may be the same array
+template<typename K>
+static void vmap(const float *x, float *y, long int n) {
+    alignas(64) float buf[W];
+    long int i = 0;
+    for (; i + W <= n; i += W) {
+        M bad;
+        V r = K::run(load(x + i), bad);
+        int b = bits(bad);
+        if (b) {
+            // Out of range lanes (overflow, NaN, non-positive logs...) go through the scalar path
+            store(buf, r);
+            for (int k = 0; k < W; k++)
+                if ((b >> k) & 1) buf[k] = K::scalar(x[i + k]);
+            r = load(buf);
+        }
+        store(y + i, r);
+    }
+
+    if (i < n) {
+        // Tail through a padded copy, so every element gets the same approximation
+        int rest = (int)(n - i);
+        for (int k = 0; k < W; k++) buf[k] = (k < rest) ? x[i + k] : 0.0f;
+        M bad;
+        V r = K::run(load(buf), bad);
+        int b = bits(bad);
+        store(buf, r);
+        for (int k = 0; k < rest; k++) y[i + k] = ((b >> k) & 1) ? K::scalar(x[i + k]) : buf[k];
+    }
+}
+
+static void vexp(const float *x, float *y, long int n) { vmap<KExp>(x, y, n); }
+static void vlog(const float *x, float *y, long int n) { vmap<KLog>(x, y, n); }
+static void vtanh(const float *x, float *y, long int n) { vmap<KTanh>(x, y, n); }
+static void vsigmoid(const float *x, float *y, long int n) { vmap<KSigmoid>(x, y, n); }
+static void vsoftplus(const float *x, float *y, long int n) { vmap<KSoftplus>(x, y, n); }
+
+#undef SIMD_EXP_HI
+#undef SIMD_EXP_LO
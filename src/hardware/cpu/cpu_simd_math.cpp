@@ -0,0 +1,183 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include "eddl/hardware/cpu/cpu_tensor.h"
+
+// Vectorized exp, log, tanh, sigmoid and softplus over contiguous arrays.
+//
+// The AVX2 (+FMA) and AVX-512 versions are compiled with function-level target options, so the
+// library still runs on any x86-64; the instruction set is picked once at load time. Lanes out
+// of the polynomial range (overflow, underflow to denormals, NaN, log of non-positive numbers)
+// are recomputed with the scalar code, which is also the fallback of the other CPUs.
+
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_SIMD_X86
+#include <immintrin.h>
+#endif
+
+
+static inline float scalar_exp(float x) { return ::expf(x); }
+static inline float scalar_log(float x) { return ::logf(x); }
+static inline float scalar_tanh(float x) { return ::tanhf(x); }
+static inline float scalar_sigmoid(float x) { return 1.0f/(1.0f + ::expf(-x)); }
+static inline float scalar_softplus(float x) { return ::fmaxf(x, 0.0f) + ::log1pf(::expf(-::fabsf(x))); }
+
+namespace simd_scalar {
+    template<float (*F)(float)>
+    static void vmap(const float *x, float *y, long int n) {
+        for (long int i = 0; i < n; i++) y[i] = F(x[i]);
+    }
+
+    static void vexp(const float *x, float *y, long int n) { vmap<scalar_exp>(x, y, n); }
+    static void vlog(const float *x, float *y, long int n) { vmap<scalar_log>(x, y, n); }
+    static void vtanh(const float *x, float *y, long int n) { vmap<scalar_tanh>(x, y, n); }
+    static void vsigmoid(const float *x, float *y, long int n) { vmap<scalar_sigmoid>(x, y, n); }
+    static void vsoftplus(const float *x, float *y, long int n) { vmap<scalar_softplus>(x, y, n); }
+}
+
+#ifdef CPU_SIMD_X86
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace simd_avx2 {
+    typedef __m256 V;
+    typedef __m256 M;
+    enum { W = 8 };
+
+    static inline V set1(float a) { return _mm256_set1_ps(a); }
+    static inline V load(const float *p) { return _mm256_loadu_ps(p); }
+    static inline void store(float *p, V a) { _mm256_storeu_ps(p, a); }
+    static inline V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static inline V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static inline V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static inline V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static inline V fma(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    static inline V vmin(V a, V b) { return _mm256_min_ps(a, b); }
+    static inline V vmax(V a, V b) { return _mm256_max_ps(a, b); }
+    static inline V vabs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static inline V sign(V a, V s) { return _mm256_or_ps(vabs(a), _mm256_and_ps(_mm256_set1_ps(-0.0f), s)); }
+    static inline V vround(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static inline V pow2i(V a) {
+        __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(a), _mm256_set1_epi32(127));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+    }
+    static inline V exponent(V a) {
+        __m256i e = _mm256_srli_epi32(_mm256_castps_si256(a), 23);
+        return _mm256_cvtepi32_ps(_mm256_sub_epi32(e, _mm256_set1_epi32(126)));
+    }
+    static inline V mantissa(V a) {
+        __m256i m = _mm256_and_si256(_mm256_castps_si256(a), _mm256_set1_epi32(0x807fffff));
+        return _mm256_castsi256_ps(_mm256_or_si256(m, _mm256_set1_epi32(0x3f000000)));
+    }
+    static inline M lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static inline M gt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static inline M unord(V a) { return _mm256_cmp_ps(a, a, _CMP_UNORD_Q); }
+    static inline M mor(M a, M b) { return _mm256_or_ps(a, b); }
+    static inline V select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+    static inline int bits(M m) { return _mm256_movemask_ps(m); }
+
+#include "cpu_simd_kernels.h"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+namespace simd_avx512 {
+    typedef __m512 V;
+    typedef __mmask16 M;
+    enum { W = 16 };
+
+    static inline __m512 as_ps(__m512i a) { return _mm512_castsi512_ps(a); }
+    static inline __m512i as_si(__m512 a) { return _mm512_castps_si512(a); }
+
+    static inline V set1(float a) { return _mm512_set1_ps(a); }
+    static inline V load(const float *p) { return _mm512_loadu_ps(p); }
+    static inline void store(float *p, V a) { _mm512_storeu_ps(p, a); }
+    static inline V add(V a, V b) { return _mm512_add_ps(a, b); }
+    static inline V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+    static inline V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+    static inline V div(V a, V b) { return _mm512_div_ps(a, b); }
+    static inline V fma(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+    static inline V vmin(V a, V b) { return _mm512_min_ps(a, b); }
+    static inline V vmax(V a, V b) { return _mm512_max_ps(a, b); }
+    static inline V vabs(V a) { return as_ps(_mm512_and_epi32(as_si(a), _mm512_set1_epi32(0x7fffffff))); }
+    static inline V sign(V a, V s) {
+        __m512i sb = _mm512_and_epi32(as_si(s), _mm512_set1_epi32(0x80000000));
+        return as_ps(_mm512_or_epi32(as_si(vabs(a)), sb));
+    }
+    static inline V vround(V a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static inline V pow2i(V a) {
+        __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(a), _mm512_set1_epi32(127));
+        return as_ps(_mm512_slli_epi32(e, 23));
+    }
+    static inline V exponent(V a) {
+        __m512i e = _mm512_srli_epi32(as_si(a), 23);
+        return _mm512_cvtepi32_ps(_mm512_sub_epi32(e, _mm512_set1_epi32(126)));
+    }
+    static inline V mantissa(V a) {
+        __m512i m = _mm512_and_epi32(as_si(a), _mm512_set1_epi32(0x807fffff));
+        return as_ps(_mm512_or_epi32(m, _mm512_set1_epi32(0x3f000000)));
+    }
+    static inline M lt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static inline M gt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static inline M unord(V a) { return _mm512_cmp_ps_mask(a, a, _CMP_UNORD_Q); }
+    static inline M mor(M a, M b) { return (M)(a | b); }
+    static inline V select(M m, V a, V b) { return _mm512_mask_blend_ps(m, b, a); }
+    static inline int bits(M m) { return (int)m; }
+
+#include "cpu_simd_kernels.h"
+}
+#pragma GCC pop_options
+
+#endif
+
+
+typedef void (*cpu_vfunc)(const float *x, float *y, long int n);
+
+struct CpuVFuncs {
+    cpu_vfunc exp, log, tanh, sigmoid, softplus;
+};
+
+static const CpuVFuncs cpu_vfuncs[] = {
+    {simd_scalar::vexp, simd_scalar::vlog, simd_scalar::vtanh, simd_scalar::vsigmoid, simd_scalar::vsoftplus},
+#ifdef CPU_SIMD_X86
+    {simd_avx2::vexp, simd_avx2::vlog, simd_avx2::vtanh, simd_avx2::vsigmoid, simd_avx2::vsoftplus},
+    {simd_avx512::vexp, simd_avx512::vlog, simd_avx512::vtanh, simd_avx512::vsigmoid, simd_avx512::vsoftplus},
+#endif
+};
+
+static int cpu_detect_isa() {
+#ifdef CPU_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return CPU_ISA_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return CPU_ISA_AVX2;
+#endif
+    return CPU_ISA_SCALAR;
+}
+
+static const int cpu_supported_isa = cpu_detect_isa();
+static int cpu_active_isa = cpu_supported_isa;
+
+int cpu_isa() {
+    return cpu_active_isa;
+}
+
+int cpu_set_isa(int isa) {
+    cpu_active_isa = std::max(CPU_ISA_SCALAR, std::min(isa, cpu_supported_isa));
+    return cpu_active_isa;
+}
+
+void cpu_vexp(const float *x, float *y, long int n) { cpu_vfuncs[cpu_active_isa].exp(x, y, n); }
+void cpu_vlog(const float *x, float *y, long int n) { cpu_vfuncs[cpu_active_isa].log(x, y, n); }
+void cpu_vtanh(const float *x, float *y, long int n) { cpu_vfuncs[cpu_active_isa].tanh(x, y, n); }
+void cpu_vsigmoid(const float *x, float *y, long int n) { cpu_vfuncs[cpu_active_isa].sigmoid(x, y, n); }
+void cpu_vsoftplus(const float *x, float *y, long int n) { cpu_vfuncs[cpu_active_isa].softplus(x, y, n); }
@@ -11,12 +11,14 @@
 #include <cstdio>      /* printf, scanf, NULL */
 #include <cstdlib>     /* malloc, free, rand */
 #include <iostream>
+#include <algorithm>
 
 #include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
 
 void cpu_relu(Tensor *A, Tensor *B){
     _profile(_CPU_RELU, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++) {
         if (A->ptr[i] > 0.0) B->ptr[i] = A->ptr[i];
         else B->ptr[i] = 0.0;
@@ -26,7 +28,7 @@ void cpu_relu(Tensor *A, Tensor *B){
 
 void cpu_d_relu(Tensor *D, Tensor *I, Tensor *PD){
     _profile(_CPU_D_RELU, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++) {
         if (I->ptr[i] > 0.0) PD->ptr[i] += D->ptr[i];
         else PD->ptr[i] += 0.0;
@@ -36,7 +38,7 @@ void cpu_d_relu(Tensor *D, Tensor *I, Tensor *PD){
 
 void cpu_thresholded_relu(Tensor *A, Tensor *B,float param){
     _profile(_CPU_THRESHOLDED_RELU, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++) {
         if (A->ptr[i] > param) B->ptr[i] = A->ptr[i];
         else B->ptr[i] = 0.0;
@@ -46,7 +48,7 @@ void cpu_thresholded_relu(Tensor *A, Tensor *B,float param){
 
 void cpu_d_thresholded_relu(Tensor *D, Tensor *I, Tensor *PD,float param){
     _profile(_CPU_D_THRESHOLDED_RELU, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++) {
         if (I->ptr[i] > param) PD->ptr[i] += D->ptr[i];
         else PD->ptr[i] += 0.0;
@@ -56,7 +58,7 @@ void cpu_d_thresholded_relu(Tensor *D, Tensor *I, Tensor *PD,float param){
 
 void cpu_leaky_relu(Tensor *A, Tensor *B,float param){
     _profile(_CPU_LEAKY_RELU, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++) {
         if (A->ptr[i] > 0.0) B->ptr[i] = A->ptr[i];
         else B->ptr[i] = param*A->ptr[i];;
@@ -66,7 +68,7 @@ void cpu_leaky_relu(Tensor *A, Tensor *B,float param){
 
 void cpu_d_leaky_relu(Tensor *D, Tensor *I, Tensor *PD,float param){
     _profile(_CPU_D_LEAKY_RELU, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++) {
         if (I->ptr[i] > 0.0) PD->ptr[i] += D->ptr[i];
         else PD->ptr[i] += param*D->ptr[i];
@@ -76,45 +78,60 @@ void cpu_d_leaky_relu(Tensor *D, Tensor *I, Tensor *PD,float param){
 
 void cpu_elu(Tensor *A, Tensor *B, float param){
     _profile(_CPU_ELU, 0);
-#pragma omp parallel for
-    for (int i = 0; i < A->size; i++) {
-        if (A->ptr[i] > 0.0) B->ptr[i] = A->ptr[i];
-        else B->ptr[i] = param * (::expf(A->ptr[i]) - 1.0);
+    long int size = A->size;
+#pragma omp parallel for CPU_PARALLEL(size)
+    for (long int s = 0; s < size; s += CPU_VBLOCK) {
+        int n = std::min<long int>(CPU_VBLOCK, size - s);
+        float e[CPU_VBLOCK];
+        cpu_vexp(A->ptr + s, e, n);
+        for (int i = 0; i < n; i++) {
+            if (A->ptr[s + i] > 0.0) B->ptr[s + i] = A->ptr[s + i];
+            else B->ptr[s + i] = param * (e[i] - 1.0f);
+        }
     }
     _profile(_CPU_ELU, 1);
 }
 
 void cpu_d_elu(Tensor *D, Tensor *I, Tensor *PD, float param){
     _profile(_CPU_D_ELU, 0);
-#pragma omp parallel for
-    for (int i = 0; i < D->size; i++) {
-        if (I->ptr[i] > 0.0) PD->ptr[i] += D->ptr[i];
-        else PD->ptr[i] += D->ptr[i] * (param * ::expf(I->ptr[i]));
+    long int size = D->size;
+#pragma omp parallel for CPU_PARALLEL(size)
+    for (long int s = 0; s < size; s += CPU_VBLOCK) {
+        int n = std::min<long int>(CPU_VBLOCK, size - s);
+        float e[CPU_VBLOCK];
+        cpu_vexp(I->ptr + s, e, n);
+        for (int i = 0; i < n; i++) {
+            if (I->ptr[s + i] > 0.0) PD->ptr[s + i] += D->ptr[s + i];
+            else PD->ptr[s + i] += D->ptr[s + i] * (param * e[i]);
+        }
     }
     _profile(_CPU_D_ELU, 1);
 }
 
 void cpu_softplus(Tensor *A, Tensor *B){
     _profile(_CPU_SOFTPLUS, 0);
-#pragma omp parallel for
-    for (int i = 0; i < A->size; i++) {
-        B->ptr[i] = ::logf(1 + ::expf(A->ptr[i]));
-    }
+    long int size = A->size;
+#pragma omp parallel for CPU_PARALLEL(size)
+    for (long int i = 0; i < size; i += CPU_VBLOCK) cpu_vsoftplus(A->ptr + i, B->ptr + i, std::min<long int>(CPU_VBLOCK, size - i));
     _profile(_CPU_SOFTPLUS, 1);
 }
 
 void cpu_d_softplus(Tensor *D, Tensor *I, Tensor *PD){
     _profile(_CPU_D_SOFTPLUS, 0);
-#pragma omp parallel for
-    for (int i = 0; i < D->size; i++) {
-        PD->ptr[i] += D->ptr[i] * 1/(1 + ::expf(-I->ptr[i]));
+    long int size = D->size;
+#pragma omp parallel for CPU_PARALLEL(size)
+    for (long int s = 0; s < size; s += CPU_VBLOCK) {
+        int n = std::min<long int>(CPU_VBLOCK, size - s);
+        float sg[CPU_VBLOCK];
+        cpu_vsigmoid(I->ptr + s, sg, n);
+        for (int i = 0; i < n; i++) PD->ptr[s + i] += D->ptr[s + i] * sg[i];
     }
     _profile(_CPU_D_SOFTPLUS, 1);
 }
 
 void cpu_softsign(Tensor *A, Tensor *B){
     _profile(_CPU_SOFTSIGN, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++) {
         B->ptr[i] = A->ptr[i] / (1 + ::fabs(A->ptr[i]));
     }
@@ -123,7 +140,7 @@ void cpu_softsign(Tensor *A, Tensor *B){
 
 void cpu_d_softsign(Tensor *D, Tensor *I, Tensor *PD){
     _profile(_CPU_D_SOFTSIGN, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++) {
         float denom = 1 + ::fabs(I->ptr[i]);
         PD->ptr[i] += D->ptr[i] * 1/(denom*denom);
@@ -133,7 +150,7 @@ void cpu_d_softsign(Tensor *D, Tensor *I, Tensor *PD){
 
 void cpu_linear(Tensor *A, Tensor *B, float param){
     _profile(_CPU_LINEAR, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++) {
         B->ptr[i] = param * A->ptr[i];
     }
@@ -142,7 +159,7 @@ void cpu_linear(Tensor *A, Tensor *B, float param){
 
 void cpu_d_linear(Tensor *D, Tensor *I, Tensor *PD, float param){
     _profile(_CPU_D_LINEAR, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++) {
         PD->ptr[i] += D->ptr[i] * param;
     }
@@ -159,7 +176,7 @@ void cpu_d_linear(Tensor *D, Tensor *I, Tensor *PD, float param){
 
 void cpu_d_sigmoid(Tensor *D, Tensor *I, Tensor *PD){
     _profile(_CPU_D_SIGMOID, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++)
         PD->ptr[i] += D->ptr[i]*((1-I->ptr[i])*I->ptr[i]);
     _profile(_CPU_D_SIGMOID, 1);
@@ -167,7 +184,7 @@ void cpu_d_sigmoid(Tensor *D, Tensor *I, Tensor *PD){
 
 void cpu_hard_sigmoid(Tensor *A, Tensor *B){
     _profile(_CPU_HARD_SIGMOID, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(A->size)
     for (int i = 0; i < A->size; i++) {
         if (A->ptr[i] > 2.5) B->ptr[i] = 1.0;
         else if (A->ptr[i] < -2.5) B->ptr[i] = 0.0;
@@ -178,7 +195,7 @@ void cpu_hard_sigmoid(Tensor *A, Tensor *B){
 
 void cpu_d_hard_sigmoid(Tensor *D, Tensor *I, Tensor *PD){
     _profile(_CPU_D_HARD_SIGMOID, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++)
         if (I->ptr[i] < -2.5 || I->ptr[i] > 2.5) PD->ptr[i] += 0;
         else PD->ptr[i] += D->ptr[i] * 0.2;
@@ -196,7 +213,7 @@ void cpu_d_hard_sigmoid(Tensor *D, Tensor *I, Tensor *PD){
 
 void cpu_d_exp(Tensor *D, Tensor *I, Tensor *PD){
     _profile(_CPU_D_EXP, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++)
         PD->ptr[i] += D->ptr[i] * I->ptr[i];
     _profile(_CPU_D_EXP, 1);
@@ -215,12 +232,31 @@ void cpu_d_exp(Tensor *D, Tensor *I, Tensor *PD){
 
 void cpu_d_tanh(Tensor *D, Tensor *I, Tensor *PD){
     _profile(_CPU_D_TANH, 0);
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++)
         PD->ptr[i] += D->ptr[i]*(1-(I->ptr[i]*I->ptr[i]));
     _profile(_CPU_D_TANH, 1);
 }
 
+void cpu_d_activation_inplace(Tensor *D, Tensor *O, int act, float param){
+    _profile(_CPU_D_ACTIVATION_INPLACE, 0);
+    float *ptrO=O->ptr;
+    float *ptrD=D->ptr;
+
+#pragma omp parallel for CPU_PARALLEL(D->size)
+    for (long int i = 0; i < D->size; i++) {
+        float y=ptrO[i];
+        switch (act) {
+            case ConvActReLU: if (y <= 0.0f) ptrD[i]=0.0f; break;
+            case ConvActLeakyReLU: if (y <= 0.0f) ptrD[i]*=param; break;
+            case ConvActSigmoid: ptrD[i]*=y*(1.0f-y); break;
+            case ConvActTanh: ptrD[i]*=1.0f-y*y; break;
+            default: break;
+        }
+    }
+    _profile(_CPU_D_ACTIVATION_INPLACE, 1);
+}
+
 
 void cpu_softmax(Tensor *A, Tensor *B) {
     _profile(_CPU_SOFTMAX, 0);
@@ -243,7 +279,7 @@ void cpu_d_softmax(Tensor *D, Tensor *I, Tensor *PD) {
     _profile(_CPU_D_SOFTMAX, 0);
 
 
-#pragma omp parallel for
+#pragma omp parallel for CPU_PARALLEL(D->size)
     for (int i = 0; i < D->size; i++)
         PD->ptr[i] += D->ptr[i] * (I->ptr[i] * (1.0 - I->ptr[i]));
 
@@ -266,7 +302,7 @@ void cpu_full_softmax_batched_2d(Tensor *A, Tensor *B, bool stable){
     int n_batches = A->shape[0];
     int n_features = A->shape[1];
 
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for(int bi=0; bi<n_batches; bi++){
         // Contiguous data
         int start = bi*n_features;
@@ -305,7 +341,7 @@ void cpu_full_softmax_nd(Tensor *A, Tensor *B, int axis, bool stable){
     int k_stride = (chuck_size-1)*A->stride[axis];
 
 
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(A->size)
     for(int si=0; si<n_samples; si++) {  // n chucks
             int start_b = si % inner_stride + si/inner_stride * sample_stride;
             int end_b = start_b + k_stride;
@@ -327,10 +363,18 @@ void cpu_full_softmax_nd(Tensor *A, Tensor *B, int axis, bool stable){
 
             // Numerator
             float denominator = CPU_EPS_FLOAT;
-            for (int i = start_b; i <= end_b; i += inner_stride) {
-                float value = ::expf(A->ptr[i] - max_value);  // Highest number should be zero
-                B->ptr[i] = value;
-                denominator += value;
+            if (inner_stride == 1) {
+                // Contiguous axis: one vectorized exp over the whole chunk
+                for (int i = start_b; i <= end_b; i++) B->ptr[i] = A->ptr[i] - max_value;
+                cpu_vexp(B->ptr + start_b, B->ptr + start_b, chuck_size);
+                for (int i = start_b; i <= end_b; i++) denominator += B->ptr[i];
+            }
+            else {
+                for (int i = start_b; i <= end_b; i += inner_stride) {
+                    float value = ::expf(A->ptr[i] - max_value);  // Highest number should be zero
+                    B->ptr[i] = value;
+                    denominator += value;
+                }
             }
 
             // Softmax
@@ -340,6 +384,32 @@ void cpu_full_softmax_nd(Tensor *A, Tensor *B, int axis, bool stable){
     }
 }
 
+void cpu_softmax_lse(Tensor *A, Tensor *B, Tensor *LSE){
+    int n = A->shape[A->ndim-1];
+    int rows = A->size/n;
+
+    #pragma omp parallel for CPU_PARALLEL(A->size)
+    for(int r=0; r<rows; r++) {
+        const float *a = A->ptr + (long int)r*n;
+        float *b = B->ptr + (long int)r*n;
+
+        float max_value = CPU_LOWEST_FLOAT;
+        for (int j = 0; j < n; j++) max_value = std::max(max_value, a[j]);
+
+        for (int j = 0; j < n; j++) b[j] = a[j] - max_value;
+        cpu_vexp(b, b, n);
+
+        float denominator = 0.0f;
+        #pragma omp simd reduction(+:denominator)
+        for (int j = 0; j < n; j++) denominator += b[j];
+
+        float inv = 1.0f/denominator;
+        for (int j = 0; j < n; j++) b[j] *= inv;
+
+        LSE->ptr[r] = max_value + ::logf(denominator);
+    }
+}
+
 void cpu_d_full_softmax(Tensor *D, Tensor *I, Tensor *PD, int axis) {
     cpu_d_full_softmax_nd(D, I, PD, axis);
 //
@@ -356,7 +426,7 @@ void cpu_d_full_softmax_batched_2d(Tensor *D, Tensor *I, Tensor *PD) {
     int n_batches = D->shape[0];
     int n_features = D->shape[1];
 
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(D->size)
     for(int bi=0; bi<n_batches; bi++){
         // Contiguous data
         int start = bi*n_features;
@@ -385,7 +455,7 @@ void cpu_d_full_softmax_nd(Tensor *D, Tensor *I, Tensor *PD, int axis) {
     int sample_stride = chuck_size*D->stride[axis];
     int k_stride = (chuck_size-1)*D->stride[axis];
 
-    #pragma omp parallel for
+    #pragma omp parallel for CPU_PARALLEL(D->size)
     for(int si=0; si<n_samples; si++) {  // n chucks
         int start_b = si % inner_stride + si/inner_stride * sample_stride;
         int end_b = start_b + k_stride;
@@ -11,8 +11,13 @@
 #include <cstdio>      /* printf, scanf, NULL */
 #include <cstdlib>     /* malloc, free, rand */
 #include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <omp.h>
 
 #include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
 
 
 // BN
@@ -113,3 +118,402 @@ void cpu_permute_batch_first(Tensor *A,Tensor *B)
     _profile(_CPU_PERMUTE_BATCH_FIRST, 1);
 
 }
+
+
+// Native BatchNorm. The input is seen as {B, C, S}: the values of channel c in sample b are
+// the run of S floats at (b*C+c)*S. Channels-first 4D tensors have S=H*W; 2D and channels-last
+// tensors have S=1 (B=N*H*W rows of C channels), so no permutation is needed in any case.
+static void bn_dims(Tensor *A, bool channels_last, int &B, int &C, int &S) {
+    C=A->shape[1];
+    S=((A->ndim==4) && !channels_last) ? A->shape[2]*A->shape[3] : 1;
+    B=A->size/(C*S);
+}
+
+// Merges the mean and sum of squared deviations (mb, m2b) of nb values into (n, ma, m2a) (Chan et al.)
+static inline void bn_merge(long int &n, float &ma, float &m2a, long int nb, float mb, float m2b) {
+    if (nb==0) return;
+    long int nab=n+nb;
+    float d=mb-ma;
+    ma+=d*((float)nb/nab);
+    m2a+=m2b+d*d*((float)n*nb/nab);
+    n=nab;
+}
+
+// Per channel mean and M2 in one pass over the input (Welford)
+static void bn_stats(const float *x, int B, int C, int S, float *mean, float *m2) {
+    long int total=(long int)B*C*S;
+
+    if (S>1) {
+        // Each run is reduced while in cache and merged into its channel
+        #pragma omp parallel for CPU_PARALLEL(total)
+        for(int c=0; c<C; c++) {
+            long int n=0;
+            float ma=0.0f, m2a=0.0f;
+            for(int b=0; b<B; b++) {
+                const float *p=x+((long int)b*C+c)*S;
+                float sum=0.0f;
+                #pragma omp simd reduction(+:sum)
+                for(int s=0; s<S; s++) sum+=p[s];
+                float mb=sum/S, sq=0.0f;
+                #pragma omp simd reduction(+:sq)
+                for(int s=0; s<S; s++) sq+=(p[s]-mb)*(p[s]-mb);
+                bn_merge(n, ma, m2a, S, mb, sq);
+            }
+            mean[c]=ma;
+            m2[c]=m2a;
+        }
+        return;
+    }
+
+    // Rows of C channels: each thread runs Welford over a range of rows (vectorized over the
+    // channels) and the partial results are merged in order
+    int nth=std::min(cpu_threads(total), B);
+    vector<float> pm((long int)nth*C, 0.0f), pv((long int)nth*C, 0.0f);
+    #pragma omp parallel for num_threads(nth) schedule(static,1)
+    for(int t=0; t<nth; t++) {
+        int r0=(int)((long int)B*t/nth), r1=(int)((long int)B*(t+1)/nth);
+        float *m=&pm[(long int)t*C], *v=&pv[(long int)t*C];
+        for(int r=r0; r<r1; r++) {
+            const float *p=x+(long int)r*C;
+            float inv=1.0f/(r-r0+1);
+            #pragma omp simd
+            for(int c=0; c<C; c++) {
+                float d=p[c]-m[c];
+                m[c]+=d*inv;
+                v[c]+=d*(p[c]-m[c]);
+            }
+        }
+    }
+    for(int c=0; c<C; c++) {
+        long int n=0;
+        float ma=0.0f, m2a=0.0f;
+        for(int t=0; t<nth; t++) {
+            long int nb=(long int)B*(t+1)/nth-(long int)B*t/nth;
+            bn_merge(n, ma, m2a, nb, pm[(long int)t*C+c], pv[(long int)t*C+c]);
+        }
+        mean[c]=ma;
+        m2[c]=m2a;
+    }
+}
+
+void cpu_batchnorm_forward(Tensor *X, Tensor *Y, Tensor *opa, Tensor *mean, Tensor *variance, Tensor *bn_g, Tensor *bn_b,
+                           Tensor *bn_mean, Tensor *bn_var, bool trmode, float epsilon, float momentum, bool channels_last)
+{
+    _profile(_CPU_BATCHNORM_FORWARD, 0);
+    int B,C,S;
+    bn_dims(X, channels_last, B, C, S);
+    long int total=(long int)B*C*S;
+
+    // bn_mean and bn_var keep the statistics used to normalize (bn_var as sqrt(var+eps))
+    float *m=bn_mean->ptr, *sd=bn_var->ptr;
+    if (trmode) {
+        bn_stats(X->ptr, B, C, S, m, sd);
+        long int N=(long int)B*S;
+        for(int c=0; c<C; c++) {
+            float var=sd[c]/N;
+            if (momentum!=0.0) {
+                mean->ptr[c]=momentum*mean->ptr[c]+(1.0f-momentum)*m[c];
+                variance->ptr[c]=momentum*variance->ptr[c]+(1.0f-momentum)*var;
+            }
+            sd[c]=sqrtf(var+epsilon);
+        }
+    }
+    else {
+        m=mean->ptr;
+        for(int c=0; c<C; c++) sd[c]=sqrtf(variance->ptr[c]+epsilon);
+    }
+
+    // Normalize and scale/shift in the same pass: opa=(x-mean)/sd, y=gamma*opa+beta
+    vector<float> inv(C), g(C, 1.0f), bt(C, 0.0f);
+    for(int c=0; c<C; c++) inv[c]=1.0f/sd[c];
+    if (bn_g!=nullptr) {
+        for(int c=0; c<C; c++) { g[c]=bn_g->ptr[c]; bt[c]=bn_b->ptr[c]; }
+    }
+
+    const float *x=X->ptr;
+    float *y=Y->ptr, *o=opa->ptr;
+    if (S>1) {
+        #pragma omp parallel for CPU_PARALLEL(total)
+        for(long int bc=0; bc<(long int)B*C; bc++) {
+            int c=(int)(bc%C);
+            float mc=m[c], ic=inv[c], gc=g[c], bc_=bt[c];
+            const float *p=x+bc*S;
+            float *po=o+bc*S, *py=y+bc*S;
+            #pragma omp simd
+            for(int s=0; s<S; s++) {
+                float v=(p[s]-mc)*ic;
+                po[s]=v;
+                py[s]=gc*v+bc_;
+            }
+        }
+    }
+    else {
+        const float *pm=m, *pi=inv.data(), *pg=g.data(), *pb=bt.data();
+        #pragma omp parallel for CPU_PARALLEL(total)
+        for(int r=0; r<B; r++) {
+            const float *p=x+(long int)r*C;
+            float *po=o+(long int)r*C, *py=y+(long int)r*C;
+            #pragma omp simd
+            for(int c=0; c<C; c++) {
+                float v=(p[c]-pm[c])*pi[c];
+                po[c]=v;
+                py[c]=pg[c]*v+pb[c];
+            }
+        }
+    }
+    _profile(_CPU_BATCHNORM_FORWARD, 1);
+}
+
+void cpu_batchnorm_backward(Tensor *D, Tensor *opa, Tensor *PD, Tensor *bn_g, Tensor *bn_var, Tensor *gbn_g, Tensor *gbn_b, bool channels_last)
+{
+    _profile(_CPU_BATCHNORM_BACKWARD, 0);
+    int B,C,S;
+    bn_dims(D, channels_last, B, C, S);
+    long int total=(long int)B*C*S;
+    long int N=(long int)B*S;
+    const float *dy=D->ptr, *xh=opa->ptr;
+
+    // Pass 1: per channel sum(dy) and sum(dy*xhat)
+    vector<float> sdy(C, 0.0f), sdx(C, 0.0f);
+    if (S>1) {
+        #pragma omp parallel for CPU_PARALLEL(total)
+        for(int c=0; c<C; c++) {
+            float a=0.0f, b_=0.0f;
+            for(int b=0; b<B; b++) {
+                long int o=((long int)b*C+c)*S;
+                #pragma omp simd reduction(+:a,b_)
+                for(int s=0; s<S; s++) {
+                    a+=dy[o+s];
+                    b_+=dy[o+s]*xh[o+s];
+                }
+            }
+            sdy[c]=a;
+            sdx[c]=b_;
+        }
+    }
+    else {
+        int nth=std::min(cpu_threads(total), B);
+        vector<float> pa((long int)nth*C, 0.0f), pb((long int)nth*C, 0.0f);
+        #pragma omp parallel for num_threads(nth) schedule(static,1)
+        for(int t=0; t<nth; t++) {
+            int r0=(int)((long int)B*t/nth), r1=(int)((long int)B*(t+1)/nth);
+            float *a=&pa[(long int)t*C], *b_=&pb[(long int)t*C];
+            for(int r=r0; r<r1; r++) {
+                const float *pd=dy+(long int)r*C, *px=xh+(long int)r*C;
+                #pragma omp simd
+                for(int c=0; c<C; c++) {
+                    a[c]+=pd[c];
+                    b_[c]+=pd[c]*px[c];
+                }
+            }
+        }
+        for(int t=0; t<nth; t++)
+            for(int c=0; c<C; c++) {
+                sdy[c]+=pa[(long int)t*C+c];
+                sdx[c]+=pb[(long int)t*C+c];
+            }
+    }
+
+    // Gradients of gamma and beta (batch means, as the other devices do) and the coefficients
+    // of dx = gamma/sd * (dy - mean(dy) - mean(dy*xhat)*xhat)
+    vector<float> k(C), mdy(C), mdx(C);
+    for(int c=0; c<C; c++) {
+        mdy[c]=sdy[c]/N;
+        mdx[c]=sdx[c]/N;
+        if (gbn_g!=nullptr) {
+            gbn_g->ptr[c]+=mdx[c];
+            gbn_b->ptr[c]+=mdy[c];
+        }
+        k[c]=((bn_g!=nullptr) ? bn_g->ptr[c] : 1.0f)/bn_var->ptr[c];
+    }
+
+    // Pass 2: accumulate into the parent delta
+    float *pd=PD->ptr;
+    if (S>1) {
+        #pragma omp parallel for CPU_PARALLEL(total)
+        for(long int bc=0; bc<(long int)B*C; bc++) {
+            int c=(int)(bc%C);
+            float kc=k[c], ac=mdy[c], bc_=mdx[c];
+            long int o=bc*S;
+            #pragma omp simd
+            for(int s=0; s<S; s++) pd[o+s]+=kc*(dy[o+s]-ac-bc_*xh[o+s]);
+        }
+    }
+    else {
+        const float *pk=k.data(), *pa=mdy.data(), *pb=mdx.data();
+        #pragma omp parallel for CPU_PARALLEL(total)
+        for(int r=0; r<B; r++) {
+            long int o=(long int)r*C;
+            #pragma omp simd
+            for(int c=0; c<C; c++) pd[o+c]+=pk[c]*(dy[o+c]-pa[c]-pb[c]*xh[o+c]);
+        }
+    }
+    _profile(_CPU_BATCHNORM_BACKWARD, 1);
+}
+
+
+// Native LayerNorm. Each of the mean->size rows of X is normalized with its own statistics.
+// The affine g/b (if any) has K entries, each one applied to a block of L/K consecutive values
+// of every row: per element for LayerNorm (K=L), per channel of the group for GroupNorm.
+static void ln_dims(Tensor *X, Tensor *mean, Tensor *g, int &R, int &L, int &K, int &S) {
+    R=mean->size;
+    L=X->size/R;
+    K=(g!=nullptr) ? g->size : L;
+    S=L/K;
+}
+
+void cpu_layernorm_forward(Tensor *X, Tensor *Y, Tensor *opa, Tensor *mean, Tensor *sd, Tensor *g, Tensor *b, float epsilon)
+{
+    _profile(_CPU_LAYERNORM_FORWARD, 0);
+    int R,L,K,S;
+    ln_dims(X, mean, g, R, L, K, S);
+
+    #pragma omp parallel for CPU_PARALLEL(X->size)
+    for(int r=0; r<R; r++) {
+        const float *x=X->ptr+(long int)r*L;
+        float *o=opa->ptr+(long int)r*L, *y=Y->ptr+(long int)r*L;
+
+        // Stats in one pass, shifted by the first value to avoid cancellation
+        float x0=x[0], sum=0.0f, sq=0.0f;
+        #pragma omp simd reduction(+:sum,sq)
+        for(int j=0; j<L; j++) {
+            float d=x[j]-x0;
+            sum+=d;
+            sq+=d*d;
+        }
+        float m=sum/L;
+        float var=std::max(sq/L-m*m, 0.0f);
+        m+=x0;
+        float s=sqrtf(var+epsilon), inv=1.0f/s;
+        mean->ptr[r]=m;
+        sd->ptr[r]=s;
+
+        // Normalize and scale/shift
+        if (g==nullptr) {
+            #pragma omp simd
+            for(int j=0; j<L; j++) {
+                float v=(x[j]-m)*inv;
+                o[j]=v;
+                y[j]=v;
+            }
+        }
+        else if (S==1) {
+            const float *pg=g->ptr, *pb=b->ptr;
+            #pragma omp simd
+            for(int j=0; j<L; j++) {
+                float v=(x[j]-m)*inv;
+                o[j]=v;
+                y[j]=pg[j]*v+pb[j];
+            }
+        }
+        else {
+            for(int k=0; k<K; k++) {
+                float gk=g->ptr[k], bk=b->ptr[k];
+                long int j0=(long int)k*S;
+                #pragma omp simd
+                for(int j=0; j<S; j++) {
+                    float v=(x[j0+j]-m)*inv;
+                    o[j0+j]=v;
+                    y[j0+j]=gk*v+bk;
+                }
+            }
+        }
+    }
+    _profile(_CPU_LAYERNORM_FORWARD, 1);
+}
+
+void cpu_layernorm_backward(Tensor *D, Tensor *opa, Tensor *PD, Tensor *sd, Tensor *g, Tensor *gg, Tensor *gb)
+{
+    _profile(_CPU_LAYERNORM_BACKWARD, 0);
+    int R,L,K,S;
+    ln_dims(D, sd, g, R, L, K, S);
+
+    // Gradients of g and b are accumulated per thread and merged in order
+    int nth=std::min(cpu_threads(D->size), R);
+    vector<float> pg, pb;
+    if (gg!=nullptr) {
+        pg.assign((long int)nth*K, 0.0f);
+        pb.assign((long int)nth*K, 0.0f);
+    }
+
+    #pragma omp parallel for num_threads(nth) schedule(static,1)
+    for(int t=0; t<nth; t++) {
+        int r0=(int)((long int)R*t/nth), r1=(int)((long int)R*(t+1)/nth);
+        for(int r=r0; r<r1; r++) {
+            const float *dy=D->ptr+(long int)r*L, *xh=opa->ptr+(long int)r*L;
+            float *pd=PD->ptr+(long int)r*L;
+
+            // Pass 1: sum(dp) and sum(dp*xhat) with dp=g*dy, plus the affine gradients
+            float a=0.0f, c=0.0f;
+            if (g==nullptr) {
+                #pragma omp simd reduction(+:a,c)
+                for(int j=0; j<L; j++) {
+                    a+=dy[j];
+                    c+=dy[j]*xh[j];
+                }
+            }
+            else if (S==1) {
+                const float *p=g->ptr;
+                float *tg=&pg[(long int)t*K], *tb=&pb[(long int)t*K];
+                #pragma omp simd reduction(+:a,c)
+                for(int j=0; j<L; j++) {
+                    float dx=dy[j]*xh[j];
+                    tg[j]+=dx;
+                    tb[j]+=dy[j];
+                    a+=p[j]*dy[j];
+                    c+=p[j]*dx;
+                }
+            }
+            else {
+                for(int k=0; k<K; k++) {
+                    long int j0=(long int)k*S;
+                    float sdy=0.0f, sdx=0.0f;
+                    #pragma omp simd reduction(+:sdy,sdx)
+                    for(int j=0; j<S; j++) {
+                        sdy+=dy[j0+j];
+                        sdx+=dy[j0+j]*xh[j0+j];
+                    }
+                    pg[(long int)t*K+k]+=sdx;
+                    pb[(long int)t*K+k]+=sdy;
+                    a+=g->ptr[k]*sdy;
+                    c+=g->ptr[k]*sdx;
+                }
+            }
+
+            // Pass 2: pd += (dp - mean(dp) - mean(dp*xhat)*xhat)/sd
+            float ma=a/L, mc=c/L, inv=1.0f/sd->ptr[r];
+            if (g==nullptr) {
+                #pragma omp simd
+                for(int j=0; j<L; j++) pd[j]+=(dy[j]-ma-mc*xh[j])*inv;
+            }
+            else if (S==1) {
+                const float *p=g->ptr;
+                #pragma omp simd
+                for(int j=0; j<L; j++) pd[j]+=(p[j]*dy[j]-ma-mc*xh[j])*inv;
+            }
+            else {
+                for(int k=0; k<K; k++) {
+                    float gk=g->ptr[k];
+                    long int j0=(long int)k*S;
+                    #pragma omp simd
+                    for(int j=0; j<S; j++) pd[j0+j]+=(gk*dy[j0+j]-ma-mc*xh[j0+j])*inv;
+                }
+            }
+        }
+    }
+
+    // Affine gradients are means over all the values each entry was applied to
+    if (gg!=nullptr) {
+        float n=(float)R*S;
+        for(int k=0; k<K; k++) {
+            float sg=0.0f, sb=0.0f;
+            for(int t=0; t<nth; t++) {
+                sg+=pg[(long int)t*K+k];
+                sb+=pb[(long int)t*K+k];
+            }
+            gg->ptr[k]+=sg/n;
+            gb->ptr[k]+=sb/n;
+        }
+    }
+    _profile(_CPU_LAYERNORM_BACKWARD, 1);
+}
@@ -10,9 +10,17 @@
 #include <cstdio>      /* printf, scanf, NULL */
 #include <cstdlib>     /* malloc, free, rand */
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 #include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Channels-last maps are (r*c x z) row-major matrices
+typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> MatrixRXf;
 
 float get_pixel(int b,int px,int py,int pz,ConvolDescriptor *D,int isize,int irsize) {
   // Check boundaries of the window
@@ -22,7 +30,9 @@ float get_pixel(int b,int px,int py,int pz,ConvolDescriptor *D,int isize,int irs
   if (py>=D->ir) return 0.0;
 
   // Compute address from indices (row-major)
-  unsigned int address = (b*isize) + (pz*irsize) + (py*D->ic) + px;
+  unsigned int address;
+  if (D->layout_in == LayoutNHWC) address = (b*isize) + (py*D->ic + px)*D->iz + pz;
+  else address = (b*isize) + (pz*irsize) + (py*D->ic) + px;
   return D->I->ptr[address];
 }
 
@@ -34,36 +44,33 @@ void add_pixel(int b,int px,int py,int pz,ConvolDescriptor *D,int isize,int irsi
   if (py>=D->ir) return;
 
   // Compute address from indices (row-major)
-  unsigned int address = (b*isize) + (pz*irsize) + (py*D->ic) + px;
+  unsigned int address;
+  if (D->layout_in == LayoutNHWC) address = (b*isize) + (py*D->ic + px)*D->iz + pz;
+  else address = (b*isize) + (pz*irsize) + (py*D->ic) + px;
   D->ID->ptr[address]+=val;
 }
 
 
-void im2col(int b,ConvolDescriptor *D,float *ptrI,int col2im)
+// Lowers (col2im=0) or accumulates back (col2im=1) the rows [ini, ini+rows) of the im2col
+// matrix of sample "b". ptrI is a (rows x iz*kr*kc) column-major block, so the columns of
+// every group (kz*kr*kc) are contiguous
+void im2col(int b,ConvolDescriptor *D,float *ptrI,int ini,int rows,int col2im)
 {
   _profile(_CPU_IM2COL, 0);
   int i,j,k;
   int pz,py,px,y,x;
   int ksize=D->kr*D->kc;
-  int kr2=D->kr/2;
-  int kc2=D->kc/2;
-
-  if (kc2==0) kc2=-1;
-
-  int orsize=D->r*D->c;
+  int ncols=ksize*D->iz;
 
   int isize=D->ir*D->ic*D->iz;
   int irsize=D->ir*D->ic;
 
-  k=0;
-  py=-D->padrt;
-  px=-D->padcl;
-
-
-  for(j=0;j<D->matI.rows();j++) {
+  for(j=0;j<rows;j++) {
     k=j;
+    py=((ini+j)/D->c)*D->sr-D->padrt;
+    px=((ini+j)%D->c)*D->sc-D->padcl;
 
-    for(i=0;i<D->matI.cols();i++,k+=orsize) {
+    for(i=0;i<ncols;i++,k+=rows) {
       pz=i/ksize;
       y=py+(i%ksize)/D->kc;
       x=px+(i%D->kc);
@@ -74,94 +81,359 @@ void im2col(int b,ConvolDescriptor *D,float *ptrI,int col2im)
       ptrI[k]=get_pixel(b,x,y,pz,D,isize,irsize);
 
     }
-    px+=D->sc;
-    if (px>=D->ic+D->padcl-kc2-1) {
-      px=-D->padcl;
-      py+=D->sr;
-    }
   }
     _profile(_CPU_IM2COL, 1);
 }
 
+static inline int conv_thread_num()
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+static inline int conv_max_threads()
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+// Floats of output written by every GEMM block before its epilogue runs (256KB, stays in L2)
+#define CONV_EPILOGUE_TILE 65536
+
+template<int ACT>
+static inline float conv_act(float v, float alpha)
+{
+  switch (ACT) {
+    case ConvActReLU: return (v > 0.0f) ? v : 0.0f;
+    case ConvActLeakyReLU: return (v > 0.0f) ? v : alpha*v;
+    case ConvActSigmoid: return 1.0f/(1.0f+::expf(-v));
+    case ConvActTanh: return ::tanhf(v);
+    default: return v;
+  }
+}
+
+// Bias and activation over n outputs of one channel
+template<int ACT>
+static inline void conv_epilogue_row(float *p, int n, float bias, float alpha)
+{
+  for(int j=0;j<n;j++)
+    p[j]=conv_act<ACT>(p[j]+bias, alpha);
+}
+
+// Bias and activation over the output rows [ini, ini+rows) of one sample
+template<int ACT>
+static void conv_epilogue_tile(ConvolDescriptor *D, float *ptrO, int ini, int rows)
+{
+  float alpha=D->act_param;
+  float *bias=D->use_bias ? D->bias->ptr : nullptr;
+
+  if (D->layout_out == LayoutNHWC) {
+    for(int j=0;j<rows;j++) {
+      float *p=ptrO+(ini+j)*D->z;
+      for(int k=0;k<D->z;k++)
+        p[k]=conv_act<ACT>(bias ? p[k]+bias[k] : p[k], alpha);
+    }
+  }
+  else {
+    for(int k=0;k<D->z;k++)
+      conv_epilogue_row<ACT>(ptrO+k*D->r*D->c+ini, rows, bias ? bias[k] : 0.0f, alpha);
+  }
+}
+
+void cpu_conv2D_epilogue(ConvolDescriptor *D, float *ptrO, int ini, int rows)
+{
+  switch (D->act) {
+    case ConvActReLU: conv_epilogue_tile<ConvActReLU>(D, ptrO, ini, rows); break;
+    case ConvActLeakyReLU: conv_epilogue_tile<ConvActLeakyReLU>(D, ptrO, ini, rows); break;
+    case ConvActSigmoid: conv_epilogue_tile<ConvActSigmoid>(D, ptrO, ini, rows); break;
+    case ConvActTanh: conv_epilogue_tile<ConvActTanh>(D, ptrO, ini, rows); break;
+    default: conv_epilogue_tile<ConvActNone>(D, ptrO, ini, rows); break;
+  }
+}
+
+void cpu_conv2D_epilogue_row(ConvolDescriptor *D, float *ptrO, int k, int n)
+{
+  float bk=D->use_bias ? D->bias->ptr[k] : 0.0f;
+  float alpha=D->act_param;
+
+  switch (D->act) {
+    case ConvActReLU: conv_epilogue_row<ConvActReLU>(ptrO, n, bk, alpha); break;
+    case ConvActLeakyReLU: conv_epilogue_row<ConvActLeakyReLU>(ptrO, n, bk, alpha); break;
+    case ConvActSigmoid: conv_epilogue_row<ConvActSigmoid>(ptrO, n, bk, alpha); break;
+    case ConvActTanh: conv_epilogue_row<ConvActTanh>(ptrO, n, bk, alpha); break;
+    default: conv_epilogue_row<ConvActNone>(ptrO, n, bk, alpha); break;
+  }
+}
+
+// Grouped GEMMs: group "g" multiplies its own columns of the lowered input (kz*kr*kc) by its
+// own nk/groups kernels. With a single group they are the plain GEMMs
+
+// O[ini:ini+rows, :] = I * K
+template<typename MatO>
+static inline void conv_gemm(ConvolDescriptor *D, MatO &matO, const Eigen::Ref<const Eigen::MatrixXf> &matI, int ini, int rows)
+{
+  Eigen::Map<Eigen::MatrixXf> matK=Eigen::Map<Eigen::MatrixXf>(D->K->ptr, D->kr * D->kc * D->kz, D->nk);
+
+  if (D->groups == 1) {
+    matO.middleRows(ini,rows).noalias()=matI*matK;
+    return;
+  }
+
+  int gcols=D->kr*D->kc*D->kz;
+  int gk=D->nk/D->groups;
+  for(int g=0;g<D->groups;g++)
+    matO.block(ini,g*gk,rows,gk).noalias()=matI.middleCols(g*gcols,gcols)*matK.middleCols(g*gk,gk);
+}
+
+// gK += I^T * D
+template<typename MatD>
+static inline void conv_gemm_grad(ConvolDescriptor *D, Eigen::Map<Eigen::MatrixXf> &matgK, const Eigen::Ref<const Eigen::MatrixXf> &matI, const Eigen::MatrixBase<MatD> &matD)
+{
+  if (D->groups == 1) {
+    matgK.noalias()+=matI.transpose()*matD;
+    return;
+  }
+
+  int gcols=D->kr*D->kc*D->kz;
+  int gk=D->nk/D->groups;
+  for(int g=0;g<D->groups;g++)
+    matgK.middleCols(g*gk,gk).noalias()+=matI.middleCols(g*gcols,gcols).transpose()*matD.middleCols(g*gk,gk);
+}
+
+// I = D * K^T
+template<typename MatD>
+static inline void conv_gemm_back(ConvolDescriptor *D, Eigen::Map<Eigen::MatrixXf> &matI, const Eigen::MatrixBase<MatD> &matD)
+{
+  Eigen::Map<Eigen::MatrixXf> matK=Eigen::Map<Eigen::MatrixXf>(D->K->ptr, D->kr * D->kc * D->kz, D->nk);
+
+  if (D->groups == 1) {
+    matI.noalias()=matD*matK.transpose();
+    return;
+  }
+
+  int gcols=D->kr*D->kc*D->kz;
+  int gk=D->nk/D->groups;
+  for(int g=0;g<D->groups;g++)
+    matI.middleCols(g*gcols,gcols).noalias()=matD.middleCols(g*gk,gk)*matK.middleCols(g*gk,gk).transpose();
+}
+
 
 void cpu_conv2D(ConvolDescriptor *D)
 {
   _profile(_CPU_CONV2D, 0);
   int osize=D->z*D->r*D->c;
-  int isize=D->r*D->c*D->kc*D->kr*D->kz;//r*c,kr*kc*kz
+  int isize=D->r*D->c*D->kc*D->kr*D->iz;//r*c,kr*kc*iz
 
   float *ptrO=D->O->ptr;
   float *ptrI=D->ptrI;
 
+  // Bias and fused activation are applied to every GEMM block while it is still in cache
+  bool epilogue=D->use_bias || (D->act != ConvActNone);
 
-  // Map memory to Eigen
-  Eigen::Map<Eigen::MatrixXf> matK=Eigen::Map<Eigen::MatrixXf>(D->K->ptr, D->kr * D->kc * D->kz, D->nk);
 
-  #pragma omp parallel for
-  for(int b=0;b<D->I->shape[0];b++){
+  // These kernels run the epilogue on the outputs they have just written
+  if (D->algo == ConvAlgoWinograd) cpu_conv2D_winograd(D);
+  else if (D->algo == ConvAlgoDepthwise) cpu_conv2D_depthwise(D);
+  else if (D->ws_threads) {
+    int ncols=D->iz*D->kr*D->kc;
+    int ntiles=(D->r*D->c+D->ws_rows-1)/D->ws_rows;
+
+    // Tiled lowering: every thread reuses its own workspace tile
+    #pragma omp parallel for num_threads(D->ws_threads)
+    for(int bt=0;bt<D->I->shape[0]*ntiles;bt++){
+      int b=bt/ntiles;
+      int ini=(bt%ntiles)*D->ws_rows;
+      int rows=std::min(D->ws_rows,D->r*D->c-ini);
 
-    float *ptrO=D->O->ptr+(b*osize);
-    float *ptrI=D->ptrI+(b*isize);
+      float *ptrO=D->O->ptr+(b*osize);
+      float *ptrT=D->ptrI+(conv_thread_num()*D->ws_rows*ncols);
 
-    Eigen::Map<Eigen::MatrixXf> matI=Eigen::Map<Eigen::MatrixXf>(ptrI,D->r*D->c,D->kz*D->kr*D->kc);
-    Eigen::Map<Eigen::MatrixXf> matO=Eigen::Map<Eigen::MatrixXf>(ptrO,D->r*D->c,D->z);
+      Eigen::Map<Eigen::MatrixXf> matT=Eigen::Map<Eigen::MatrixXf>(ptrT,rows,ncols);
 
-    im2col(b,D,ptrI,0);
+      im2col(b,D,ptrT,ini,rows,0);
 
-    matO=matI*matK;
-  }// batch
+      if (D->layout_out == LayoutNHWC) {
+        Eigen::Map<MatrixRXf> matO=Eigen::Map<MatrixRXf>(ptrO,D->r*D->c,D->z);
+        conv_gemm(D,matO,matT,ini,rows);
+      }
+      else {
+        Eigen::Map<Eigen::MatrixXf> matO=Eigen::Map<Eigen::MatrixXf>(ptrO,D->r*D->c,D->z);
+        conv_gemm(D,matO,matT,ini,rows);
+      }
+
+      if (epilogue) cpu_conv2D_epilogue(D, ptrO, ini, rows);
+    }// batch x tiles
+  }
+  else {
+    // Without epilogue the whole sample is a single GEMM
+    int erows=epilogue ? std::max(1, std::min(D->r*D->c, CONV_EPILOGUE_TILE/D->z)) : D->r*D->c;
 
-  //bias
-  if (D->use_bias) {
     #pragma omp parallel for
-    for(int b=0;b<D->O->shape[0];b++) {
+    for(int b=0;b<D->I->shape[0];b++){
+
       float *ptrO=D->O->ptr+(b*osize);
-      for(int z=0;z<D->O->shape[1];z++)
-      for(int r=0;r<D->O->shape[2];r++)
-      for(int c=0;c<D->O->shape[3];c++,ptrO++)
-      (*ptrO)+=D->bias->ptr[z];
-    }
+      float *ptrI=D->ptrI+(b*isize);
+
+      Eigen::Map<Eigen::MatrixXf> matI=Eigen::Map<Eigen::MatrixXf>(ptrI,D->r*D->c,D->iz*D->kr*D->kc);
+
+      im2col(b,D,ptrI,0,D->r*D->c,0);
+
+      for(int ini=0;ini<D->r*D->c;ini+=erows) {
+        int rows=std::min(erows,D->r*D->c-ini);
+
+        if (D->layout_out == LayoutNHWC) {
+          Eigen::Map<MatrixRXf> matO=Eigen::Map<MatrixRXf>(ptrO,D->r*D->c,D->z);
+          conv_gemm(D,matO,matI.middleRows(ini,rows),ini,rows);
+        }
+        else {
+          Eigen::Map<Eigen::MatrixXf> matO=Eigen::Map<Eigen::MatrixXf>(ptrO,D->r*D->c,D->z);
+          conv_gemm(D,matO,matI.middleRows(ini,rows),ini,rows);
+        }
+
+        if (epilogue) cpu_conv2D_epilogue(D, ptrO, ini, rows);
+      }
+    }// batch
   }
+
     _profile(_CPU_CONV2D, 1);
 
 }
 
+// Bias gradient, every channel is reduced by a single thread
+static void conv_grad_bias(ConvolDescriptor *D)
+{
+  int osize=D->z*D->r*D->c;
+
+  if (D->use_bias) {
+    // Channels-last deltas are read with stride z
+    int zstride=(D->layout_out == LayoutNHWC) ? 1 : D->r*D->c;
+    int pstride=(D->layout_out == LayoutNHWC) ? D->z : 1;
+
+    #pragma omp parallel for
+    for(int z=0;z<D->D->shape[1];z++) {
+      float sum=0.0f;
+      for(int b=0;b<D->D->shape[0];b++) {
+        float *ptrD=D->D->ptr+(b*osize)+(z*zstride);
+        for(int j=0;j<D->r*D->c;j++) sum+=ptrD[j*pstride];
+      }
+      D->gbias->ptr[z]+=sum;
+    }
+  }
+}
+
 void cpu_conv2D_grad(ConvolDescriptor *D)
 {
   _profile(_CPU_CONV2D_GRAD, 0);
   //return;
   int osize=D->z*D->r*D->c;
-  int isize=D->r*D->c*D->kc*D->kr*D->kz;//r*c,kr*kc*kz
+  int isize=D->r*D->c*D->kc*D->kr*D->iz;//r*c,kr*kc*iz
 
+  if (D->algo == ConvAlgoDepthwise) {
+    cpu_conv2D_grad_depthwise(D);
+    conv_grad_bias(D);
+    _profile(_CPU_CONV2D_GRAD, 1);
+    return;
+  }
 
-  // Map memory to Eigen
-  Eigen::Map<Eigen::MatrixXf> matgK=Eigen::Map<Eigen::MatrixXf>(D->gK->ptr, D->kr * D->kc * D->kz, D->nk);
+  int ncols=D->iz*D->kr*D->kc;
+  int gsize=D->kz*D->kr*D->kc*D->nk;
+  int ntiles=(D->r*D->c+D->ws_rows-1)/D->ws_rows;
+  int nth=D->ws_threads ? D->ws_threads : conv_max_threads();
+
+  // Every thread accumulates its own partial gradient, reduced afterwards in thread order.
+  // There are no more partials than work items, and a single one is the gradient itself
+  int nitems=D->ws_threads ? D->I->shape[0]*ntiles : D->I->shape[0];
+  int npart=std::max(1, std::min(nth, nitems));
+  if (D->gk_threads < npart) {
+    free_fmem(D->ptrGK);
+    D->ptrGK=get_fmem((unsigned long)npart*gsize, "cpu_conv2D_grad");
+    D->gk_threads=npart;
+  }
 
-  //#pragma omp parallel for
-  for(int b=0;b<D->I->shape[0];b++){
+  // Partials actually written (the team can be smaller than asked for)
+  int nused=npart;
+
+  #pragma omp parallel num_threads(npart)
+  {
+    int tid=conv_thread_num();
+#ifdef _OPENMP
+    if (tid == 0) nused=omp_get_num_threads();
+#endif
+    float *ptrGK=D->gK->ptr;
+    if (npart > 1) {
+      // Zeroed by its own thread, so it is in cache for the first GEMM
+      ptrGK=D->ptrGK+(unsigned long)tid*gsize;
+      std::fill(ptrGK, ptrGK+gsize, 0.0f);
+    }
+    Eigen::Map<Eigen::MatrixXf> matgK=Eigen::Map<Eigen::MatrixXf>(ptrGK, D->kz*D->kr*D->kc, D->nk);
 
-    float *ptrD=D->D->ptr+(b*osize);
-    float *ptrI=D->ptrI+(b*isize);
+    if (D->ws_threads) {
+      float *ptrT=D->ptrI+(tid*D->ws_rows*ncols);
 
-    Eigen::Map<Eigen::MatrixXf> matI=Eigen::Map<Eigen::MatrixXf>(ptrI,D->r*D->c,D->kz*D->kr*D->kc);
-    Eigen::Map<Eigen::MatrixXf> matD=Eigen::Map<Eigen::MatrixXf>(ptrD,D->r*D->c,D->z);
+      // The workspace does not keep the lowered input, so it is recomputed tile by tile
+      #pragma omp for schedule(static)
+      for(int bt=0;bt<D->I->shape[0]*ntiles;bt++){
+        int b=bt/ntiles;
+        int ini=(bt%ntiles)*D->ws_rows;
+        int rows=std::min(D->ws_rows,D->r*D->c-ini);
 
-    matgK+=matI.transpose()*matD;
-  }// batch
+        float *ptrD=D->D->ptr+(b*osize);
 
-  //bias
+        Eigen::Map<Eigen::MatrixXf> matT=Eigen::Map<Eigen::MatrixXf>(ptrT,rows,ncols);
 
-  //#pragma omp parallel for
-  if (D->use_bias) {
-    for(int b=0;b<D->D->shape[0];b++) {
-      float *ptrD=D->D->ptr+(b*osize);
-      for(int z=0;z<D->D->shape[1];z++)
-      for(int r=0;r<D->D->shape[2];r++)
-      for(int c=0;c<D->D->shape[3];c++,ptrD++)
-      D->gbias->ptr[z]+=(*ptrD);
+        im2col(b,D,ptrT,ini,rows,0);
 
+        if (D->layout_out == LayoutNHWC) {
+          Eigen::Map<MatrixRXf> matD=Eigen::Map<MatrixRXf>(ptrD,D->r*D->c,D->z);
+          conv_gemm_grad(D,matgK,matT,matD.middleRows(ini,rows));
+        }
+        else {
+          Eigen::Map<Eigen::MatrixXf> matD=Eigen::Map<Eigen::MatrixXf>(ptrD,D->r*D->c,D->z);
+          conv_gemm_grad(D,matgK,matT,matD.middleRows(ini,rows));
+        }
+      }// batch x tiles
+    }
+    else {
+      #pragma omp for schedule(static)
+      for(int b=0;b<D->I->shape[0];b++){
+
+        float *ptrD=D->D->ptr+(b*osize);
+        float *ptrI=D->ptrI+(b*isize);
+
+        Eigen::Map<Eigen::MatrixXf> matI=Eigen::Map<Eigen::MatrixXf>(ptrI,D->r*D->c,ncols);
+
+        // Winograd forward does not lower the input
+        if (D->algo == ConvAlgoWinograd) im2col(b,D,ptrI,0,D->r*D->c,0);
+
+        if (D->layout_out == LayoutNHWC) {
+          Eigen::Map<MatrixRXf> matD=Eigen::Map<MatrixRXf>(ptrD,D->r*D->c,D->z);
+          conv_gemm_grad(D,matgK,matI,matD);
+        }
+        else {
+          Eigen::Map<Eigen::MatrixXf> matD=Eigen::Map<Eigen::MatrixXf>(ptrD,D->r*D->c,D->z);
+          conv_gemm_grad(D,matgK,matI,matD);
+        }
+      }// batch
     }
   }
+
+  // Deterministic reduction: every element is summed in thread order
+  if (npart > 1) {
+    #pragma omp parallel for
+    for(int i=0;i<gsize;i++) {
+      float sum=0.0f;
+      for(int t=0;t<nused;t++) sum+=D->ptrGK[(unsigned long)t*gsize+i];
+      D->gK->ptr[i]+=sum;
+    }
+  }
+
+  conv_grad_bias(D);
     _profile(_CPU_CONV2D_GRAD, 1);
 }
 
@@ -169,27 +441,71 @@ void cpu_conv2D_back(ConvolDescriptor *D)
 {
   _profile(_CPU_CONV2D_BACK, 0);
   int osize=D->z*D->r*D->c;
-  int isize=D->r*D->c*D->kc*D->kr*D->kz;//r*c,kr*kc*kz
+  int isize=D->r*D->c*D->kc*D->kr*D->iz;//r*c,kr*kc*iz
 
   float *ptrD=D->D->ptr;
   float *ptrI=D->ptrI;
 
-  // Map memory to Eigen
-  Eigen::Map<Eigen::MatrixXf> matK=Eigen::Map<Eigen::MatrixXf>(D->K->ptr, D->kr * D->kc * D->kz, D->nk);
+  if ((D->algo == ConvAlgoWinograd) || (D->algo == ConvAlgoDepthwise)) {
+    if (D->algo == ConvAlgoWinograd) cpu_conv2D_back_winograd(D);
+    else cpu_conv2D_back_depthwise(D);
+    _profile(_CPU_CONV2D_BACK, 1);
+    return;
+  }
+
+  if (D->ws_threads) {
+    int ncols=D->iz*D->kr*D->kc;
 
-  #pragma omp parallel for
-  for(int b=0;b<D->I->shape[0];b++){
+    // Tiles of the same sample overlap in the input delta, so threads only split the batch
+    #pragma omp parallel for num_threads(D->ws_threads)
+    for(int b=0;b<D->I->shape[0];b++){
 
-    float *ptrD=D->D->ptr+(b*osize);
-    float *ptrI=D->ptrI+(b*isize);
+      float *ptrD=D->D->ptr+(b*osize);
+      float *ptrT=D->ptrI+(conv_thread_num()*D->ws_rows*ncols);
+
+      Eigen::Map<Eigen::MatrixXf> matD=Eigen::Map<Eigen::MatrixXf>(ptrD,D->r*D->c,D->z);
+      Eigen::Map<MatrixRXf> matDR=Eigen::Map<MatrixRXf>(ptrD,D->r*D->c,D->z);
 
-    Eigen::Map<Eigen::MatrixXf> matI=Eigen::Map<Eigen::MatrixXf>(ptrI,D->r*D->c,D->kz*D->kr*D->kc);
-    Eigen::Map<Eigen::MatrixXf> matD=Eigen::Map<Eigen::MatrixXf>(ptrD,D->r*D->c,D->z);
+      for(int ini=0;ini<D->r*D->c;ini+=D->ws_rows) {
+        int rows=std::min(D->ws_rows,D->r*D->c-ini);
+        Eigen::Map<Eigen::MatrixXf> matT=Eigen::Map<Eigen::MatrixXf>(ptrT,rows,ncols);
 
-    matI=matD*matK.transpose();
+        if (D->layout_out == LayoutNHWC) conv_gemm_back(D,matT,matDR.middleRows(ini,rows));
+        else conv_gemm_back(D,matT,matD.middleRows(ini,rows));
+
+        im2col(b,D,ptrT,ini,rows,1);
+      }
+    }// batch
+  }
+  else {
+    #pragma omp parallel for
+    for(int b=0;b<D->I->shape[0];b++){
+
+      float *ptrD=D->D->ptr+(b*osize);
+      float *ptrI=D->ptrI+(b*isize);
 
-    im2col(b,D,ptrI,1);
+      Eigen::Map<Eigen::MatrixXf> matI=Eigen::Map<Eigen::MatrixXf>(ptrI,D->r*D->c,D->iz*D->kr*D->kc);
 
-  }// batch
+      if (D->layout_out == LayoutNHWC) {
+        Eigen::Map<MatrixRXf> matD=Eigen::Map<MatrixRXf>(ptrD,D->r*D->c,D->z);
+        conv_gemm_back(D,matI,matD);
+      }
+      else {
+        Eigen::Map<Eigen::MatrixXf> matD=Eigen::Map<Eigen::MatrixXf>(ptrD,D->r*D->c,D->z);
+        conv_gemm_back(D,matI,matD);
+      }
+
+      im2col(b,D,ptrI,0,D->r*D->c,1);
+
+    }// batch
+  }
     _profile(_CPU_CONV2D_BACK, 1);
 }
+
+void cpu_conv2D_act_back(ConvolDescriptor *D)
+{
+  _profile(_CPU_CONV2D_ACT_BACK, 0);
+  // The output holds the activated values, which is all the derivatives need
+  cpu_d_activation_inplace(D->D, D->O, D->act, D->act_param);
+  _profile(_CPU_CONV2D_ACT_BACK, 1);
+}
@@ -0,0 +1,318 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>      /* printf, scanf, NULL */
+#include <cstdlib>     /* malloc, free, rand */
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+#include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
+
+// Direct depthwise convolution (groups == iz). Output channel "o" only reads the input channel
+// o/m, where m = nk/iz is the depth multiplier, so there is nothing to lower: every output is a
+// kr*kc dot product read straight from the input map.
+// Channels-first maps are walked row by row (unit stride along the columns) and channels-last
+// maps pixel by pixel (unit stride along the channels), so the inner loops vectorize.
+
+#define DW_CBLOCK 16  // Channels per task of the channels-last weight gradient
+
+// Strides of a 4D map: batch, channel, row and column
+struct DWStrides {
+    int b, z, y, x;
+};
+
+static inline DWStrides dw_strides(int layout, int z, int r, int c)
+{
+  if (layout == LayoutNHWC) return {r*c*z, 1, c*z, z};
+  return {r*c*z, r*c, c, 1};
+}
+
+// Output columns [x0, x1) whose input column x*sc-padcl+kj falls inside the map
+static inline void dw_cols(ConvolDescriptor *D, int kj, int &x0, int &x1)
+{
+  int lo=D->padcl-kj;
+  int hi=D->ic-1+D->padcl-kj;
+  x0=(lo>0) ? (lo+D->sc-1)/D->sc : 0;
+  x1=(hi>=0) ? std::min(D->c, hi/D->sc+1) : 0;
+}
+
+// dst[i*ds] += a*src[i*ss], i < n
+static inline void dw_axpy(float *dst, int ds, const float *src, int ss, float a, int n)
+{
+  if ((ds == 1) && (ss == 1)) {
+    #pragma omp simd
+    for(int i=0;i<n;i++) dst[i]+=a*src[i];
+  }
+  else {
+    for(int i=0;i<n;i++) dst[i*ds]+=a*src[i*ss];
+  }
+}
+
+// sum(a[i*as]*b[i*bs]), i < n
+static inline float dw_dot(const float *a, int as, const float *b, int bs, int n)
+{
+  float sum=0.0f;
+  if ((as == 1) && (bs == 1)) {
+    #pragma omp simd reduction(+:sum)
+    for(int i=0;i<n;i++) sum+=a[i]*b[i];
+  }
+  else {
+    for(int i=0;i<n;i++) sum+=a[i*as]*b[i*bs];
+  }
+  return sum;
+}
+
+// Kernels as (kr*kc x nk), so the channels-last loops read them with unit stride
+static void dw_transpose_kernels(ConvolDescriptor *D, std::vector<float> &wt)
+{
+  int ksize=D->kr*D->kc;
+  wt.resize(ksize*D->nk);
+  for(int o=0;o<D->nk;o++)
+    for(int k=0;k<ksize;k++)
+      wt[k*D->nk+o]=D->K->ptr[o*ksize+k];
+}
+
+
+void cpu_conv2D_depthwise(ConvolDescriptor *D)
+{
+  _profile(_CPU_DEPTHWISE, 0);
+  int m=D->nk/D->iz;
+  int batch=D->I->shape[0];
+  DWStrides si=dw_strides(D->layout_in, D->iz, D->ir, D->ic);
+  DWStrides so=dw_strides(D->layout_out, D->z, D->r, D->c);
+
+  // Bias and fused activation, on every output row once computed
+  bool epilogue=D->use_bias || (D->act != ConvActNone);
+
+  if (D->layout_out == LayoutNHWC) {
+    std::vector<float> wt;
+    dw_transpose_kernels(D, wt);
+
+    #pragma omp parallel for
+    for(int by=0;by<batch*D->r;by++) {
+      int b=by/D->r;
+      int y=by%D->r;
+
+      for(int x=0;x<D->c;x++) {
+        float *op=D->O->ptr+b*so.b+y*so.y+x*so.x;
+        std::fill(op, op+D->nk, 0.0f);
+
+        for(int ki=0;ki<D->kr;ki++) {
+          int iy=y*D->sr-D->padrt+ki;
+          if ((iy<0) || (iy>=D->ir)) continue;
+
+          for(int kj=0;kj<D->kc;kj++) {
+            int ix=x*D->sc-D->padcl+kj;
+            if ((ix<0) || (ix>=D->ic)) continue;
+
+            const float *ip=D->I->ptr+b*si.b+iy*si.y+ix*si.x;
+            const float *wk=wt.data()+(ki*D->kc+kj)*D->nk;
+            if ((m == 1) && (si.z == 1)) {
+              #pragma omp simd
+              for(int o=0;o<D->nk;o++) op[o]+=wk[o]*ip[o];
+            }
+            else {
+              for(int o=0;o<D->nk;o++) op[o]+=wk[o]*ip[(o/m)*si.z];
+            }
+          }
+        }
+      }
+      if (epilogue) cpu_conv2D_epilogue(D, D->O->ptr+b*so.b, y*D->c, D->c);
+    }
+  }
+  else {
+    #pragma omp parallel for
+    for(int bo=0;bo<batch*D->nk;bo++) {
+      int b=bo/D->nk;
+      int o=bo%D->nk;
+
+      const float *in=D->I->ptr+b*si.b+(o/m)*si.z;
+      const float *w=D->K->ptr+o*D->kr*D->kc;
+      float *out=D->O->ptr+b*so.b+o*so.z;
+
+      for(int y=0;y<D->r;y++) {
+        float *orow=out+y*so.y;
+        std::fill(orow, orow+D->c, 0.0f);
+
+        for(int ki=0;ki<D->kr;ki++) {
+          int iy=y*D->sr-D->padrt+ki;
+          if ((iy<0) || (iy>=D->ir)) continue;
+
+          for(int kj=0;kj<D->kc;kj++) {
+            int x0, x1;
+            dw_cols(D, kj, x0, x1);
+            if (x0>=x1) continue;
+
+            const float *irow=in+iy*si.y+(x0*D->sc-D->padcl+kj)*si.x;
+            dw_axpy(orow+x0, 1, irow, D->sc*si.x, w[ki*D->kc+kj], x1-x0);
+          }
+        }
+        if (epilogue) cpu_conv2D_epilogue_row(D, orow, o, D->c);
+      }
+    }
+  }
+  _profile(_CPU_DEPTHWISE, 1);
+}
+
+void cpu_conv2D_grad_depthwise(ConvolDescriptor *D)
+{
+  _profile(_CPU_DEPTHWISE, 0);
+  int m=D->nk/D->iz;
+  int batch=D->I->shape[0];
+  int ksize=D->kr*D->kc;
+  DWStrides si=dw_strides(D->layout_in, D->iz, D->ir, D->ic);
+  DWStrides so=dw_strides(D->layout_out, D->z, D->r, D->c);
+
+  if (D->layout_out == LayoutNHWC) {
+    // Every task owns a block of channels, so the deltas are read a cache line at a time
+    int nblocks=(D->nk+DW_CBLOCK-1)/DW_CBLOCK;
+
+    #pragma omp parallel for
+    for(int cb=0;cb<nblocks;cb++) {
+      int o0=cb*DW_CBLOCK;
+      int no=std::min(DW_CBLOCK, D->nk-o0);
+      float acc[DW_CBLOCK];
+
+      for(int k=0;k<ksize;k++) {
+        int ki=k/D->kc;
+        int kj=k%D->kc;
+        std::fill(acc, acc+DW_CBLOCK, 0.0f);
+
+        for(int b=0;b<batch;b++) {
+          for(int y=0;y<D->r;y++) {
+            int iy=y*D->sr-D->padrt+ki;
+            if ((iy<0) || (iy>=D->ir)) continue;
+
+            int x0, x1;
+            dw_cols(D, kj, x0, x1);
+            for(int x=x0;x<x1;x++) {
+              int ix=x*D->sc-D->padcl+kj;
+              const float *dp=D->D->ptr+b*so.b+y*so.y+x*so.x+o0;
+              const float *ip=D->I->ptr+b*si.b+iy*si.y+ix*si.x;
+              for(int t=0;t<no;t++) acc[t]+=dp[t]*ip[((o0+t)/m)*si.z];
+            }
+          }
+        }
+
+        for(int t=0;t<no;t++) D->gK->ptr[(o0+t)*ksize+k]+=acc[t];
+      }
+    }
+  }
+  else {
+    #pragma omp parallel for
+    for(int o=0;o<D->nk;o++) {
+      float *gk=D->gK->ptr+o*ksize;
+
+      for(int k=0;k<ksize;k++) {
+        int ki=k/D->kc;
+        int kj=k%D->kc;
+        int x0, x1;
+        dw_cols(D, kj, x0, x1);
+        if (x0>=x1) continue;
+
+        float sum=0.0f;
+        for(int b=0;b<batch;b++) {
+          const float *in=D->I->ptr+b*si.b+(o/m)*si.z;
+          const float *dl=D->D->ptr+b*so.b+o*so.z;
+
+          for(int y=0;y<D->r;y++) {
+            int iy=y*D->sr-D->padrt+ki;
+            if ((iy<0) || (iy>=D->ir)) continue;
+
+            const float *irow=in+iy*si.y+(x0*D->sc-D->padcl+kj)*si.x;
+            sum+=dw_dot(dl+y*so.y+x0, 1, irow, D->sc*si.x, x1-x0);
+          }
+        }
+        gk[k]+=sum;
+      }
+    }
+  }
+  _profile(_CPU_DEPTHWISE, 1);
+}
+
+void cpu_conv2D_back_depthwise(ConvolDescriptor *D)
+{
+  _profile(_CPU_DEPTHWISE, 0);
+  int m=D->nk/D->iz;
+  int batch=D->I->shape[0];
+  DWStrides si=dw_strides(D->layout_in, D->iz, D->ir, D->ic);
+  DWStrides so=dw_strides(D->layout_out, D->z, D->r, D->c);
+
+  if (D->layout_in == LayoutNHWC) {
+    std::vector<float> wt;
+    dw_transpose_kernels(D, wt);
+
+    // Gather: every input pixel collects the deltas of the outputs that read it
+    #pragma omp parallel for
+    for(int biy=0;biy<batch*D->ir;biy++) {
+      int b=biy/D->ir;
+      int iy=biy%D->ir;
+
+      for(int ix=0;ix<D->ic;ix++) {
+        float *idp=D->ID->ptr+b*si.b+iy*si.y+ix*si.x;
+
+        for(int ki=0;ki<D->kr;ki++) {
+          int ny=iy+D->padrt-ki;
+          if ((ny<0) || (ny%D->sr)) continue;
+          int y=ny/D->sr;
+          if (y>=D->r) continue;
+
+          for(int kj=0;kj<D->kc;kj++) {
+            int nx=ix+D->padcl-kj;
+            if ((nx<0) || (nx%D->sc)) continue;
+            int x=nx/D->sc;
+            if (x>=D->c) continue;
+
+            const float *dp=D->D->ptr+b*so.b+y*so.y+x*so.x;
+            const float *wk=wt.data()+(ki*D->kc+kj)*D->nk;
+            if ((m == 1) && (so.z == 1)) {
+              #pragma omp simd
+              for(int o=0;o<D->nk;o++) idp[o]+=wk[o]*dp[o];
+            }
+            else {
+              for(int o=0;o<D->nk;o++) idp[o/m]+=wk[o]*dp[o*so.z];
+            }
+          }
+        }
+      }
+    }
+  }
+  else {
+    // Scatter: the input channel of every task only receives the deltas of its own group
+    #pragma omp parallel for
+    for(int bc=0;bc<batch*D->iz;bc++) {
+      int b=bc/D->iz;
+      int ch=bc%D->iz;
+      float *id=D->ID->ptr+b*si.b+ch*si.z;
+
+      for(int o=ch*m;o<(ch+1)*m;o++) {
+        const float *w=D->K->ptr+o*D->kr*D->kc;
+        const float *dl=D->D->ptr+b*so.b+o*so.z;
+
+        for(int y=0;y<D->r;y++) {
+          for(int ki=0;ki<D->kr;ki++) {
+            int iy=y*D->sr-D->padrt+ki;
+            if ((iy<0) || (iy>=D->ir)) continue;
+
+            for(int kj=0;kj<D->kc;kj++) {
+              int x0, x1;
+              dw_cols(D, kj, x0, x1);
+              if (x0>=x1) continue;
+
+              float *idrow=id+iy*si.y+(x0*D->sc-D->padcl+kj)*si.x;
+              dw_axpy(idrow, D->sc*si.x, dl+y*so.y+x0*so.x, so.x, w[ki*D->kc+kj], x1-x0);
+            }
+          }
+        }
+      }
+    }
+  }
+  _profile(_CPU_DEPTHWISE, 1);
+}
@@ -0,0 +1,281 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>      /* printf, scanf, NULL */
+#include <cstdlib>     /* malloc, free, rand */
+#include <iostream>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
+
+// Winograd minimal filtering F(m x m, 3 x 3) (Lavin & Gray, 2016)
+// Every m x m output tile is computed from an (m+2) x (m+2) input tile as:
+//      Y = A^T [ (G g G^T) .* (B^T d B) ] A
+// The element-wise products are batched over channels and tiles, so they become
+// alpha*alpha independent GEMMs (alpha = m+2).
+
+#define WINO_TILES 32  // Number of tiles transformed per GEMM block
+
+// F(2x2, 3x3)
+static const float wino2_BT[4*4] = {
+        1.0f,  0.0f, -1.0f,  0.0f,
+        0.0f,  1.0f,  1.0f,  0.0f,
+        0.0f, -1.0f,  1.0f,  0.0f,
+        0.0f,  1.0f,  0.0f, -1.0f
+};
+static const float wino2_G[4*3] = {
+        1.0f,  0.0f, 0.0f,
+        0.5f,  0.5f, 0.5f,
+        0.5f, -0.5f, 0.5f,
+        0.0f,  0.0f, 1.0f
+};
+static const float wino2_AT[2*4] = {
+        1.0f, 1.0f,  1.0f,  0.0f,
+        0.0f, 1.0f, -1.0f, -1.0f
+};
+
+// F(4x4, 3x3)
+static const float wino4_BT[6*6] = {
+        4.0f,  0.0f, -5.0f,  0.0f, 1.0f, 0.0f,
+        0.0f, -4.0f, -4.0f,  1.0f, 1.0f, 0.0f,
+        0.0f,  4.0f, -4.0f, -1.0f, 1.0f, 0.0f,
+        0.0f, -2.0f, -1.0f,  2.0f, 1.0f, 0.0f,
+        0.0f,  2.0f, -1.0f, -2.0f, 1.0f, 0.0f,
+        0.0f,  4.0f,  0.0f, -5.0f, 0.0f, 1.0f
+};
+static const float wino4_G[6*3] = {
+        1.0f/4.0f,   0.0f,        0.0f,
+        -1.0f/6.0f,  -1.0f/6.0f,  -1.0f/6.0f,
+        -1.0f/6.0f,  1.0f/6.0f,   -1.0f/6.0f,
+        1.0f/24.0f,  1.0f/12.0f,  1.0f/6.0f,
+        1.0f/24.0f,  -1.0f/12.0f, 1.0f/6.0f,
+        0.0f,        0.0f,        1.0f
+};
+static const float wino4_AT[4*6] = {
+        1.0f, 1.0f,  1.0f, 1.0f,  1.0f, 0.0f,
+        0.0f, 1.0f, -1.0f, 2.0f, -2.0f, 0.0f,
+        0.0f, 1.0f,  1.0f, 4.0f,  4.0f, 0.0f,
+        0.0f, 1.0f, -1.0f, 8.0f, -8.0f, 1.0f
+};
+
+struct WinogradSetup {
+    int m;      // output tile
+    int alpha;  // input tile
+    const float *BT;
+    const float *G;
+    const float *AT;
+};
+
+static WinogradSetup wino_setup(int m){
+    if (m == 4) return {4, 6, wino4_BT, wino4_G, wino4_AT};
+    return {2, 4, wino2_BT, wino2_G, wino2_AT};
+}
+
+// Kernel transform: U = G g G^T, stored as alpha*alpha (K x C) column-major matrices
+// For the backward pass the kernels are transposed (in/out channels) and rotated 180 degrees
+static void wino_kernel_transform(ConvolDescriptor *D, const WinogradSetup &w, float *U, int back)
+{
+    int alpha = w.alpha;
+    int K = back ? D->kz : D->nk;  // output channels
+    int C = back ? D->nk : D->kz;  // input channels
+    int KC = K * C;
+
+    #pragma omp parallel for
+    for(int kc=0; kc<KC; kc++) {
+        int k = kc / C;
+        int c = kc % C;
+        float g[9], tmp[6*3];
+
+        for(int i=0; i<3; i++)
+            for(int j=0; j<3; j++) {
+                if (back) g[i*3+j] = D->K->ptr[((c*D->kz + k)*3 + (2-i))*3 + (2-j)];
+                else g[i*3+j] = D->K->ptr[((k*D->kz + c)*3 + i)*3 + j];
+            }
+
+        // tmp = G g
+        for(int a=0; a<alpha; a++)
+            for(int j=0; j<3; j++)
+                tmp[a*3+j] = w.G[a*3]*g[j] + w.G[a*3+1]*g[3+j] + w.G[a*3+2]*g[6+j];
+
+        // U = tmp G^T
+        for(int a=0; a<alpha; a++)
+            for(int b=0; b<alpha; b++)
+                U[(a*alpha+b)*KC + c*K + k] = tmp[a*3]*w.G[b*3] + tmp[a*3+1]*w.G[b*3+1] + tmp[a*3+2]*w.G[b*3+2];
+    }
+}
+
+// Correlation of a batch of (B x C x H x W) maps with the transformed kernels U
+// into (B x K x OH x OW) maps. "pt" and "pl" are the top and left paddings.
+// With E, the bias and fused activation of E are applied to every output tile once written.
+// Per-thread workspace for both passes: transformed tiles (alpha*alpha x C) and products (alpha*alpha x K)
+static int wino_workspace(ConvolDescriptor *D)
+{
+#ifdef _OPENMP
+    int nth = omp_get_max_threads();
+#else
+    int nth = 1;
+#endif
+    if (D->wv_threads != nth) {
+        free_fmem(D->ptrWV);
+        D->ptrWV = get_fmem((unsigned long)nth * 36 * (D->nk + D->kz) * WINO_TILES, "wino_workspace");
+        D->wv_threads = nth;
+    }
+    return nth;
+}
+
+static void wino_conv(const WinogradSetup &w, const float *U, const float *in, float *out, float *ws, int nth,
+                      int B, int C, int H, int W, int K, int OH, int OW, int pt, int pl, int acc,
+                      ConvolDescriptor *E)
+{
+    int m = w.m;
+    int alpha = w.alpha;
+    int a2 = alpha * alpha;
+
+    int th = (OH + m - 1) / m;
+    int tw = (OW + m - 1) / m;
+    int ntiles = th * tw;
+    int nblocks = (ntiles + WINO_TILES - 1) / WINO_TILES;
+
+    int isize = C * H * W;
+    int osize = K * OH * OW;
+
+    #pragma omp parallel num_threads(nth)
+    {
+#ifdef _OPENMP
+        int tid = omp_get_thread_num();
+#else
+        int tid = 0;
+#endif
+        float *V = ws + (unsigned long)tid * a2 * (C + K) * WINO_TILES;
+        float *M = V + a2 * C * WINO_TILES;
+
+        #pragma omp for
+        for(int bb=0; bb<B*nblocks; bb++) {
+            int b = bb / nblocks;
+            int t0 = (bb % nblocks) * WINO_TILES;
+            int nt = std::min(WINO_TILES, ntiles - t0);
+
+            const float *ptrI = in + b * isize;
+            float *ptrO = out + b * osize;
+
+            // Input transform: V = B^T d B
+            for(int t=0; t<nt; t++) {
+                int y0 = ((t0 + t) / tw) * m - pt;
+                int x0 = ((t0 + t) % tw) * m - pl;
+
+                for(int c=0; c<C; c++) {
+                    float d[36], tmp[36];
+                    const float *ptrC = ptrI + c * H * W;
+
+                    for(int i=0; i<alpha; i++) {
+                        int y = y0 + i;
+                        for(int j=0; j<alpha; j++) {
+                            int x = x0 + j;
+                            d[i*alpha+j] = ((y >= 0) && (y < H) && (x >= 0) && (x < W)) ? ptrC[y*W + x] : 0.0f;
+                        }
+                    }
+
+                    for(int a=0; a<alpha; a++)
+                        for(int j=0; j<alpha; j++) {
+                            float s = 0.0f;
+                            for(int i=0; i<alpha; i++) s += w.BT[a*alpha+i] * d[i*alpha+j];
+                            tmp[a*alpha+j] = s;
+                        }
+
+                    for(int a=0; a<alpha; a++)
+                        for(int e=0; e<alpha; e++) {
+                            float s = 0.0f;
+                            for(int j=0; j<alpha; j++) s += tmp[a*alpha+j] * w.BT[e*alpha+j];
+                            V[(a*alpha+e)*C*WINO_TILES + t*C + c] = s;
+                        }
+                }
+            }
+
+            // alpha*alpha GEMMs: M = U * V
+            for(int xi=0; xi<a2; xi++) {
+                Eigen::Map<const Eigen::MatrixXf> matU(U + xi*K*C, K, C);
+                Eigen::Map<Eigen::MatrixXf> matV(V + xi*C*WINO_TILES, C, nt);
+                Eigen::Map<Eigen::MatrixXf> matM(M + xi*K*WINO_TILES, K, nt);
+                matM.noalias() = matU * matV;
+            }
+
+            // Output transform: Y = A^T M A
+            for(int t=0; t<nt; t++) {
+                int y0 = ((t0 + t) / tw) * m;
+                int x0 = ((t0 + t) % tw) * m;
+
+                for(int k=0; k<K; k++) {
+                    float mm[36], tmp[4*6];
+                    float *ptrK = ptrO + k * OH * OW;
+
+                    for(int xi=0; xi<a2; xi++) mm[xi] = M[xi*K*WINO_TILES + t*K + k];
+
+                    for(int i=0; i<m; i++)
+                        for(int e=0; e<alpha; e++) {
+                            float s = 0.0f;
+                            for(int a=0; a<alpha; a++) s += w.AT[i*alpha+a] * mm[a*alpha+e];
+                            tmp[i*alpha+e] = s;
+                        }
+
+                    for(int i=0; i<m; i++) {
+                        int y = y0 + i;
+                        if (y >= OH) break;
+                        for(int j=0; j<m; j++) {
+                            int x = x0 + j;
+                            if (x >= OW) break;
+                            float s = 0.0f;
+                            for(int e=0; e<alpha; e++) s += tmp[i*alpha+e] * w.AT[j*alpha+e];
+                            if (acc) ptrK[y*OW + x] += s;
+                            else ptrK[y*OW + x] = s;
+                        }
+                        if (E != nullptr) cpu_conv2D_epilogue_row(E, ptrK + y*OW + x0, k, std::min(m, OW - x0));
+                    }
+                }
+            }
+        }// blocks
+    }
+}
+
+void cpu_conv2D_winograd(ConvolDescriptor *D)
+{
+    _profile(_CPU_WINOGRAD, 0);
+    WinogradSetup w = wino_setup(D->wino_m);
+
+    if (D->ptrWK == nullptr) D->ptrWK = get_fmem(36 * D->nk * D->kz, "cpu_conv2D_winograd");
+
+    // Kernels change after every update
+    wino_kernel_transform(D, w, D->ptrWK, 0);
+
+    bool epilogue = D->use_bias || (D->act != ConvActNone);
+
+    int nth = wino_workspace(D);
+    wino_conv(w, D->ptrWK, D->I->ptr, D->O->ptr, D->ptrWV, nth, D->I->shape[0],
+              D->kz, D->ir, D->ic, D->nk, D->r, D->c, D->padrt, D->padcl, 0, epilogue ? D : nullptr);
+    _profile(_CPU_WINOGRAD, 1);
+}
+
+void cpu_conv2D_back_winograd(ConvolDescriptor *D)
+{
+    _profile(_CPU_WINOGRAD, 0);
+    WinogradSetup w = wino_setup(D->wino_m);
+
+    if (D->ptrWK == nullptr) D->ptrWK = get_fmem(36 * D->nk * D->kz, "cpu_conv2D_back_winograd");
+
+    wino_kernel_transform(D, w, D->ptrWK, 1);
+
+    // Full correlation of the delta with the rotated kernels: ID += D * rot180(K)^T
+    int nth = wino_workspace(D);
+    wino_conv(w, D->ptrWK, D->D->ptr, D->ID->ptr, D->ptrWV, nth, D->D->shape[0],
+              D->nk, D->r, D->c, D->kz, D->ir, D->ic, 2 - D->padrt, 2 - D->padcl, 1, nullptr);
+    _profile(_CPU_WINOGRAD, 1);
+}
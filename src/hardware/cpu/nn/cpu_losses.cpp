@@ -13,6 +13,7 @@
 #include <iostream>
 
 #include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
 
 
 void cpu_cent(Tensor *A, Tensor *B, Tensor *C){
@@ -56,6 +57,27 @@ void cpu_d_categorical_cross_entropy(Tensor* y_true, Tensor* y_pred, Tensor* del
     }
 }
 
+float cpu_softmax_cross_entropy(Tensor* y_true, Tensor* X, Tensor* LSE){
+    int n = X->shape[X->ndim-1];
+    float sum = 0.0f;
+
+    // -log(softmax(x)) = lse - x, so no log (or clipping) per element is needed
+    #pragma omp parallel for reduction(+:sum) CPU_PARALLEL(X->size)
+    for (int r = 0; r<LSE->size; r++) {
+        const float *t = y_true->ptr + (long int)r*n;
+        const float *x = X->ptr + (long int)r*n;
+        float lse = LSE->ptr[r];
+
+        float r_sum = 0.0f;
+        #pragma omp simd reduction(+:r_sum)
+        for (int i = 0; i<n; i++) r_sum += t[i] * (lse - x[i]);
+        sum += r_sum;
+    }
+
+    // Compute mean
+    return sum/(float)y_true->shape[0];
+}
+
 float cpu_binary_cross_entropy(Tensor* y_true, Tensor* y_pred){
     float sum = 0.0f;
     float eps = 10e-8;
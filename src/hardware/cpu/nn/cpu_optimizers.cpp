@@ -0,0 +1,144 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cmath>
+
+#include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
+
+// Optimizer updates. Each element of the parameter, its gradient and the optimizer state is
+// read once and written once, so the step is bound by memory bandwidth only.
+// Weight decay is added to the gradient (L2 penalty) unless it is decoupled (AdamW).
+
+
+void cpu_sgd_step(Tensor *P, Tensor *G, Tensor *M, float lr, float mu, float weight_decay, bool nesterov) {
+    _profile(_CPU_SGD, 0);
+    float *p = P->ptr, *m = M->ptr;
+    const float *g = G->ptr;
+    long int size = P->size;
+
+    #pragma omp parallel for simd CPU_PARALLEL(size)
+    for (long int i = 0; i < size; i++) {
+        float gi = g[i] + weight_decay * p[i];
+        float mi = mu * m[i] + lr * gi;
+        m[i] = mi;
+        p[i] -= nesterov ? mu * mi + lr * gi : mi;
+    }
+    _profile(_CPU_SGD, 1);
+}
+
+void cpu_adam_step(Tensor *P, Tensor *G, Tensor *M, Tensor *V, float lr, float beta_1, float beta_2, float epsilon, float weight_decay, bool decoupled, int t) {
+    _profile(_CPU_ADAM, 0);
+    float *p = P->ptr, *m = M->ptr, *v = V->ptr;
+    const float *g = G->ptr;
+    long int size = P->size;
+
+    // Bias corrections folded into the step size
+    float step = lr / (1.0f - std::pow(beta_1, (float)t));
+    float ic2 = 1.0f / (1.0f - std::pow(beta_2, (float)t));
+    float l2 = decoupled ? 0.0f : weight_decay;
+    float keep = decoupled ? 1.0f - lr * weight_decay : 1.0f;
+
+    #pragma omp parallel for simd CPU_PARALLEL(size)
+    for (long int i = 0; i < size; i++) {
+        float gi = g[i] + l2 * p[i];
+        float mi = beta_1 * m[i] + (1.0f - beta_1) * gi;
+        float vi = beta_2 * v[i] + (1.0f - beta_2) * gi * gi;
+        m[i] = mi;
+        v[i] = vi;
+        p[i] = keep * p[i] - step * mi / std::sqrt(vi * ic2 + epsilon);
+    }
+    _profile(_CPU_ADAM, 1);
+}
+
+void cpu_rmsprop_step(Tensor *P, Tensor *G, Tensor *V, float lr, float rho, float epsilon, float weight_decay) {
+    _profile(_CPU_RMSPROP, 0);
+    float *p = P->ptr, *v = V->ptr;
+    const float *g = G->ptr;
+    long int size = P->size;
+
+    #pragma omp parallel for simd CPU_PARALLEL(size)
+    for (long int i = 0; i < size; i++) {
+        float gi = g[i] + weight_decay * p[i];
+        float vi = rho * v[i] + (1.0f - rho) * gi * gi;
+        v[i] = vi;
+        p[i] -= lr * gi / std::sqrt(vi + epsilon);
+    }
+    _profile(_CPU_RMSPROP, 1);
+}
+
+void cpu_adagrad_step(Tensor *P, Tensor *G, Tensor *V, float lr, float epsilon, float weight_decay) {
+    _profile(_CPU_ADAGRAD, 0);
+    float *p = P->ptr, *v = V->ptr;
+    const float *g = G->ptr;
+    long int size = P->size;
+
+    #pragma omp parallel for simd CPU_PARALLEL(size)
+    for (long int i = 0; i < size; i++) {
+        float gi = g[i] + weight_decay * p[i];
+        float vi = v[i] + gi * gi;
+        v[i] = vi;
+        p[i] -= lr * gi / std::sqrt(vi + epsilon);
+    }
+    _profile(_CPU_ADAGRAD, 1);
+}
+
+// Row-sparse steps (e.g. embedding tables): only the rows that got a gradient are read and
+// written, and the state of the other rows is left as it is until they are used again.
+
+void cpu_sgd_step_rows(Tensor *P, Tensor *G, Tensor *M, const vector<int> &rows, float lr, float mu, float weight_decay, bool nesterov) {
+    _profile(_CPU_SGD_ROWS, 0);
+    int nrows = rows.size();
+    long int w = P->size / P->shape[0];
+
+    #pragma omp parallel for CPU_PARALLEL((long int)nrows * w)
+    for (int r = 0; r < nrows; r++) {
+        long int o = (long int)rows[r] * w;
+        float *p = P->ptr + o, *m = M->ptr + o;
+        const float *g = G->ptr + o;
+
+        #pragma omp simd
+        for (long int i = 0; i < w; i++) {
+            float gi = g[i] + weight_decay * p[i];
+            float mi = mu * m[i] + lr * gi;
+            m[i] = mi;
+            p[i] -= nesterov ? mu * mi + lr * gi : mi;
+        }
+    }
+    _profile(_CPU_SGD_ROWS, 1);
+}
+
+void cpu_adam_step_rows(Tensor *P, Tensor *G, Tensor *M, Tensor *V, const vector<int> &rows, float lr, float beta_1, float beta_2, float epsilon, float weight_decay, bool decoupled, int t) {
+    _profile(_CPU_ADAM_ROWS, 0);
+    int nrows = rows.size();
+    long int w = P->size / P->shape[0];
+
+    float step = lr / (1.0f - std::pow(beta_1, (float)t));
+    float ic2 = 1.0f / (1.0f - std::pow(beta_2, (float)t));
+    float l2 = decoupled ? 0.0f : weight_decay;
+    float keep = decoupled ? 1.0f - lr * weight_decay : 1.0f;
+
+    #pragma omp parallel for CPU_PARALLEL((long int)nrows * w)
+    for (int r = 0; r < nrows; r++) {
+        long int o = (long int)rows[r] * w;
+        float *p = P->ptr + o, *m = M->ptr + o, *v = V->ptr + o;
+        const float *g = G->ptr + o;
+
+        #pragma omp simd
+        for (long int i = 0; i < w; i++) {
+            float gi = g[i] + l2 * p[i];
+            float mi = beta_1 * m[i] + (1.0f - beta_1) * gi;
+            float vi = beta_2 * v[i] + (1.0f - beta_2) * gi * gi;
+            m[i] = mi;
+            v[i] = vi;
+            p[i] = keep * p[i] - step * mi / std::sqrt(vi * ic2 + epsilon);
+        }
+    }
+    _profile(_CPU_ADAM_ROWS, 1);
+}
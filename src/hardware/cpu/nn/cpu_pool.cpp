@@ -13,133 +13,400 @@
 #include <cstdlib>     /* malloc, free, rand */
 #include <iostream>
 #include <limits>       // std::numeric_limits
+#include <algorithm>
 
 #include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
 
+// Every output window (y, x) starts at the input pixel (y*sr-padrt, x*sc-padcl). Only the
+// border windows can read the padding (zeros), so the rows/columns of the output are split in
+// a border part, walked with bounds checks, and an interior part, read without them.
+// Channels-first maps are split in batch x channel planes. Channels-last maps are walked
+// pixel by pixel with the channels as the inner (contiguous) loop, so the bounds are checked
+// once per window position and not once per value.
 
-void cpu_mpool2D(PoolDescriptor *D){
-    _profile(_CPU_MPOOL2D, 0);
-    int isize = D->ir*D->ic*D->iz;
-    int irsize = D->ir*D->ic;
-
-    #pragma omp parallel for default(none) shared(D, isize, irsize)
-    for(int b=0; b<D->I->shape[0]; b++){  // Batches
-        int p=b*D->size;  // Kernel's index (opt. shared variable)
-
-        for(int k=0; k<D->iz; k++) { // Depth: front-back
-            for(int i=-D->padrt; i<=D->ir+D->padrb-D->kr; i+=D->sr) {  // rows: top-bottom
-                for(int j=-D->padcl; j<=D->ic+D->padcr-D->kc; j+=D->sc, p++) { // cols: left-right
-
-                    // Get max value in window
-                    float max = CPU_LOWEST_FLOAT;
-                    for(int ki=0; ki<D->kr; ki++){  // rows (kernel): top-bottom
-                        for(int kj=0; kj<D->kc; kj++) { // cols (kernel): left-right
-
-                            // Get value W[ki,kj] value in window
-                            float v = get_pixel(b,j+kj,i+ki, k, D, isize, irsize);
-                            if (v>max) {
-                                max = v;
-                                D->indX->ptr[p] = j+kj;
-                                D->indY->ptr[p] = i+ki;
-                            }
-
-                        } // kernel cols
-                    }  // kernel rows
-
-                    // Set output value
-                    D->O->ptr[p] = max;
-
-                } // cols
-            } // rows
-        } // depth
-    } // batch
-    _profile(_CPU_MPOOL2D, 1);
+#define POOL_CBLOCK 16  // Channels per task of the channels-last average pooling backward
+
+// Output positions [lo, hi) whose windows lie inside the input
+static inline void pool_interior(int pad, int in, int k, int s, int out, int &lo, int &hi)
+{
+    lo = std::min(out, (pad + s - 1) / s);
+    hi = (in - k + pad >= 0) ? std::min(out, (in - k + pad) / s + 1) : 0;
+    hi = std::max(hi, lo);
 }
 
-void cpu_mpool2D_back(PoolDescriptor *D){
-    _profile(_CPU_MPOOL2D_BACK, 0);
-    int isize = D->ir*D->ic*D->iz;
-    int irsize = D->ir*D->ic;
 
-    #pragma omp parallel for default(none) shared(D, isize, irsize)
-    for(int b=0; b<D->I->shape[0]; b++){  // Batches (ob=ib)
-        int p=b*D->size; // Kernel's index (opt. shared variable)
+// Argmax of a window found at the in-window offset "n" = ki*kc+kj (input pixel (y, x), flat
+// input offset "pi"): stored as is in 8 bits, or as the flat offset (-1: padding) in 32 bits
+static inline void mpool_set_arg(PoolDescriptor *D, unsigned char *a, int n, int y, int x, int pi)
+{
+    *a = (unsigned char)n;
+}
 
-        for(int k=0; k<D->iz; k++) { // Depth: front-back (oz=iz)
-            for(int i=-D->padrt; i<=D->ir+D->padrb-D->kr; i+=D->sr) {  // rows: top-bottom
-                for(int j=-D->padcl; j<=D->ic+D->padcr-D->kc; j+=D->sc, p++) { // cols: left-right
+static inline void mpool_set_arg(PoolDescriptor *D, int *a, int n, int y, int x, int pi)
+{
+    *a = ((y < 0) || (y >= D->ir) || (x < 0) || (x >= D->ic)) ? -1 : pi;
+}
 
-                    int x = D->indX->ptr[p];  // previous: j+kj
-                    int y = D->indY->ptr[p];  // previous: i+ki
-                    add_pixel(b, x, y, k, D, isize, irsize, D->D->ptr[p]);  // Set input's delta
+// Flat input offset of the argmax of the output (b, k, y, x), -1 if it was in the padding
+static inline int mpool_get_arg(PoolDescriptor *D, unsigned char a, int b, int k, int y, int x)
+{
+    int iy = y * D->sr - D->padrt + a / D->kc;
+    int ix = x * D->sc - D->padcl + a % D->kc;
+    if ((iy < 0) || (iy >= D->ir) || (ix < 0) || (ix >= D->ic)) return -1;
+    if (D->layout_in == LayoutNHWC) return ((b * D->ir + iy) * D->ic + ix) * D->iz + k;
+    return ((b * D->iz + k) * D->ir + iy) * D->ic + ix;
+}
 
-                } // cols
-            } // rows
-        } // depth
-    } // batch
-    _profile(_CPU_MPOOL2D_BACK, 1);
+static inline int mpool_get_arg(PoolDescriptor *D, int a, int b, int k, int y, int x)
+{
+    return a;
 }
 
-void cpu_avgpool2D(PoolDescriptor *D){
-    _profile(_CPU_AVGPOOL2D, 0);
-    int isize = D->ir*D->ic*D->iz;
-    int irsize = D->ir*D->ic;
-    int ksize = D->kr*D->kc;
 
-    #pragma omp parallel for default(none) shared(D, isize, irsize, ksize)
-    for(int b=0; b<D->I->shape[0]; b++){  // Batches
-        int p=b*D->size; // Kernel's index (opt. shared variable)
+// Max of one window of a channels-first plane. The padding counts as zeros, and the first
+// maximum (row-major window order) wins
+template<bool CHECK, int KR, int KC, typename T>
+static inline void mpool_window(PoolDescriptor *D, const float *in, int base, int i, int j, float *o, T *arg)
+{
+    int kr = KR ? KR : D->kr;
+    int kc = KC ? KC : D->kc;
+
+    float m = CPU_LOWEST_FLOAT;
+    int mi = 0, mj = 0;
+    for (int ki = 0; ki < kr; ki++) {
+        bool rin = !CHECK || ((i + ki >= 0) && (i + ki < D->ir));
+        const float *p = in + (i + ki) * D->ic + j;
+        for (int kj = 0; kj < kc; kj++) {
+            float v = (rin && (!CHECK || ((j + kj >= 0) && (j + kj < D->ic)))) ? p[kj] : 0.0f;
+            bool gt = v > m;
+            m = gt ? v : m;
+            mi = gt ? ki : mi;
+            mj = gt ? kj : mj;
+        }
+    }
+    *o = m;
+    mpool_set_arg(D, arg, mi * kc + mj, i + mi, j + mj, base + (i + mi) * D->ic + j + mj);
+}
+
+template<bool CHECK, int KR, int KC>
+static inline float avgpool_window(PoolDescriptor *D, const float *in, int i, int j)
+{
+    int kr = KR ? KR : D->kr;
+    int kc = KC ? KC : D->kc;
+
+    float sum = 0.0f;
+    for (int ki = 0; ki < kr; ki++) {
+        if (CHECK && ((i + ki < 0) || (i + ki >= D->ir))) continue;
+        const float *p = in + (i + ki) * D->ic + j;
+        for (int kj = 0; kj < kc; kj++) {
+            if (CHECK && ((j + kj < 0) || (j + kj >= D->ic))) continue;
+            sum += p[kj];
+        }
+    }
+    return sum;
+}
+
+template<bool CHECK, int KR, int KC>
+static inline void avgpool_window_back(PoolDescriptor *D, float *id, int i, int j, float d)
+{
+    int kr = KR ? KR : D->kr;
+    int kc = KC ? KC : D->kc;
+
+    for (int ki = 0; ki < kr; ki++) {
+        if (CHECK && ((i + ki < 0) || (i + ki >= D->ir))) continue;
+        float *p = id + (i + ki) * D->ic + j;
+        for (int kj = 0; kj < kc; kj++) {
+            if (CHECK && ((j + kj < 0) || (j + kj >= D->ic))) continue;
+            p[kj] += d;
+        }
+    }
+}
+
+
+// Channels-first planes. KR/KC/SC fix the window at compile time (0: read them from D)
+template<int KR, int KC, int SC, typename T>
+static void mpool2D_nchw(PoolDescriptor *D, T *arg)
+{
+    int sc = SC ? SC : D->sc;
+    int ylo, yhi, xlo, xhi;
+    pool_interior(D->padrt, D->ir, D->kr, D->sr, D->r, ylo, yhi);
+    pool_interior(D->padcl, D->ic, D->kc, sc, D->c, xlo, xhi);
+
+    #pragma omp parallel for
+    for (int bk = 0; bk < D->I->shape[0] * D->iz; bk++) {
+        int base = bk * D->ir * D->ic;
+        const float *in = D->I->ptr + base;
+        float *out = D->O->ptr + bk * D->r * D->c;
+        T *a = arg + bk * D->r * D->c;
+
+        for (int y = 0; y < D->r; y++) {
+            int i = y * D->sr - D->padrt;
+            int p = y * D->c;
+
+            if ((y < ylo) || (y >= yhi)) {
+                for (int x = 0; x < D->c; x++)
+                    mpool_window<true, KR, KC>(D, in, base, i, x * sc - D->padcl, out + p + x, a + p + x);
+                continue;
+            }
+
+            for (int x = 0; x < xlo; x++)
+                mpool_window<true, KR, KC>(D, in, base, i, x * sc - D->padcl, out + p + x, a + p + x);
+            for (int x = xlo; x < xhi; x++)
+                mpool_window<false, KR, KC>(D, in, base, i, x * sc - D->padcl, out + p + x, a + p + x);
+            for (int x = xhi; x < D->c; x++)
+                mpool_window<true, KR, KC>(D, in, base, i, x * sc - D->padcl, out + p + x, a + p + x);
+        }
+    }
+}
+
+template<int KR, int KC, int SC>
+static void avgpool2D_nchw(PoolDescriptor *D)
+{
+    int sc = SC ? SC : D->sc;
+    float ksize = (float)(D->kr * D->kc);
+    int ylo, yhi, xlo, xhi;
+    pool_interior(D->padrt, D->ir, D->kr, D->sr, D->r, ylo, yhi);
+    pool_interior(D->padcl, D->ic, D->kc, sc, D->c, xlo, xhi);
+
+    #pragma omp parallel for
+    for (int bk = 0; bk < D->I->shape[0] * D->iz; bk++) {
+        const float *in = D->I->ptr + bk * D->ir * D->ic;
+        float *out = D->O->ptr + bk * D->r * D->c;
+
+        for (int y = 0; y < D->r; y++) {
+            int i = y * D->sr - D->padrt;
+            float *o = out + y * D->c;
+
+            if ((y < ylo) || (y >= yhi)) {
+                for (int x = 0; x < D->c; x++) o[x] = avgpool_window<true, KR, KC>(D, in, i, x * sc - D->padcl) / ksize;
+                continue;
+            }
+
+            for (int x = 0; x < xlo; x++) o[x] = avgpool_window<true, KR, KC>(D, in, i, x * sc - D->padcl) / ksize;
+            for (int x = xlo; x < xhi; x++) o[x] = avgpool_window<false, KR, KC>(D, in, i, x * sc - D->padcl) / ksize;
+            for (int x = xhi; x < D->c; x++) o[x] = avgpool_window<true, KR, KC>(D, in, i, x * sc - D->padcl) / ksize;
+        }
+    }
+}
+
+template<int KR, int KC, int SC>
+static void avgpool2D_back_nchw(PoolDescriptor *D)
+{
+    int sc = SC ? SC : D->sc;
+    float ksize = (float)(D->kr * D->kc);
+    int ylo, yhi, xlo, xhi;
+    pool_interior(D->padrt, D->ir, D->kr, D->sr, D->r, ylo, yhi);
+    pool_interior(D->padcl, D->ic, D->kc, sc, D->c, xlo, xhi);
+
+    // Overlapping windows only share pixels of their own plane
+    #pragma omp parallel for
+    for (int bk = 0; bk < D->I->shape[0] * D->iz; bk++) {
+        float *id = D->ID->ptr + bk * D->ir * D->ic;
+        const float *dl = D->D->ptr + bk * D->r * D->c;
+
+        for (int y = 0; y < D->r; y++) {
+            int i = y * D->sr - D->padrt;
+            const float *d = dl + y * D->c;
+
+            if ((y < ylo) || (y >= yhi)) {
+                for (int x = 0; x < D->c; x++) avgpool_window_back<true, KR, KC>(D, id, i, x * sc - D->padcl, d[x] / ksize);
+                continue;
+            }
+
+            for (int x = 0; x < xlo; x++) avgpool_window_back<true, KR, KC>(D, id, i, x * sc - D->padcl, d[x] / ksize);
+            for (int x = xlo; x < xhi; x++) avgpool_window_back<false, KR, KC>(D, id, i, x * sc - D->padcl, d[x] / ksize);
+            for (int x = xhi; x < D->c; x++) avgpool_window_back<true, KR, KC>(D, id, i, x * sc - D->padcl, d[x] / ksize);
+        }
+    }
+}
+
+
+// Channels-last maps: one task per output row, vectorized over the channels. The in-window
+// offsets of the maxima are kept in "arg" and turned into flat offsets at the end if needed
+template<typename T>
+static void mpool2D_nhwc(PoolDescriptor *D, T *arg)
+{
+    int z = D->iz;
+
+    #pragma omp parallel for
+    for (int by = 0; by < D->I->shape[0] * D->r; by++) {
+        int b = by / D->r;
+        int y = by % D->r;
+        int i = y * D->sr - D->padrt;
+
+        for (int x = 0; x < D->c; x++) {
+            int j = x * D->sc - D->padcl;
+            int po = (by * D->c + x) * z;
+            float *o = D->O->ptr + po;
+            T *a = arg + po;
+
+            for (int k = 0; k < z; k++) {
+                o[k] = CPU_LOWEST_FLOAT;
+                a[k] = 0;
+            }
+
+            for (int ki = 0; ki < D->kr; ki++) {
+                for (int kj = 0; kj < D->kc; kj++) {
+                    T n = (T)(ki * D->kc + kj);
+
+                    if ((i + ki < 0) || (i + ki >= D->ir) || (j + kj < 0) || (j + kj >= D->ic)) {
+                        // Padding
+                        for (int k = 0; k < z; k++) {
+                            bool gt = 0.0f > o[k];
+                            o[k] = gt ? 0.0f : o[k];
+                            a[k] = gt ? n : a[k];
+                        }
+                        continue;
+                    }
+
+                    const float *p = D->I->ptr + ((b * D->ir + i + ki) * D->ic + j + kj) * z;
+                    for (int k = 0; k < z; k++) {
+                        bool gt = p[k] > o[k];
+                        o[k] = gt ? p[k] : o[k];
+                        a[k] = gt ? n : a[k];
+                    }
+                }
+            }
+
+            if (sizeof(T) > 1) {
+                for (int k = 0; k < z; k++) {
+                    int iy = i + (int)a[k] / D->kc;
+                    int ix = j + (int)a[k] % D->kc;
+                    mpool_set_arg(D, a + k, 0, iy, ix, ((b * D->ir + iy) * D->ic + ix) * z + k);
+                }
+            }
+        }
+    }
+}
+
+static void avgpool2D_nhwc(PoolDescriptor *D)
+{
+    int z = D->iz;
+    float ksize = (float)(D->kr * D->kc);
+
+    #pragma omp parallel for
+    for (int by = 0; by < D->I->shape[0] * D->r; by++) {
+        int b = by / D->r;
+        int y = by % D->r;
+        int i = y * D->sr - D->padrt;
+
+        for (int x = 0; x < D->c; x++) {
+            int j = x * D->sc - D->padcl;
+            float *o = D->O->ptr + (by * D->c + x) * z;
+
+            for (int k = 0; k < z; k++) o[k] = 0.0f;
+
+            for (int ki = 0; ki < D->kr; ki++) {
+                if ((i + ki < 0) || (i + ki >= D->ir)) continue;
+                for (int kj = 0; kj < D->kc; kj++) {
+                    if ((j + kj < 0) || (j + kj >= D->ic)) continue;
 
-        for(int k=0; k<D->iz; k++) { // Depth: front-back
-            for(int i=-D->padrt; i<=D->ir+D->padrb-D->kr; i+=D->sr) {  // rows: top-bottom
-                for(int j=-D->padcl; j<=D->ic+D->padcr-D->kc; j+=D->sc, p++) { // cols: left-right
+                    const float *p = D->I->ptr + ((b * D->ir + i + ki) * D->ic + j + kj) * z;
+                    for (int k = 0; k < z; k++) o[k] += p[k];
+                }
+            }
 
-                    // Sum values window
-                    float sum = 0.0f;
-                    for(int ki=0; ki<D->kr; ki++){  // rows (kernel): top-bottom
-                        for(int kj=0; kj<D->kc; kj++) { // cols (kernel): left-right
+            for (int k = 0; k < z; k++) o[k] /= ksize;
+        }
+    }
+}
+
+static void avgpool2D_back_nhwc(PoolDescriptor *D)
+{
+    int z = D->iz;
+    float ksize = (float)(D->kr * D->kc);
+    int nblocks = (z + POOL_CBLOCK - 1) / POOL_CBLOCK;
+
+    // Overlapping windows share pixels across rows, so the tasks split the channels
+    #pragma omp parallel for
+    for (int bc = 0; bc < D->I->shape[0] * nblocks; bc++) {
+        int b = bc / nblocks;
+        int k0 = (bc % nblocks) * POOL_CBLOCK;
+        int nk = std::min(POOL_CBLOCK, z - k0);
 
-                            // Get value W[ki,kj] value in window
-                            float v = get_pixel(b,j+kj,i+ki, k, D, isize, irsize);
-                            sum += v;
+        for (int y = 0; y < D->r; y++) {
+            int i = y * D->sr - D->padrt;
+            for (int x = 0; x < D->c; x++) {
+                int j = x * D->sc - D->padcl;
+                const float *d = D->D->ptr + ((b * D->r + y) * D->c + x) * z + k0;
 
-                        } // kernel cols
-                    }  // kernel rows
+                for (int ki = 0; ki < D->kr; ki++) {
+                    if ((i + ki < 0) || (i + ki >= D->ir)) continue;
+                    for (int kj = 0; kj < D->kc; kj++) {
+                        if ((j + kj < 0) || (j + kj >= D->ic)) continue;
+
+                        float *p = D->ID->ptr + ((b * D->ir + i + ki) * D->ic + j + kj) * z + k0;
+                        for (int k = 0; k < nk; k++) p[k] += d[k] / ksize;
+                    }
+                }
+            }
+        }
+    }
+}
 
-                    // Set output value
-                    D->O->ptr[p]= sum/(float)ksize;
 
-                } // cols
-            } // rows
-        } // depth
-    } // batch
+template<typename T>
+static void mpool2D(PoolDescriptor *D, T *arg)
+{
+    if (D->layout_out == LayoutNHWC) mpool2D_nhwc(D, arg);
+    else if ((D->kr == 2) && (D->kc == 2) && (D->sc == 2)) mpool2D_nchw<2, 2, 2>(D, arg);
+    else if ((D->kr == 3) && (D->kc == 3) && (D->sc == 2)) mpool2D_nchw<3, 3, 2>(D, arg);
+    else mpool2D_nchw<0, 0, 0>(D, arg);
+}
+
+// Direct scatter of the deltas to the stored maxima
+template<typename T>
+static void mpool2D_back(PoolDescriptor *D, const T *arg)
+{
+    bool nhwc = (D->layout_out == LayoutNHWC);
+
+    // Every plane only receives the deltas of its own windows
+    #pragma omp parallel for
+    for (int bk = 0; bk < D->I->shape[0] * D->iz; bk++) {
+        int b = bk / D->iz;
+        int k = bk % D->iz;
+
+        for (int y = 0; y < D->r; y++) {
+            for (int x = 0; x < D->c; x++) {
+                int po = nhwc ? ((b * D->r + y) * D->c + x) * D->iz + k : (bk * D->r + y) * D->c + x;
+                int pi = mpool_get_arg(D, arg[po], b, k, y, x);
+                if (pi >= 0) D->ID->ptr[pi] += D->D->ptr[po];
+            }
+        }
+    }
+}
+
+void cpu_mpool2D(PoolDescriptor *D){
+    _profile(_CPU_MPOOL2D, 0);
+    // The argmax grows lazily with the batch
+    if (D->arg_size < D->O->size) D->alloc_argmax();
+
+    if (D->arg8 != nullptr) mpool2D(D, D->arg8);
+    else mpool2D(D, D->arg32);
+    _profile(_CPU_MPOOL2D, 1);
+}
+
+void cpu_mpool2D_back(PoolDescriptor *D){
+    _profile(_CPU_MPOOL2D_BACK, 0);
+    if (D->arg8 != nullptr) mpool2D_back(D, D->arg8);
+    else mpool2D_back(D, D->arg32);
+    _profile(_CPU_MPOOL2D_BACK, 1);
+}
+
+void cpu_avgpool2D(PoolDescriptor *D){
+    _profile(_CPU_AVGPOOL2D, 0);
+    if (D->layout_out == LayoutNHWC) avgpool2D_nhwc(D);
+    else if ((D->kr == 2) && (D->kc == 2) && (D->sc == 2)) avgpool2D_nchw<2, 2, 2>(D);
+    else if ((D->kr == 3) && (D->kc == 3) && (D->sc == 2)) avgpool2D_nchw<3, 3, 2>(D);
+    else avgpool2D_nchw<0, 0, 0>(D);
     _profile(_CPU_AVGPOOL2D, 1);
 }
 
 void cpu_avgpool2D_back(PoolDescriptor *D){
     _profile(_CPU_AVGPOOL2D_BACK, 0);
-    int isize = D->ir*D->ic*D->iz;
-    int irsize = D->ir*D->ic;
-    int ksize = D->kr*D->kc;
-
-    #pragma omp parallel for default(none) shared(D, isize, irsize, ksize)
-    for(int b=0; b<D->I->shape[0]; b++){  // Batches
-        int p=b*D->size; // Kernel's index (opt. shared variable)
-
-        for(int k=0; k<D->iz; k++) { // Depth: front-back
-            for(int i=-D->padrt; i<=D->ir+D->padrb-D->kr; i+=D->sr) {  // rows: top-bottom
-                for(int j=-D->padcl; j<=D->ic+D->padcr-D->kc; j+=D->sc,p++) { // cols: left-right
-
-                    // Walk kernel window to equally distribute the delta among all the elements
-                    for(int ki=0; ki<D->kr; ki++){  // rows (kernel): top-bottom
-                        for(int kj=0; kj<D->kc; kj++) { // cols (kernel): left-right
-                            add_pixel(b, j + kj, i + ki, k, D, isize, irsize, D->D->ptr[p]/(float)ksize);
-                        } // kernel cols
-                    }  // kernel rows
-
-                } // cols
-            } // rows
-        } // depth
-    } // batch
+    if (D->layout_out == LayoutNHWC) avgpool2D_back_nhwc(D);
+    else if ((D->kr == 2) && (D->kc == 2) && (D->sc == 2)) avgpool2D_back_nchw<2, 2, 2>(D);
+    else if ((D->kr == 3) && (D->kc == 3) && (D->sc == 2)) avgpool2D_back_nchw<3, 3, 2>(D);
+    else avgpool2D_back_nchw<0, 0, 0>(D);
     _profile(_CPU_AVGPOOL2D_BACK, 1);
 }
@@ -0,0 +1,107 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cmath>
+
+#include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
+
+// LSTM cell. G holds the four gate blocks of each row side by side, {N, 4*units} in the order
+// input, forget, output and candidate. The forward turns the pre-activations into activations
+// in place; the backward turns them into the deltas of the pre-activations, so the weight
+// gradients are one GEMM per input.
+
+static inline float lstm_sigmoid(float x) { return 1.0f/(1.0f+expf(-x)); }
+
+
+void cpu_lstm_forward(Tensor *X, Tensor *G, Tensor *bias, Tensor *cprev, Tensor *hprev, Tensor *mask, Tensor *C, Tensor *H, Tensor *TC) {
+    _profile(_CPU_LSTM_FORWARD, 0);
+    int N=G->shape[0], u=G->shape[1]/4, d=X->shape[1];
+    const float *b=bias->ptr;
+
+    #pragma omp parallel for CPU_PARALLEL(G->size)
+    for(int r=0; r<N; r++) {
+        float *g=G->ptr+(long int)r*4*u;
+        float *c=C->ptr+(long int)r*u, *h=H->ptr+(long int)r*u, *tc=TC->ptr+(long int)r*u;
+        const float *cp=(cprev!=nullptr) ? cprev->ptr+(long int)r*u : nullptr;
+
+        // Rows with an all-zero input keep the previous state (mask_zeros)
+        if (mask!=nullptr) {
+            const float *x=X->ptr+(long int)r*d;
+            float s=0.0f;
+            #pragma omp simd reduction(+:s)
+            for(int j=0; j<d; j++) s+=fabsf(x[j]);
+            mask->ptr[r]=(s==0.0f) ? 1.0f : 0.0f;
+            if (s==0.0f) {
+                const float *hp=(hprev!=nullptr) ? hprev->ptr+(long int)r*u : nullptr;
+                for(int j=0; j<u; j++) {
+                    c[j]=(cp!=nullptr) ? cp[j] : 0.0f;
+                    h[j]=(hp!=nullptr) ? hp[j] : 0.0f;
+                }
+                continue;
+            }
+        }
+
+        #pragma omp simd
+        for(int j=0; j<u; j++) {
+            float i=lstm_sigmoid(g[j]+b[j]);
+            float f=lstm_sigmoid(g[u+j]+b[u+j]);
+            float o=lstm_sigmoid(g[2*u+j]+b[2*u+j]);
+            float cn=tanhf(g[3*u+j]+b[3*u+j]);
+            float cc=i*cn+((cp!=nullptr) ? f*cp[j] : 0.0f);
+            float t=tanhf(cc);
+            g[j]=i;
+            g[u+j]=f;
+            g[2*u+j]=o;
+            g[3*u+j]=cn;
+            c[j]=cc;
+            tc[j]=t;
+            h[j]=o*t;
+        }
+    }
+    _profile(_CPU_LSTM_FORWARD, 1);
+}
+
+void cpu_lstm_backward(Tensor *G, Tensor *TC, Tensor *cprev, Tensor *mask, Tensor *DH, Tensor *DC, Tensor *DHprev, Tensor *DCprev) {
+    _profile(_CPU_LSTM_BACKWARD, 0);
+    int N=G->shape[0], u=G->shape[1]/4;
+
+    #pragma omp parallel for CPU_PARALLEL(G->size)
+    for(int r=0; r<N; r++) {
+        long int o1=(long int)r*u;
+        float *g=G->ptr+4*o1;
+        const float *tc=TC->ptr+o1, *dh=DH->ptr+o1, *dc=DC->ptr+o1;
+        const float *cp=(cprev!=nullptr) ? cprev->ptr+o1 : nullptr;
+        float *dcp=(DCprev!=nullptr) ? DCprev->ptr+o1 : nullptr;
+
+        // The state of a masked row went straight to the output, so do its deltas
+        if ((mask!=nullptr) && (mask->ptr[r]!=0.0f)) {
+            for(int j=0; j<4*u; j++) g[j]=0.0f;
+            if (DHprev!=nullptr) {
+                float *dhp=DHprev->ptr+o1;
+                for(int j=0; j<u; j++) dhp[j]+=dh[j];
+            }
+            if (dcp!=nullptr)
+                for(int j=0; j<u; j++) dcp[j]+=dc[j];
+            continue;
+        }
+
+        #pragma omp simd
+        for(int j=0; j<u; j++) {
+            float i=g[j], f=g[u+j], o=g[2*u+j], cn=g[3*u+j], t=tc[j];
+            float dcc=dc[j]+dh[j]*o*(1.0f-t*t);
+            if (dcp!=nullptr) dcp[j]+=dcc*f;
+            g[j]=dcc*cn*i*(1.0f-i);
+            g[u+j]=(cp!=nullptr) ? dcc*cp[j]*f*(1.0f-f) : 0.0f;
+            g[2*u+j]=dh[j]*t*o*(1.0f-o);
+            g[3*u+j]=dcc*i*(1.0f-cn*cn);
+        }
+    }
+    _profile(_CPU_LSTM_BACKWARD, 1);
+}
@@ -52,38 +52,71 @@ void cpu_d_repeat_nn(Tensor *D, Tensor *A, vector<int> size){
 }
 
 
+// Per sample, as cpu_select and friends: whole runs when the innermost axis is contiguous
 void cpu_select_nn(Tensor *A, Tensor *B, SelDescriptor *sd){
+    int run = sd->run;
     #pragma omp parallel for
     for (int b = 0; b < B->shape[0]; b++) {
-        for (int i = 0; i < B->stride[0]; i++) {
-            B->ptr[b*B->stride[0] + i] = A->ptr[b*A->stride[0] + sd->cpu_addresses[i]];
+        float *pa = A->ptr + b*A->stride[0];
+        float *pb = B->ptr + b*B->stride[0];
+        if (run > 1) {
+            for (int r = 0; r < sd->nruns; r++, pb += run) {
+                float *pr = pa + sd->base(r);
+                for (int i = 0; i < run; i++) pb[i] = pr[i];
+            }
+        } else {
+            for (int i = 0; i < B->stride[0]; i++) pb[i] = pa[sd->cpu_addresses[i]];
         }
     }
 }
 
 void cpu_select_back_nn(Tensor *A, Tensor *B, SelDescriptor *sd){
+    int run = sd->run;
     #pragma omp parallel for
     for (int b = 0; b < A->shape[0]; b++) {
-        for (int i = 0; i < A->stride[0]; i++) {  // walk stride
-            B->ptr[b*B->stride[0] + sd->cpu_addresses[i]] += A->ptr[b*A->stride[0] + i];  // delta_parent += delta
+        float *pa = A->ptr + b*A->stride[0];
+        float *pb = B->ptr + b*B->stride[0];
+        if (run > 1) {
+            for (int r = 0; r < sd->nruns; r++, pa += run) {
+                float *pr = pb + sd->base(r);
+                for (int i = 0; i < run; i++) pr[i] += pa[i];  // delta_parent += delta
+            }
+        } else {
+            for (int i = 0; i < A->stride[0]; i++) pb[sd->cpu_addresses[i]] += pa[i];  // delta_parent += delta
         }
     }
 }
 
 void cpu_set_select_nn(Tensor *A, Tensor *B, SelDescriptor *sd){
-   #pragma omp parallel for
+    int run = sd->run;
+    #pragma omp parallel for
     for (int b = 0; b < B->shape[0]; b++) {
-        for (int i = 0; i < B->stride[0]; i++) {
-            A->ptr[b*A->stride[0] + sd->cpu_addresses[i]] = B->ptr[b*B->stride[0] + i];
+        float *pa = A->ptr + b*A->stride[0];
+        float *pb = B->ptr + b*B->stride[0];
+        if (run > 1) {
+            for (int r = 0; r < sd->nruns; r++, pb += run) {
+                float *pr = pa + sd->base(r);
+                for (int i = 0; i < run; i++) pr[i] = pb[i];
+            }
+        } else {
+            for (int i = 0; i < B->stride[0]; i++) pa[sd->cpu_addresses[i]] = pb[i];
         }
     }
 }
 
 void cpu_set_select_back_nn(Tensor *A, Tensor *B, SelDescriptor *sd){
-   #pragma omp parallel for
+    int run = sd->run;
+    #pragma omp parallel for
     for (int b = 0; b < B->shape[0]; b++) {
-        for (int i = 0; i < B->stride[0]; i++) {
-            B->ptr[b*B->stride[0] + i] += A->ptr[b*A->stride[0] + sd->cpu_addresses[i]];
+        float *pa = A->ptr + b*A->stride[0];
+        float *pb = B->ptr + b*B->stride[0];
+        if (run > 1) {
+            for (int r = 0; r < sd->nruns; r++, pb += run) {
+                float *pr = pa + sd->base(r);
+                for (int i = 0; i < run; i++) pb[i] += pr[i];
+            }
+        } else {
+            for (int i = 0; i < B->stride[0]; i++) pb[i] += pa[sd->cpu_addresses[i]];
         }
     }
-}
\ No newline at end of file
+}
@@ -1193,7 +1193,6 @@ float fpga_max(Tensor *A){
 //
 void fpga_cpuemu_max(Tensor *A, Tensor *B, ReduceDescriptor2 *rd) {
   fpga_copy_from_fpga(A, A->ptr);
-  fpga_copy_memory_from_fpga(rd->fpga_index, (void *)&rd->index, rd->index.size());
   // index[i].data must be read from fpga
   printf("Not properly implemented yet (fpga_cpuemu_max\n"); exit(1);
   cpu_max(A, B, rd);
@@ -1251,7 +1250,6 @@ int fpga_argmax(Tensor *A){
 //
 void fpga_cpuemu_argmax(Tensor *A, Tensor *B, ReduceDescriptor2 *rd) {
   fpga_copy_from_fpga(A, A->ptr);
-  fpga_copy_memory_from_fpga(rd->fpga_index, (void *)&rd->index, rd->index.size());
   // index[i].data must be read from fpga
   printf("Not properly implemented yet (fpga_cpuemu_argmax\n"); exit(1);
   cpu_argmax(A, B, rd);
@@ -1310,7 +1308,6 @@ float fpga_min(Tensor *A){
 //
 void fpga_cpuemu_min(Tensor *A, Tensor *B, ReduceDescriptor2 *rd) {
   fpga_copy_from_fpga(A, A->ptr);
-  fpga_copy_memory_from_fpga(rd->fpga_index, (void *)&rd->index, rd->index.size());
   // index[i].data must be read from fpga
   printf("Not properly implemented yet (fpga_cpuemu_min\n"); exit(1);
   cpu_min(A, B, rd);
@@ -1369,7 +1366,6 @@ int fpga_argmin(Tensor *A){
 //
 void fpga_cpuemu_argmin(Tensor *A, Tensor *B, ReduceDescriptor2 *rd) {
   fpga_copy_from_fpga(A, A->ptr);
-  fpga_copy_memory_from_fpga(rd->fpga_index, (void *)&rd->index, rd->index.size());
   // index[i].data must be read from fpga
   printf("Not properly implemented yet (fpga_cpuemu_argmin\n"); exit(1);
   cpu_argmin(A, B, rd);
@@ -263,16 +263,11 @@ void gpu_reduction(ReduceDescriptor *RD){
 
   //////// Init
   if (RD->ind==nullptr) {
-    RD->red_size=RD->index[0].size();
-    s=RD->index.size()*RD->red_size;
+    RD->red_size=RD->rs.nred;
+    s=RD->rs.nout*RD->red_size;
 
     int *ind=(int *)malloc(s*sizeof(int));
-
-    for(i=0;i<RD->index.size();i++) {
-      p=i*RD->red_size;
-      for(j=0;j<RD->index[i].size();j++,p++)
-        ind[p]=RD->index[i][j];
-    }
+    RD->rs.addresses(ind);
 
     if (RD->m<2) RD->S=RD->O;
 
@@ -282,14 +277,14 @@ void gpu_reduction(ReduceDescriptor *RD){
     check_cuda(cudaMemcpy(RD->ind,ind,s*sizeof(int),cudaMemcpyHostToDevice),"copy ind");
     check_cuda(cudaDeviceSynchronize(), "copy");
 
-    check_cuda(cudaMalloc((void**)&(RD->red),RD->index.size()*sizeof(float)),"create_tensor");
+    check_cuda(cudaMalloc((void**)&(RD->red),RD->rs.nout*sizeof(float)),"create_tensor");
 
     free(ind);
   }
   /////////////
 
   int fast=0;
-  if (RD->factor*RD->index.size()<RD->red_size) fast=1;
+  if (RD->factor*RD->rs.nout<RD->red_size) fast=1;
 
   if ((fast)&&((RD->m==0)&&(RD->keepdims))) {//mean with keepdims=true (BN)
 
@@ -297,7 +292,7 @@ void gpu_reduction(ReduceDescriptor *RD){
     reduction_permute<<<dimGrid,dimBlock>>>(RD->I->ptr, RD->O->ptr, RD->ind, RD->O->size);
     check_cuda(cudaDeviceSynchronize(), "reduction_kernel");
 
-    for(int i=0;i<RD->index.size();i++) {
+    for(int i=0;i<RD->rs.nout;i++) {
       float *ptr=RD->O->ptr+(i*RD->red_size);
 
       thrust::device_ptr<float> dev_ptr = thrust::device_pointer_cast(ptr);
@@ -307,12 +302,12 @@ void gpu_reduction(ReduceDescriptor *RD){
       thrust::fill(base + i, base + i + 1, (float)sum/RD->red_size);
     }
 
-    reduction_kernel_keep<<<dimGrid,dimBlock>>>(RD->red, RD->O->ptr,RD->ind, RD->index.size(),RD->red_size);
+    reduction_kernel_keep<<<dimGrid,dimBlock>>>(RD->red, RD->O->ptr,RD->ind, RD->rs.nout,RD->red_size);
     check_cuda(cudaDeviceSynchronize(), "reduction_kernel");
 
   }else{ // still slow for max, min on conv
     RD->O->fill_(0.0);
-    dim3 dimGrid(RD->index.size());
+    dim3 dimGrid(RD->rs.nout);
     dim3 dimBlock(1);
     reduction_kernel<<<dimGrid,dimBlock>>>(RD->I->ptr, RD->O->ptr, RD->S->ptr,RD->m, RD->keepdims,d,RD->ind,RD->red_size);
     check_cuda(cudaDeviceSynchronize(), "reduction_kernel");
@@ -337,7 +332,7 @@ void gpu_reduction_back(ReduceDescriptor *RD){
   }
 
   int fast=0;
-  if (RD->factor*RD->index.size()<RD->red_size) fast=1;
+  if (RD->factor*RD->rs.nout<RD->red_size) fast=1;
 
   if ((fast)&&((RD->m==0)&&(RD->keepdims))) {// mean with keepdims=true (BN)
     float *aux;
@@ -347,7 +342,7 @@ void gpu_reduction_back(ReduceDescriptor *RD){
     reduction_permute<<<dimGrid,dimBlock>>>(RD->D->ptr, aux, RD->ind, RD->O->size);
     check_cuda(cudaDeviceSynchronize(), "reduction_kernel");
 
-    for(int i=0;i<RD->index.size();i++) {
+    for(int i=0;i<RD->rs.nout;i++) {
       float *ptr=aux+(i*RD->red_size);
 
       thrust::device_ptr<float> dev_ptr = thrust::device_pointer_cast(ptr);
@@ -359,11 +354,11 @@ void gpu_reduction_back(ReduceDescriptor *RD){
 
     check_cuda(cudaFree(aux),"delete_tensor");
 
-    reduction_kernel_keep_inc<<<dimGrid,dimBlock>>>(RD->red, RD->ID->ptr, RD->ind, RD->index.size(),RD->red_size);
+    reduction_kernel_keep_inc<<<dimGrid,dimBlock>>>(RD->red, RD->ID->ptr, RD->ind, RD->rs.nout,RD->red_size);
     check_cuda(cudaDeviceSynchronize(), "reduction_kernel");
 
   }else{ // still slow for max, min on conv
-    dim3 dimGrid(RD->index.size());
+    dim3 dimGrid(RD->rs.nout);
     dim3 dimBlock(1);
     reduction_back_kernel<<<dimGrid,dimBlock>>>(RD->D->ptr, RD->ID->ptr, RD->S->ptr,RD->m, RD->keepdims,d,RD->ind,RD->red_size);
     check_cuda(cudaDeviceSynchronize(), "reduction_kernel");
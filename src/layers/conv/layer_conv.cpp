@@ -25,7 +25,7 @@ LConv::LConv(Layer *parent, const vector<int> &ks, const vector<int> &st,
              const vector<int> &p, string name, int dev, int mem) : LConv(parent, new ConvolDescriptor(ks, st, p, mem), name, dev, mem) {}
 
 LConv::LConv(Layer *parent, int filters, const vector<int> &kernel_size, const vector<int> &strides, string padding,
-             int groups, const vector<int> &dilation_rate, bool use_bias, string name, int dev, int mem) : LConv(parent, new ConvolDescriptor(filters, kernel_size, strides, padding, use_bias, mem), name, dev, mem) {
+             int groups, const vector<int> &dilation_rate, bool use_bias, string name, int dev, int mem) : LConv(parent, new ConvolDescriptor(filters, kernel_size, strides, padding, use_bias, mem, groups), name, dev, mem) {
     // TODO: Implement (Fix initialization)
 };
 
@@ -72,6 +72,16 @@ void LConv::resize(int batch){
 
 }
 
+void LConv::set_mem_level(int mem){
+    Layer::set_mem_level(mem);
+    cd->set_mem_level(mem);
+}
+
+void LConv::set_layout(int l){
+    Layer::set_layout(l);
+    cd->set_layout(parent[0]->layout, l);
+}
+
 void LConv::mem_delta(){
     if(this->delta == nullptr) {
         // Reserve parent's delta
@@ -92,6 +102,9 @@ void LConv::forward() {
 }
 
 void LConv::backward() {
+    // delta of the fused activation
+    tensorNN::Conv2D_act_back(this->cd);
+
     //get gradients with provided delta
     if (trainable) { tensorNN::Conv2D_grad(this->cd); }
 
@@ -128,12 +141,13 @@ void LConv::apply_accumulated_gradients() {
 }
 
 Layer *LConv::share(int c, int bs, vector<Layer *> p) {
-    LConv *n = new LConv(p[0], cd->ksize, cd->stride, cd->pad,  "share_"+to_string(c)+this->name, dev,mem_level);
+    LConv *n = new LConv(p[0], new ConvolDescriptor(cd->ksize, cd->stride, cd->pad, mem_level, cd->groups), "share_"+to_string(c)+this->name, dev,mem_level);
     n->orig = this;
     n->isshared=true;
     n->trainable = trainable;
 
     n->cd->use_bias=cd->use_bias;
+    n->cd->set_algorithm(cd->algorithm);
 
     //share params
 
@@ -176,11 +190,12 @@ Layer *LConv::share(int c, int bs, vector<Layer *> p) {
 
 Layer *LConv::clone(int c, int bs, vector<Layer *> p, int todev) {
 
-    LConv *n = new LConv(p[0], cd->ksize, cd->stride, cd->pad,  name, todev, this->mem_level);
+    LConv *n = new LConv(p[0], new ConvolDescriptor(cd->ksize, cd->stride, cd->pad, this->mem_level, cd->groups), name, todev, this->mem_level);
     n->trainable = trainable;
 
     n->orig = this;
     n->cd->use_bias=cd->use_bias;
+    n->cd->set_algorithm(cd->algorithm);
 
     n->reg=reg;
     n->init=init;
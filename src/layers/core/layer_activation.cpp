@@ -31,6 +31,8 @@ LActivation::LActivation(Layer *parent, string act, vector<float> params, string
 #endif
     output = new Tensor(input->shape, dev);
     delta_bp = 0;
+    fused = false;
+    lse = nullptr;
 
     // Softmax checks
     if(this->act=="softmax"){
@@ -62,7 +64,71 @@ LActivation::LActivation(Layer *parent, string act, vector<float> params, string
 }
 
 
+int LActivation::layout_support(){
+    // Every activation but softmax is element-wise
+    if ((act == "softmax") || (act == "softmax_deprecated")) return LAYOUT_FIXED;
+    return LAYOUT_KEEP;
+}
+
+void LActivation::fuse(){
+    // The parent convolution writes the activated values (and reads the delta) directly
+    fused = true;
+    repoint_output(input->ptr);
+
+    if (delta != nullptr) {
+        delete delta;
+        delta = nullptr;
+        mem_delta();
+    }
+}
+
+// The activations that a convolution can fuse have derivatives that only need the output
+bool LActivation::can_inplace(){
+    if ((fused) || (delta_bp) || (getConvActivation(act) == ConvActNone)) return false;
+    return (act != "leaky_relu") || (params[0] >= 0.0f);
+}
+
+LActivation::~LActivation(){
+    delete lse;
+}
+
+void LActivation::mem_delta(){
+    if (!fused) {
+        Layer::mem_delta();
+        return;
+    }
+
+    if (delta == nullptr) {
+        parent[0]->mem_delta();
+        delta = new Tensor(output->shape, parent[0]->delta);
+
+        if(this->verbosity_level >= 2){
+            std::cout << "Booked delta for: " + this->name << std::endl;
+        }
+    }
+}
+
+void LActivation::free_delta(){
+    if (!fused) {
+        Layer::free_delta();
+        return;
+    }
+
+    // Shared with the parent, so the data is not released
+    if (delta != nullptr) {
+        delete delta;
+        delta = nullptr;
+    }
+}
+
+void LActivation::resize(int batch){
+    if (fused) output->resize(batch, parent[0]->output->ptr, nullptr, false);
+    else Layer::resize(batch);
+    if (lse != nullptr) lse->resize(batch);
+}
+
 void LActivation::forward(){
+    if (fused) return;
 
     if (act == "relu"){
         tensorNN::ReLu(this->input, this->output);
@@ -97,7 +163,8 @@ void LActivation::forward(){
 
     }else if (act == "softmax"){
         int axis = (int)this->params[0];
-        tensorNN::FullSoftmax(this->input, this->output, axis);
+        if (lse != nullptr) tensorNN::SoftmaxLSE(this->input, this->output, lse);
+        else tensorNN::FullSoftmax(this->input, this->output, axis);
 
     }else if (act == "sigmoid"){
         tensorNN::Sigmoid(this->input, this->output);
@@ -120,8 +187,13 @@ void LActivation::forward(){
 
 
 void LActivation::backward(){
+    if (fused) return;
+
     if (delta_bp){
         Tensor::inc(delta, parent[0]->delta);
+    }else if (inplace){
+        float alpha = (act == "leaky_relu") ? this->params[0] : 0.0f;
+        tensorNN::D_Activation_(delta, output, getConvActivation(act), alpha);
     }else {
         if (act == "relu"){
             tensorNN::D_ReLu(delta, input, parent[0]->delta);
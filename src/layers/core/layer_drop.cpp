@@ -52,14 +52,15 @@ void LDropout::forward() {
         mask->fill_rand_binary_(1.0 - df);
         Tensor::el_mult(input, mask, output, 0);
     } else {
-        Tensor::copy(input, output);
+        if (!inplace) Tensor::copy(input, output);
         if (iw) output->mult_(1.0 - df);
     }
 
 }
 
 void LDropout::backward() {
-    Tensor::el_mult(delta, mask, parent[0]->delta, 1);
+    if (inplace) Tensor::el_mult(delta, mask, delta, 0);
+    else Tensor::el_mult(delta, mask, parent[0]->delta, 1);
 }
 
 
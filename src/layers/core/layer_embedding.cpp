@@ -19,7 +19,7 @@ using namespace std;
 
 int LEmbedding::total_layers = 0;
 
-LEmbedding::LEmbedding(Layer *parent, int vocsize, int length, int dim, bool mask_zeros, string name, int dev, int mem): LinLayer(name, dev, mem) {
+LEmbedding::LEmbedding(Layer *parent, int vocsize, int length, int dim, bool mask_zeros, string name, int dev, int mem, bool sparse_grad): LinLayer(name, dev, mem) {
     if(name.empty()) this->name = "embedding" + to_string(++total_layers);
 
 
@@ -27,6 +27,8 @@ LEmbedding::LEmbedding(Layer *parent, int vocsize, int length, int dim, bool mas
     this->vocsize=vocsize;
     this->dim=dim;
     this->mask_zeros=mask_zeros;
+    this->sparse_grad=sparse_grad && (dev==DEV_CPU);
+    this->root=this;
 
 
     input = parent->output;
@@ -61,6 +63,11 @@ LEmbedding::LEmbedding(Layer *parent, int vocsize, int length, int dim, bool mas
     gE=new Tensor({vocsize,dim},dev);
     gradients.push_back(gE);
 
+    if (this->sparse_grad) {
+      gE->fill_(0.0);
+      gtouched.resize(vocsize, 0);
+    }
+
 
     parent->addchild(this);
     addparent(parent);
@@ -118,18 +125,48 @@ void LEmbedding::backward()
 
      Tensor::deselect(delta,gE, sind, 0,sind.size(),1, mask_zeros); //1=inc
 
+     if (sparse_grad) {
+       for(int r : sind) {
+         if ((mask_zeros && r==0) || root->gtouched[r]) continue;
+         root->gtouched[r]=1;
+         root->grows.push_back(r);
+       }
+     }
+
      delta->reshape_({b,length*dim});
 
      if(reg!= nullptr) {reg->apply(E);}
    }
 }
 
+// Only the rows written since the last reset can be non-zero
+void LEmbedding::zeroGrads()
+{
+  if (!sparse_grad) {
+    Layer::zeroGrads();
+    return;
+  }
+
+  int w=gE->size/gE->shape[0];
+  for(int r : root->grows) {
+    Tensor row(vector<int>{w}, gE->ptr+(long int)r*w, dev);
+    row.fill_(0.0);
+    root->gtouched[r]=0;
+  }
+  root->grows.clear();
+}
 
+const vector<int> *LEmbedding::grad_rows(int i)
+{
+  if (!sparse_grad) return nullptr;
+  return &root->grows;
+}
 
 
 Layer *LEmbedding::share(int c, int bs, vector<Layer *> p) {
-    LEmbedding *n = new LEmbedding(p[0],vocsize, length, dim, mask_zeros, "share_"+to_string(c)+this->name, this->dev, this->mem_level);
+    LEmbedding *n = new LEmbedding(p[0],vocsize, length, dim, mask_zeros, "share_"+to_string(c)+this->name, this->dev, this->mem_level, sparse_grad);
     n->orig = this;
+    n->root = root;
     n->isshared=true;
     n->trainable = trainable;
 
@@ -152,7 +189,7 @@ Layer *LEmbedding::share(int c, int bs, vector<Layer *> p) {
 }
 
 Layer *LEmbedding::clone(int c, int bs, vector<Layer *> p, int todev) {
-    LEmbedding *n = new LEmbedding(p[0],vocsize, length, dim, mask_zeros, "clone_"+to_string(c)+this->name, todev, this->mem_level);
+    LEmbedding *n = new LEmbedding(p[0],vocsize, length, dim, mask_zeros, "clone_"+to_string(c)+this->name, todev, this->mem_level, sparse_grad);
     n->orig = this;
     n->trainable = trainable;
     n->reg=reg;
@@ -53,6 +53,17 @@ void LInput::free_delta(){
   delta->fill_(0.0);
 }
 
+void LInput::resize(int batch){
+  Layer::resize(batch);
+
+  // The delta is never freed (see free_delta), so it follows the batch here
+  if ((delta!=nullptr) && (delta->shape[0]!=batch)) {
+    delta->deleteData();
+    delta->resize(batch);
+    delta->fill_(0.0);
+  }
+}
+
 void LInput::forward() {
   if (parent.size()) {
     Tensor::copy(parent[0]->output,output);
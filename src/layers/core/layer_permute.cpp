@@ -62,10 +62,12 @@ void LPermute::resize(int b){
 }
 
 void LPermute::forward(){
+    if (inplace) return;
     tensorNN::select(this->input, this->output, sd);
 }
 
 void LPermute::backward(){
+    if (inplace) return;
     tensorNN::select_back(this->delta, this->parent[0]->delta, sd);
 }
 
@@ -23,6 +23,8 @@ int LReshape::total_layers = 0;
 
 LReshape::LReshape(Layer *parent, vector<int> shape, string name, int dev, int mem) : LinLayer(name, dev, mem) {
     ls = shape;
+    permute = false;
+    nhwc_delta = nullptr;
 
     if(name.empty()) this->name = "reshape" + to_string(++total_layers);
 
@@ -82,12 +84,29 @@ LReshape::LReshape(Layer *parent, vector<int> shape, string name, int dev, int m
 }
 
 LReshape::~LReshape(){
-    output=delta=nullptr;
+    // Converted copies are owned by this layer and deleted in ~Layer()
+    if (!permute) output=delta=nullptr;
+    delete nhwc_delta;
 }
 
 // virtual
 void LReshape::resize(int batch){
     ls[0]=batch;
+    if (permute) {
+        if (batch!=output->shape[0]) {
+            output->deleteData();
+            output->resize(batch);
+        }
+        if ((delta!=nullptr) && (batch!=delta->shape[0])) {
+            delta->deleteData();
+            delta->resize(batch);
+        }
+        if (batch!=nhwc_delta->shape[0]) {
+            nhwc_delta->deleteData();
+            nhwc_delta->resize(batch);
+        }
+        return;
+    }
 #ifdef cFPGA
     printf("voy a hacer resize!!!! batch %d shape[0] %d tensor_id %d, tensor_id parent %d fpga_ptr %p\n", batch, output->shape[0], output->fpga_tensor_id, parent[0]->output->fpga_tensor_id, parent[0]->output->fpga_ptr);
     output->resize(batch, parent[0]->output->ptr, parent[0]->output->fpga_ptr, false);
@@ -106,7 +125,8 @@ void LReshape::mem_delta() {
 #ifdef cFPGA
 	printf("creating new delta tensor for reshape at mem_delta\n");
 #endif
-        delta = new Tensor(ls, parent[0]->delta);
+        if (permute) delta = Tensor::zeros(ls, dev);
+        else delta = new Tensor(ls, parent[0]->delta);
 
         if(this->verbosity_level >= 2){
             std::cout << "Booked delta for: " + this->name << std::endl;
@@ -118,7 +138,7 @@ void LReshape::mem_delta() {
 void LReshape::free_delta() {
     if(this->delta != nullptr) {
         // Do not delete its delta directly (It's pointer points to parent's delta)
-        delta->ptr = nullptr;
+        if (!permute) delta->ptr = nullptr;
 #ifdef cFPGA
         delta->fpga_ptr = nullptr;
 #endif
@@ -131,13 +151,54 @@ void LReshape::free_delta() {
     }
 }
 
-void LReshape::forward() {
+// Gives "T" its own memory (view=false) or makes it a view of "src" again
+static void reshape_data(Tensor *T, Tensor *src, bool view) {
+    if (view) {
+        T->isshared = false;
+        T->deleteData();
+        T->updateData(src->ptr);
+    } else {
+        if (T->ptr2 != nullptr) { delete T->ptr2; T->ptr2 = nullptr; }
+        T->updateData(nullptr);
+    }
+}
+
+void LReshape::set_layout(int l) {
+    Layer::set_layout(l);
+
+    // Channels-last parents are converted here, so the flattened data keeps the channels-first order
+    bool p = (parent[0]->layout == LayoutNHWC);
+    if (p == permute) return;
+    permute = p;
 
+    reshape_data(output, parent[0]->output, !permute);
+    if (permute) nhwc_delta = new Tensor(parent[0]->output->getShape(), dev);
+    else {
+        delete nhwc_delta;
+        nhwc_delta = nullptr;
+    }
+    if (delta != nullptr) {
+        reshape_data(delta, parent[0]->delta, !permute);
+        if (permute) delta->fill_(0.0);
+    }
+}
+
+void LReshape::forward() {
+    if (permute) {
+        Tensor *nchw = new Tensor(parent[0]->output->getShape(), output);
+        tensorNN::permute_channels_first(parent[0]->output, nchw);
+        delete nchw;
+    }
 }
 
 
 void LReshape::backward() {
-
+    if (permute) {
+        Tensor *nchw = new Tensor(parent[0]->output->getShape(), delta);
+        tensorNN::permute_channels_last(nchw, nhwc_delta);
+        Tensor::inc(nhwc_delta, parent[0]->delta);
+        delete nchw;
+    }
 }
 
 
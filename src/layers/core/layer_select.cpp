@@ -62,10 +62,12 @@ void LSelect::resize(int b){
 }
 
 void LSelect::forward(){
+    if (inplace) return;
     tensorNN::select(this->input, this->output, sd);
 }
 
 void LSelect::backward(){
+    if (inplace) return;
     tensorNN::select_back(this->delta, this->parent[0]->delta, sd);
 }
 
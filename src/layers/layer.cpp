@@ -37,11 +37,14 @@ Layer::Layer(string name, int dev, int mem) {
     trainable=true;
     iscloned=false;
     isdecoder=false;
+    layout=LayoutNCHW;
+    inplace=false;
 
     orig=nullptr;
     net=nullptr;
 
     reg = nullptr;
+    rng = nullptr;
     //init=new IGlorotNormal(1234);
     init=new IGlorotUniform(1234);  // Has problems with the drive dataset
 }
@@ -79,6 +82,8 @@ Layer::~Layer(){
         }
     }
 
+    delete rng;
+
 }
 
 void Layer::initialize() {
@@ -115,7 +120,11 @@ void Layer::mem_delta_parent(){
 void Layer::mem_delta(){
     // Reserve space for the delta
     if(this->delta == nullptr){
-        this->delta = Tensor::zeros(this->output->shape, this->output->device);
+        if (inplace) {
+            parent[0]->mem_delta();
+            this->delta = new Tensor(this->output->shape, parent[0]->delta);
+        }
+        else this->delta = Tensor::zeros(this->output->shape, this->output->device);
 
         if(this->verbosity_level >= 2){
             std::cout << "Booked delta for: " + this->name << std::endl;
@@ -135,13 +144,43 @@ void Layer::free_delta(){
     }
 }
 
+void Layer::repoint_output(float *ptr){
+    float *old = output->ptr;
+    if (!output->isshared) output->deleteData();
+    else if (output->ndim == 2) { delete output->ptr2; output->ptr2 = nullptr; }
+    output->updateData(ptr, nullptr, ptr != nullptr);
+
+    if (old == nullptr) return;
+    for (auto *c : child)
+        if ((c->output != nullptr) && (c->output->isshared) && (c->output->ptr == old)) c->repoint_output(output->ptr);
+}
+
 void Layer::set_mem_level(int mem){
     mem_level=mem;
 }
 
+void Layer::set_layout(int l){
+    if ((l!=LayoutNCHW) && (layout_support()==LAYOUT_FIXED))
+        msg("Layer " + name + " only supports channels-first tensors", "Layer::set_layout");
+    layout=l;
+}
+
+// The output and delta become views of the parent ones. For element-wise layers, only valid when
+// the parent has no other child and its backward does not read its own output (see
+// Net::inplace_layers)
+void Layer::set_inplace(){
+    bool had_delta = (delta != nullptr);
+    free_delta();
+    inplace = true;
+    if (had_delta) mem_delta();
+
+    repoint_output(parent[0]->output->ptr);
+}
+
 void Layer::resize(int batch){
 //    cout<<name<<" resizing\n";
-    if (output!=nullptr) output->resize(batch);
+    if (inplace) output->resize(batch, parent[0]->output->ptr, nullptr, false);
+    else if (output!=nullptr) output->resize(batch);
 //    if (delta!=nullptr) { if (!mem_level) delta->resize(batch); }
 
 }
@@ -150,6 +189,11 @@ void Layer::setTrainable(bool value){
     trainable=value;
 }
 
+void Layer::set_seed(uint64_t seed){
+    if (rng==nullptr) rng = new PhiloxStream(seed);
+    else rng->seed(seed);
+}
+
 int Layer::get_trainable_params_count()
 {
     return params.size();
@@ -41,7 +41,7 @@ LGaussianNoise::~LGaussianNoise(){
 
 // virtual
 void LGaussianNoise::resize(int batch){
-    output->resize(batch);
+    Layer::resize(batch);
     noise->resize(batch);
 }
 
@@ -75,7 +75,7 @@ void LGaussianNoise::forward() {
     if (mode == TRMODE) {
         noise->fill_rand_normal_(0.0, stdev);
         Tensor::add(1.0, input, 1.0, noise, output, 0);
-    } else {
+    } else if (!inplace) {
         Tensor::copy(input, output);
     }
 }
@@ -103,6 +103,7 @@ void LBatchNorm::resize(int batch){
 // Batchnorm works over 2D Tensors
 // Essentialy 4D Tensors are reshaped as 2D and
 // Permute 4D tensors and set N,M values.
+// Channels-last 4D tensors are already {Batch*H*W,Channels} matrices
 void LBatchNorm::forward() {
     // Input = Output = opa = {Batch,Channels,H,W} OR {Batch,Dim}
     // bn_mean = bn_var = mean = variance = bn_g = bn_b = {Channels} or {Dim}
@@ -111,11 +112,26 @@ void LBatchNorm::forward() {
     int b,z,r,c,d;
     Tensor *in;
 
+    // CPU: one statistics pass and one normalize/affine pass over the input as is
+    if (input->isCPU()) {
+        opa->reshape_(input->getShape());
+        tensorNN::BatchNormForward(input, output, opa, mean, variance, affine ? bn_g : nullptr, affine ? bn_b : nullptr,
+                                   bn_mean, bn_var, mode==TRMODE, epsilon, momentum, layout==LayoutNHWC);
+        return;
+    }
+
     if (input->ndim==2) {
         N=b=input->shape[0];
         M=d=input->shape[1];
         in=input->clone();
     }
+    else if (layout==LayoutNHWC) {
+        M=input->shape[1];
+        N=input->size/M;
+        in=input->clone();
+        in->reshape_({N,M});
+        opa->reshape_({N,M});
+    }
     else {
         b=input->shape[0];
         M=z=input->shape[1];
@@ -146,7 +162,7 @@ void LBatchNorm::forward() {
     }
 
     // copy in to ouput
-    if (input->ndim==4) {
+    if ((input->ndim==4) && (layout==LayoutNCHW)) {
         tensorNN::permute_channels_first(in,output);
     }
     else Tensor::copy(in,output);
@@ -161,12 +177,25 @@ void LBatchNorm::backward(){
 
     Tensor *dp;
 
+    if (input->isCPU()) {
+        tensorNN::BatchNormBackward(delta, opa, parent[0]->delta, affine ? bn_g : nullptr, bn_var,
+                                    affine ? gbn_g : nullptr, affine ? gbn_b : nullptr, layout==LayoutNHWC);
+        return;
+    }
+
     if (input->ndim==2) {
         N=b=input->shape[0];
         M=d=input->shape[1];
 
         dp=delta->clone();
     }
+    else if (layout==LayoutNHWC) {
+        M=input->shape[1];
+        N=input->size/M;
+
+        dp=delta->clone();
+        dp->reshape_({N,M});
+    }
     else {
         b=input->shape[0];
         M=z=input->shape[1];
@@ -210,11 +239,14 @@ void LBatchNorm::backward(){
     BN_backward(dp,bn_var,opa);
 
     // Inc parent delta
-    if (input->ndim==4) {
+    if ((input->ndim==4) && (layout==LayoutNCHW)) {
         tensorNN::permute_channels_first(dp,delta);
         Tensor::inc(delta, parent[0]->delta);
     }
-    else Tensor::inc(dp, parent[0]->delta);
+    else {
+        dp->reshape_(delta->getShape());
+        Tensor::inc(dp, parent[0]->delta);
+    }
 
     delete dp;
 
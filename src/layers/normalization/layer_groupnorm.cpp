@@ -113,6 +113,13 @@ void LGroupNorm::forward()
     int M,N;
     int b,z,r,c,d;
 
+    // CPU: every (sample, group) is a contiguous row normalized on its own
+    if (input->isCPU()) {
+        opa->reshape_(input->getShape());
+        tensorNN::LayerNormForward(input, output, opa, bn_mean, bn_var, affine ? bn_g : nullptr, affine ? bn_b : nullptr, epsilon);
+        return;
+    }
+
 
     b=input->shape[0];
     z=input->shape[1];
@@ -184,6 +191,12 @@ void LGroupNorm::backward()
 
     Tensor *dp;
 
+    if (input->isCPU()) {
+        tensorNN::LayerNormBackward(delta, opa, parent[0]->delta, bn_var, affine ? bn_g : nullptr,
+                                    affine ? gbn_g : nullptr, affine ? gbn_b : nullptr);
+        return;
+    }
+
     b=delta->shape[0];
     z=delta->shape[1];
     r=delta->shape[2];
@@ -113,6 +113,14 @@ void LLayerNorm::forward() {
     int b,z,r,c,d;
 
     Tensor *in;
+
+    // CPU: one statistics pass and one normalize/affine pass per sample
+    if (input->isCPU()) {
+        opa->reshape_(input->getShape());
+        tensorNN::LayerNormForward(input, output, opa, mean, variance, affine ? bn_g : nullptr, affine ? bn_b : nullptr, epsilon);
+        return;
+    }
+
     if (input->ndim==2) {
         M=b=input->shape[0];
         N=d=input->shape[1];
@@ -176,6 +184,12 @@ void LLayerNorm::backward()
 
     Tensor *dp;
 
+    if (input->isCPU()) {
+        tensorNN::LayerNormBackward(delta, opa, parent[0]->delta, variance, affine ? bn_g : nullptr,
+                                    affine ? gbn_g : nullptr, affine ? gbn_b : nullptr);
+        return;
+    }
+
     if (input->ndim==2) {
         M=b=delta->shape[0];
         N=d=delta->shape[1];
@@ -41,13 +41,14 @@ LExp::LExp(Layer *l, string name, int dev, int mem) : OperatorLayer(name, dev, m
 }
 
 void LExp::forward() {
-    Tensor::copy(parent[0]->output, output);
+    if (!inplace) Tensor::copy(parent[0]->output, output);
     output->exp_();
 
 }
 
 void LExp::backward() {
-  Tensor::el_mult(delta, output, parent[0]->delta, 1);
+  if (inplace) Tensor::el_mult(delta, output, delta, 0);
+  else Tensor::el_mult(delta, output, parent[0]->delta, 1);
 }
 
 Layer *LExp::share(int c, int bs, vector<Layer *> p) {
@@ -41,14 +41,14 @@ int LSqrt::total_layers = 0;
   }
 
   void LSqrt::forward() {
-      Tensor::copy(parent[0]->output, output);
+      if (!inplace) Tensor::copy(parent[0]->output, output);
       output->sqrt_();
   }
 
   void LSqrt::backward() {
     Tensor::el_div(delta, output, delta, 0);
     delta->div_(2.0);
-    Tensor::inc(delta, parent[0]->delta);
+    if (!inplace) Tensor::inc(delta, parent[0]->delta);
   }
 
   Layer *LSqrt::share(int c, int bs, vector<Layer *> p) {
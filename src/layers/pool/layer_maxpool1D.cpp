@@ -29,17 +29,21 @@ LMaxPool1D::LMaxPool1D(Layer *parent, const vector<int> &pool_size, const vector
 LMaxPool1D::LMaxPool1D(Layer *parent, PoolDescriptor *D, const string& name, int dev, int mem) : LPool1D(parent, D, name, dev, mem) {
     if(name.empty()) this->name = "maxpool1D" + to_string(++total_layers);
 
-    // Params
-    D->indX = new Tensor(D->O->shape, dev);  // Is this needed here?
-    D->indY = new Tensor(D->O->shape, dev);
+    // Params (the CPU kernels keep a compact argmax of their own)
+    if (!D->I->isCPU()) {
+        D->indX = new Tensor(D->O->shape, dev);
+        D->indY = new Tensor(D->O->shape, dev);
+    }
 }
 
 
 void LMaxPool1D::resize(int batch){
   LPool1D::resize(batch);
 
-  delete pd->indX; pd->indX = new Tensor(pd->O->shape, dev);
-  delete pd->indY; pd->indY = new Tensor(pd->O->shape, dev);
+  if (!pd->I->isCPU()) {
+    delete pd->indX; pd->indX = new Tensor(pd->O->shape, dev);
+    delete pd->indY; pd->indY = new Tensor(pd->O->shape, dev);
+  }
 }
 
 void LMaxPool1D::forward() {
@@ -62,3 +62,9 @@ void LPool::resize(int batch){
     pd->resize(batch);
     
 }
+
+void LPool::set_layout(int l){
+    if ((l != LayoutNCHW) && (!input->isCPU())) msg("Channels-last layout is only available on CPU", "LPool::set_layout");
+    Layer::set_layout(l);
+    pd->layout_in = pd->layout_out = l;
+}
@@ -30,6 +30,11 @@ LLSTM::LLSTM(vector<Layer *> parent, int units, bool mask_zeros, bool bidirectio
 
     isrecurrent=true;
 
+    root = this;
+    Wx4 = Wh4 = b4 = nullptr;
+    gWx4 = gWh4 = gb4 = nullptr;
+    gates = tc = rmask = nullptr;
+
     if (parent[0]->output->ndim != 2) msg("LLSTM only works over 2D tensors", "LLSTM");
 
     if(name.empty()) this->name = "LSTM" + to_string(++total_layers);
@@ -109,6 +114,10 @@ LLSTM::LLSTM(vector<Layer *> parent, int units, bool mask_zeros, bool bidirectio
 
 LLSTM::~LLSTM(){
     delete state_c;
+
+    delete Wx4; delete Wh4; delete b4;
+    delete gWx4; delete gWh4; delete gb4;
+    delete gates; delete tc; delete rmask;
 }
 
 // RESIZE , MEM_DELTA states
@@ -191,8 +200,89 @@ Tensor *replicate_tensor(Tensor *input,int d)
 }
 
 
+// Fused CPU cell. Unrolled steps are shares of the root layer, which holds the packed
+// weights: the first step of a sequence packs them (they may have changed since the last
+// batch) and, being the last one to run backward, adds the packed gradients into the params.
+bool LLSTM::first_step() {
+    if (parent.size() < 2) return true;
+    auto *prev = dynamic_cast<LLSTM *>(parent[1]);
+    return (prev == nullptr) || (prev->root != root);
+}
+
+void LLSTM::pack_weights() {
+    if (Wx4 == nullptr) {
+        Wx4 = new Tensor(vector<int>{Wix->shape[0], 4*units}, dev);
+        Wh4 = new Tensor(vector<int>{units, 4*units}, dev);
+        b4 = new Tensor(vector<int>{4*units}, dev);
+        gWx4 = Tensor::zeros(Wx4->shape, dev);
+        gWh4 = Tensor::zeros(Wh4->shape, dev);
+        gb4 = Tensor::zeros(b4->shape, dev);
+    }
+    Tensor::concat({Wix, Wfx, Wox, Wcx}, 1, Wx4);
+    Tensor::concat({Wih, Wfh, Woh, Wch}, 1, Wh4);
+    Tensor::concat({inbias, fnbias, onbias, cnbias}, 0, b4);
+}
+
+void LLSTM::unpack_gradients() {
+    Tensor::concat_back(gWx4, {gWix, gWfx, gWox, gWcx}, 1);
+    Tensor::concat_back(gWh4, {gWih, gWfh, gWoh, gWch}, 1);
+    Tensor::concat_back(gb4, {ginbias, gfnbias, gonbias, gcnbias}, 0);
+    gWx4->fill_(0.0);
+    gWh4->fill_(0.0);
+    gb4->fill_(0.0);
+}
+
+void LLSTM::reserve_workspace(int batch) {
+    if ((gates != nullptr) && (gates->shape[0] == batch)) return;
+    delete gates; delete tc; delete rmask;
+    gates = new Tensor(vector<int>{batch, 4*units}, dev);
+    tc = new Tensor(vector<int>{batch, units}, dev);
+    rmask = new Tensor(vector<int>{batch}, dev);
+}
+
+void LLSTM::fused_forward() {
+    LLSTM *own = root;
+    if (first_step()) own->pack_weights();
+
+    // Only training needs the gates of every step; inference reuses one workspace
+    LLSTM *w = (mode == TRMODE) ? this : own;
+    w->reserve_workspace(input->shape[0]);
+
+    bool prev = parent.size() > 1;
+    Tensor::mult2D(input, 0, own->Wx4, 0, w->gates, 0);
+    if (prev) Tensor::mult2D(parent[1]->states[0], 0, own->Wh4, 0, w->gates, 1);
+
+    tensorNN::LSTMForward(input, w->gates, own->b4, prev ? parent[1]->states[1] : nullptr, prev ? parent[1]->states[0] : nullptr,
+                          mask_zeros ? w->rmask : nullptr, state_c, state_h, w->tc);
+}
+
+void LLSTM::fused_backward() {
+    LLSTM *own = root;
+    bool prev = parent.size() > 1;
+
+    // gates becomes the delta of the gate pre-activations
+    tensorNN::LSTMBackward(gates, tc, prev ? parent[1]->states[1] : nullptr, mask_zeros ? rmask : nullptr, delta_h, delta_c,
+                           prev ? parent[1]->delta_states[0] : nullptr, prev ? parent[1]->delta_states[1] : nullptr);
+
+    if (trainable) {
+        Tensor::mult2D(input, 1, gates, 0, own->gWx4, 1);
+        if (prev) Tensor::mult2D(parent[1]->states[0], 1, gates, 0, own->gWh4, 1);
+        Tensor::reduce_sum2D(gates, own->gb4, 0, 1);
+    }
+
+    Tensor::mult2D(gates, 0, own->Wx4, 1, parent[0]->delta, 1);
+    if (prev) Tensor::mult2D(gates, 0, own->Wh4, 1, parent[1]->delta_states[0], 1);
+
+    if (first_step()) own->unpack_gradients();
+}
+
 // virtual
 void LLSTM::forward() {
+    if (input->isCPU()) {
+        fused_forward();
+        return;
+    }
+
     if (mask_zeros) {
         mask=new Tensor({input->shape[0],1},dev);
         reduced_abs_sum(input,mask);
@@ -300,6 +390,11 @@ void LLSTM::forward() {
 }
 
 void LLSTM::backward() {
+    if (input->isCPU()) {
+        fused_backward();
+        return;
+    }
+
     //delta_h=delta;
     //delta_c
     if (mask_zeros) {
@@ -439,6 +534,7 @@ void LLSTM::backward() {
 Layer *LLSTM::share(int c, int bs, vector<Layer *> p) {
     LLSTM *n = new LLSTM(p, units, mask_zeros, bidirectional, "share_"+to_string(c)+this->name, this->dev, this->mem_level);
     n->orig = this;
+    n->root = root;
     n->isshared=true;
 
     //share params
@@ -0,0 +1,38 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "eddl/losses/loss.h"
+
+using namespace std;
+
+
+LSoftmaxCrossEntropy::LSoftmaxCrossEntropy(string name, Tensor *logits, Tensor *lse) : Loss(name){
+    this->logits = logits;
+    this->lse = lse;
+}
+
+
+void LSoftmaxCrossEntropy::delta(Tensor *T, Tensor *Y, Tensor *D) {
+    tensorNN::d_softmax_cross_entropy(T, Y, D);
+}
+
+float LSoftmaxCrossEntropy::value(Tensor *T, Tensor *Y) {
+    if (lse != nullptr) return tensorNN::softmax_cross_entropy(T, logits, lse);
+    return tensorNN::categorical_cross_entropy(T, Y);
+}
+
+Loss* LSoftmaxCrossEntropy::clone()
+{
+  return new LSoftmaxCrossEntropy(name, logits, lse);
+}
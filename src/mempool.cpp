@@ -0,0 +1,196 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+#include "eddl/mempool.h"
+
+using namespace std;
+
+#define MEMPOOL_ALIGN 64
+#define MEMPOOL_MIN_SHIFT 8     // Smallest block: 256 bytes
+#define MEMPOOL_MAX_SHIFT 48
+#define MEMPOOL_NCLASSES (4 * (MEMPOOL_MAX_SHIFT - MEMPOOL_MIN_SHIFT) + 1)
+#define MEMPOOL_LOCAL_BLOCKS 8  // Free blocks per class kept by a thread
+
+// Stored right before every block
+struct MemBlockHeader {
+    void *raw;     // What malloc returned
+    size_t bytes;  // Size of the class
+    int cls;
+};
+
+struct MemPoolShared {
+    mutex mtx;
+    vector<void *> blocks[MEMPOOL_NCLASSES];
+};
+
+struct MemPoolLocal {
+    vector<void *> blocks[MEMPOOL_NCLASSES];
+    ~MemPoolLocal();
+};
+
+static atomic<unsigned long long> pool_hits(0), pool_misses(0);
+static atomic<unsigned long long> pool_in_use(0), pool_cached(0), pool_peak(0);
+static atomic<size_t> pool_budget(0);
+
+// Never destroyed: blocks can be freed by static objects after everything else is gone
+static MemPoolShared &shared_pool() {
+    static MemPoolShared *s = new MemPoolShared;
+    return *s;
+}
+
+static thread_local MemPoolLocal local_pool;
+static thread_local bool local_gone = false;  // Trivial, so it can still be read after local_pool is destroyed
+
+// A thread that ends leaves its blocks to the others
+MemPoolLocal::~MemPoolLocal() {
+    MemPoolShared &s = shared_pool();
+    lock_guard<mutex> lock(s.mtx);
+    for (int c = 0; c < MEMPOOL_NCLASSES; c++)
+        s.blocks[c].insert(s.blocks[c].end(), blocks[c].begin(), blocks[c].end());
+    local_gone = true;
+}
+
+// Four classes per power of two: 2^e * (1 + q/4)
+static int size_class(size_t bytes, size_t &cbytes) {
+    if (bytes <= ((size_t)1 << MEMPOOL_MIN_SHIFT)) {
+        cbytes = (size_t)1 << MEMPOOL_MIN_SHIFT;
+        return 0;
+    }
+
+    int e = MEMPOOL_MIN_SHIFT;
+    while ((((size_t)1 << (e + 1)) < bytes) && (e < MEMPOOL_MAX_SHIFT)) e++;
+    if (e == MEMPOOL_MAX_SHIFT) return -1;
+
+    size_t base = (size_t)1 << e, step = base >> 2;
+    size_t q = (bytes - base + step - 1) / step;  // 1..4
+    cbytes = base + q * step;
+    return 4 * (e - MEMPOOL_MIN_SHIFT) + (int)q;
+}
+
+static MemBlockHeader *header(void *ptr) {
+    return (MemBlockHeader *)ptr - 1;
+}
+
+static void add_in_use(size_t bytes) {
+    unsigned long long now = (pool_in_use += bytes);
+    unsigned long long peak = pool_peak.load();
+    while ((now > peak) && !pool_peak.compare_exchange_weak(peak, now));
+}
+
+static void *pop(vector<void *> &blocks) {
+    if (blocks.empty()) return nullptr;
+    void *ptr = blocks.back();
+    blocks.pop_back();
+    return ptr;
+}
+
+static void release_all(vector<void *> *lists) {
+    for (int c = 0; c < MEMPOOL_NCLASSES; c++) {
+        for (void *ptr : lists[c]) {
+            pool_cached -= header(ptr)->bytes;
+            free(header(ptr)->raw);
+        }
+        lists[c].clear();
+    }
+}
+
+
+void *mempool_alloc(size_t bytes) {
+    size_t cbytes;
+    int c = size_class(bytes, cbytes);
+    if (c < 0) return nullptr;
+
+    void *ptr = local_gone ? nullptr : pop(local_pool.blocks[c]);
+    if (ptr == nullptr) {
+        MemPoolShared &s = shared_pool();
+        lock_guard<mutex> lock(s.mtx);
+        ptr = pop(s.blocks[c]);
+    }
+    if (ptr != nullptr) {
+        pool_hits++;
+        pool_cached -= cbytes;
+        add_in_use(cbytes);
+        return ptr;
+    }
+
+    // New block, making room in the budget with the cached ones if needed
+    size_t budget = pool_budget.load();
+    if ((budget > 0) && (pool_in_use + pool_cached + cbytes > budget)) {
+        mempool_release();
+        if (pool_in_use + cbytes > budget) return nullptr;
+    }
+
+    void *raw = malloc(cbytes + 2 * MEMPOOL_ALIGN);
+    if (raw == nullptr) {
+        mempool_release();
+        raw = malloc(cbytes + 2 * MEMPOOL_ALIGN);
+        if (raw == nullptr) return nullptr;
+    }
+
+    ptr = (void *)(((uintptr_t)raw + 2 * MEMPOOL_ALIGN - 1) & ~(uintptr_t)(MEMPOOL_ALIGN - 1));
+    *header(ptr) = {raw, cbytes, c};
+
+    pool_misses++;
+    add_in_use(cbytes);
+    return ptr;
+}
+
+void mempool_free(void *ptr) {
+    if (ptr == nullptr) return;
+
+    MemBlockHeader *h = header(ptr);
+    pool_in_use -= h->bytes;
+    pool_cached += h->bytes;
+
+    if (!local_gone && (local_pool.blocks[h->cls].size() < MEMPOOL_LOCAL_BLOCKS)) {
+        local_pool.blocks[h->cls].push_back(ptr);
+        return;
+    }
+
+    MemPoolShared &s = shared_pool();
+    lock_guard<mutex> lock(s.mtx);
+    s.blocks[h->cls].push_back(ptr);
+}
+
+void mempool_set_budget(size_t bytes) {
+    pool_budget = bytes;
+}
+
+size_t mempool_get_budget() {
+    return pool_budget.load();
+}
+
+// Other threads keep their own free blocks (a few per class) until they end
+void mempool_release() {
+    if (!local_gone) release_all(local_pool.blocks);
+
+    MemPoolShared &s = shared_pool();
+    lock_guard<mutex> lock(s.mtx);
+    release_all(s.blocks);
+}
+
+MemPoolStats mempool_stats() {
+    MemPoolStats st;
+    st.hits = pool_hits.load();
+    st.misses = pool_misses.load();
+    st.bytes_in_use = pool_in_use.load();
+    st.bytes_cached = pool_cached.load();
+    st.peak_bytes = pool_peak.load();
+    return st;
+}
+
+void mempool_reset_peak() {
+    pool_peak = pool_in_use.load();
+}
@@ -15,6 +15,7 @@
 
 #include <stdexcept>
 #include "eddl/net/compserv.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
 
 CompServ::CompServ()
 {
@@ -33,13 +34,14 @@ CompServ::CompServ(int t, const vector<int> g, const vector<int> &f,int lsb, int
     local_fpgas = vector<int>(f.begin(), f.end());
 
     this->lsb=lsb;
+    cpu_grain=CPU_GRAIN_DEFAULT;
 
     if (lsb<0) {
       throw std::runtime_error("Error creating CS with lsb<0 in CompServ::CompServ");
     }
 
     mem_level=mem;
-    if ((mem<0)||(mem>2)) {
+    if ((mem<0)||(mem>3)) {
       fprintf(stderr,"Error creating CS with incorrect memory saving level param in CompServ::CompServ");
       exit(EXIT_FAILURE);
     }
@@ -47,6 +49,7 @@ CompServ::CompServ(int t, const vector<int> g, const vector<int> &f,int lsb, int
       if (mem==0) fprintf(stderr,"CS with full memory setup\n");
       if (mem==1) fprintf(stderr,"CS with mid memory setup\n");
       if (mem==2) fprintf(stderr,"CS with low memory setup\n");
+      if (mem==3) fprintf(stderr,"CS with recompute memory setup\n");
     }
 
 }
@@ -61,6 +64,7 @@ CompServ * CompServ::share() {
   n->lsb=lsb;
   n->isshared=true;
   n->mem_level=mem_level;
+  n->cpu_grain=cpu_grain;
 
   return n;
 }
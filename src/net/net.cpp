@@ -68,9 +68,15 @@ Net::Net() {
     cs = nullptr;
     name="model";
     tr_batches=0;
+    trmode=TRMODE;
     flog_tr=nullptr;
     flog_ts=nullptr;
     rnet=nullptr;
+    param_arena=nullptr;
+    grad_arena=nullptr;
+    rng=nullptr;
+    memory_plan=false;
+    layout=LayoutNCHW;
     isbuild=false;
     isdecoder=false;
     isencoder=false;
@@ -160,6 +166,15 @@ Net::Net(vector <Net *> vnets):Net()
 
 Net::~Net(){
 
+    // The layer params and gradients are views, they do not own this memory
+    delete param_arena;
+    delete grad_arena;
+    delete rng;
+
+    // Planned outputs are views of these buffers
+    for(int i=0;i<plan_buffers.size();i++) delete plan_buffers[i];
+    for(int i=0;i<fused_losses.size();i++) delete fused_losses[i];
+
     if (mnets.size()) return;
 
 
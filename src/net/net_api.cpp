@@ -18,6 +18,7 @@
 #include "eddl/layers/core/layer_core.h"
 #include "eddl/net/net.h"
 #include "eddl/random.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
 #include "eddl/system_info.h"
 #include "eddl/utils.h"
 
@@ -153,6 +154,9 @@ void Net::run_snets(void *(*F)(void *t))
 
   int comp = snets.size();
 
+  // The grain of the CPU kernels is global, nets built with different CompServs set their own
+  if (cs != nullptr) cpu_set_grain(cs->cpu_grain);
+
   #pragma omp parallel for
   for (int i = 0; i < comp; i++) {
     // Thread params
@@ -170,6 +174,31 @@ void Net::setmode(int m) {
   for (int i = 0; i < snets.size(); i++)
   for (int j = 0; j < snets[i]->layers.size(); j++)
   snets[i]->layers[j]->setmode(m);
+
+  // Training needs every output for the backward
+  for (int i = 0; i < snets.size(); i++)
+    if ((m==TSMODE) && (memory_plan)) snets[i]->make_memory_plan();
+    else snets[i]->drop_memory_plan();
+}
+
+// While enabled, the intermediate outputs share memory in TSMODE (see make_memory_plan)
+void Net::plan_memory(bool enable) {
+  memory_plan=enable;
+  setmode(trmode);
+}
+
+// Every layer gets its own stream, seeded from the one of the net, so stochastic layers
+// (dropout, noise, data augmentation) give the same results on every run with any threads
+void Net::set_seed(uint64_t seed) {
+  if (rng==nullptr) rng=new PhiloxStream(seed);
+  else rng->seed(seed);
+
+  for (int i = 0; i < snets.size(); i++)
+  for (int j = 0; j < snets[i]->layers.size(); j++)
+  snets[i]->layers[j]->set_seed(rng->next_seed());
+
+  if (snets.empty())
+    for (int j = 0; j < layers.size(); j++) layers[j]->set_seed(rng->next_seed());
 }
 
 void Net::clamp(float min,float max)
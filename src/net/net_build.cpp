@@ -10,15 +10,24 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <chrono>
+#include <map>
+#include <set>
+#include <algorithm>
 #include "eddl/net/net.h"
 #include "eddl/utils.h"
 #include "eddl/random.h"
 
 #include "eddl/layers/core/layer_core.h"
+#include "eddl/layers/conv/layer_conv.h"
+#include "eddl/layers/pool/layer_pool.h"
+#include "eddl/layers/merge/layer_merge.h"
+#include "eddl/layers/normalization/layer_normalization.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
 
 #ifdef cGPU
 #include "eddl/hardware/gpu/gpu_tensor.h"
@@ -136,6 +145,10 @@ void Net::toCPU(int t){
 
     set_compserv(cs);
 
+    make_checkpoints();
+    for (int i = 0; i < snets.size(); i++)
+      if (snets[i]!=this) snets[i]->make_checkpoints();
+
     if (cs->type == "local") {
       if (VERBOSE)  {
         if (snets[0]->dev == DEV_CPU)
@@ -150,6 +163,8 @@ void Net::toCPU(int t){
 void Net::toGPU(vector<int> g,int lsb,int mem){
     CompServ *cs=new CompServ(0, g, {},lsb,mem);
 
+    for (int i = 0; i < snets.size(); i++) snets[i]->drop_memory_plan();
+
     for (int i = 0; i < snets.size(); i++) {
       Xs[i].clear();
       Ys[i].clear();
@@ -159,6 +174,10 @@ void Net::toGPU(vector<int> g,int lsb,int mem){
 
     set_compserv(cs);
 
+    make_checkpoints();
+    for (int i = 0; i < snets.size(); i++)
+      if (snets[i]!=this) snets[i]->make_checkpoints();
+
     if (VERBOSE) {
     if (cs->type == "local") {
       if (snets[0]->dev == DEV_CPU)
@@ -171,7 +190,7 @@ void Net::toGPU(vector<int> g,int lsb,int mem){
   }
 }
 
-void Net::build(Optimizer *opt, vloss lo, vmetrics me, CompServ *cs, bool initialize){
+void Net::build(Optimizer *opt, vloss lo, vmetrics me, CompServ *cs, bool initialize, bool flat_params, bool inplace){
 	onnx_pretrained = !initialize; // For controlling when to copy the weights to the snet
 
   if (isbuild) return;
@@ -193,6 +212,18 @@ void Net::build(Optimizer *opt, vloss lo, vmetrics me, CompServ *cs, bool initia
 
   set_compserv(cs);
 
+  fuse_layers();
+  if (inplace) inplace_layers();
+
+  if (flat_params) {
+    make_arenas();
+    for(int i=0;i<snets.size();i++) snets[i]->make_arenas();
+  }
+
+  make_checkpoints();
+  for(int i=0;i<snets.size();i++)
+    if (snets[i]!=this) snets[i]->make_checkpoints();
+
   if (VERBOSE) {
     if (cs->type == "local") {
       if (snets[0]->dev == DEV_CPU)
@@ -247,6 +278,29 @@ void Net::build(Optimizer *opt, vloss lo, vmetrics me, bool initialize) {
     for (int i = 0; i < losses.size(); i++) {
         if (losses[i]->name == "softmax_cross_entropy") lout[i]->delta_bp = 1;
         lout[i]->target = new Tensor(lout[i]->output->getShape(), dev);
+
+        // Softmax + cross-entropy: the loss is computed from the logits (log-sum-exp kept by the
+        // forward on CPU) and its delta, softmax - target, goes through the softmax untouched.
+        // For categorical_cross_entropy this is its exact gradient when every target row sums to
+        // one (y * sum(t) - t otherwise)
+        LActivation *a=dynamic_cast<LActivation *>(lout[i]);
+        bool ce=(losses[i]->name == "softmax_cross_entropy") || (losses[i]->name == "categorical_cross_entropy");
+        if ((a!=nullptr) && (a->act=="softmax") && (ce)) {
+            if ((dev==DEV_CPU) && ((int)a->params[0]==a->output->ndim-1) && (a->lse==nullptr)) {
+                vector<int> rows=a->output->getShape();
+                rows.pop_back();
+                a->lse=new Tensor(rows, dev);
+            }
+            a->delta_bp = 1;
+            // The losses belong to the caller (split and unroll build every snet with the ones of
+            // the main net) and are never freed here. A fused one is only kept if it is bound to
+            // the logits of this net, the new ones are owned by the net
+            LSoftmaxCrossEntropy *fused=dynamic_cast<LSoftmaxCrossEntropy *>(losses[i]);
+            if ((fused==nullptr) || (fused->logits!=a->input)) {
+                losses[i] = new LSoftmaxCrossEntropy(losses[i]->name, a->input, a->lse);
+                fused_losses.push_back(losses[i]);
+            }
+        }
     }
     // set metrics
     if (isdecoder) {
@@ -265,6 +319,283 @@ void Net::build(Optimizer *opt, vloss lo, vmetrics me, bool initialize) {
     if(initialize) do_initialize();
 }
 
+// Moves all the params and gradients of the net into two contiguous tensors (see Tensor::pack),
+// so zeroing, clipping, optimizer steps and the averaging of snets run once over each of them
+void Net::make_arenas(){
+    if (param_arena!=nullptr) return;
+
+    // Trainable first, skipping the tensors of shared layers already seen
+    vtensor params, grads, rest_params, rest_grads;
+    set<Tensor *> seen;
+    bool dup=false;
+    for(int i=0;i<layers.size();i++) {
+        Layer *l=layers[i];
+        int nt=l->get_trainable_params_count();
+        for(int j=0;j<l->params.size();j++) {
+            if (!seen.insert(l->params[j]).second) { dup=dup || (j<nt); continue; }
+            if (j<nt) params.push_back(l->params[j]);
+            else rest_params.push_back(l->params[j]);
+        }
+        for(int j=0;j<l->gradients.size();j++) {
+            if (!seen.insert(l->gradients[j]).second) continue;
+            if (j<nt) grads.push_back(l->gradients[j]);
+            else rest_grads.push_back(l->gradients[j]);
+        }
+    }
+
+    int ntrain=params.size();
+    int ngrads=grads.size();
+    params.insert(params.end(), rest_params.begin(), rest_params.end());
+    grads.insert(grads.end(), rest_grads.begin(), rest_grads.end());
+    if (params.empty()) return;
+
+    param_arena=Tensor::pack(params);
+    if (!grads.empty()) grad_arena=Tensor::pack(grads);
+
+    // The optimizer keeps one state tensor per trainable param (shared ones included), so it
+    // can only follow the arenas when there are no duplicates
+    if ((optimizer==nullptr) || (dup) || (ntrain==0) || (ngrads!=ntrain)) return;
+
+    long int psize=(ntrain<params.size()) ? params[ntrain]->ptr-param_arena->ptr : param_arena->size;
+    long int gsize=(ngrads<grads.size()) ? grads[ngrads]->ptr-grad_arena->ptr : grad_arena->size;
+    if (psize!=gsize) return;
+
+    optimizer->set_flat(new Tensor({(int)psize}, param_arena->ptr, param_arena->device),
+                        new Tensor({(int)gsize}, grad_arena->ptr, grad_arena->device));
+}
+
+// Points t to p, or to new memory of its own when p is null. Shared tensors keep their data
+static void repoint(Tensor *t, float *p){
+    if (!t->isshared) t->deleteData();
+    else if (t->ndim==2) { delete t->ptr2; t->ptr2=nullptr; }
+    t->updateData(p, nullptr, p!=nullptr);
+}
+
+// Groups the outputs of vfts by the memory they use: group[i] is the layer that owns the memory
+// of the i-th output (views such as Reshape point to the output of a parent), and last[g] the
+// last layer that reads the memory of the owner g. The owners that must keep their memory
+// (inputs, outputs of the net, outputs of unknown origin) are pinned.
+static void output_groups(Net *net, vector<int> &group, vector<int> &last, vector<bool> &pinned){
+    vlayer &vfts=net->vfts;
+    int n=vfts.size();
+    map<Layer *, int> pos;
+    for(int i=0;i<n;i++) pos[vfts[i]]=i;
+
+    group.assign(n, 0);
+    last.assign(n, 0);
+    pinned.assign(n, false);
+
+    for(int i=0;i<n;i++) {
+        Layer *l=vfts[i];
+        group[i]=i;
+        last[i]=i;
+
+        if ((l->output==nullptr) || (!l->output->isCPU()) || (l->parent.empty()) || (dynamic_cast<LInput *>(l)!=nullptr)) {
+            pinned[i]=true;
+            continue;
+        }
+
+        bool view=l->output->isshared;
+        for(int j=0;j<l->parent.size();j++) {
+            Layer *p=l->parent[j];
+            auto it=pos.find(p);
+            if ((it!=pos.end()) && (view) && (p->output!=nullptr) && (p->output->ptr==l->output->ptr)) {
+                group[i]=group[it->second];
+                view=false;
+            }
+            if (it!=pos.end()) last[group[it->second]]=std::max(last[group[it->second]], i);
+        }
+        if (view) pinned[i]=true;  // Shared with something out of the forward graph
+        last[group[i]]=std::max(last[group[i]], i);
+    }
+
+    for(int i=0;i<n;i++)
+        if (pinned[i]) pinned[group[i]]=true;
+    // The fused softmax losses also read the input of the output layers
+    vlayer keep(net->lin);
+    keep.insert(keep.end(), net->din.begin(), net->din.end());
+    for(int i=0;i<net->lout.size();i++) {
+        keep.push_back(net->lout[i]);
+        keep.insert(keep.end(), net->lout[i]->parent.begin(), net->lout[i]->parent.end());
+    }
+    for(int i=0;i<keep.size();i++) {
+        auto it=pos.find(keep[i]);
+        if (it!=pos.end()) pinned[group[it->second]]=true;
+    }
+}
+
+// Static memory plan for inference. Every output is live from the layer that writes it until
+// its last consumer in vfts (see output_groups), so the outputs that are not pinned are packed,
+// greedily and in forward order, into a few shared buffers: each one takes the free buffer that
+// fits it best, and gives it back after its last use. A layer never writes into the buffer of an
+// input it is still reading.
+void Net::make_memory_plan(){
+    if ((!plan_layers.empty()) || (isrecurrent) || (dev!=DEV_CPU)) return;
+
+    int n=vfts.size();
+    vector<int> group, last;
+    vector<bool> pinned;
+    output_groups(this, group, last, pinned);
+
+    // Best fit, growing the largest free buffer when none is big enough
+    vector<long int> bsize;
+    vector<int> freeb, owner_buf(n, -1);
+    vector<vector<int> > release(n);
+    for(int i=0;i<n;i++) {
+        if ((group[i]==i) && (!pinned[i])) {
+            long int need=vfts[i]->output->size;
+            int best=-1;
+            for(int k=0;k<freeb.size();k++) {
+                long int s=bsize[freeb[k]];
+                if (best<0) { best=k; continue; }
+                long int bs=bsize[freeb[best]];
+                if ((s>=need) ? ((bs<need) || (s<bs)) : ((bs<need) && (s>bs))) best=k;
+            }
+
+            int b;
+            if (best<0) {
+                b=bsize.size();
+                bsize.push_back(need);
+            }
+            else {
+                b=freeb[best];
+                freeb.erase(freeb.begin()+best);
+                bsize[b]=std::max(bsize[b], need);
+            }
+            owner_buf[i]=b;
+            release[last[i]].push_back(b);
+        }
+        freeb.insert(freeb.end(), release[i].begin(), release[i].end());
+    }
+
+    for(int b=0;b<bsize.size();b++)
+        plan_buffers.push_back(new Tensor({(int)bsize[b]}, DEV_CPU));
+
+    for(int i=0;i<n;i++) {
+        int g=group[i];
+        if (owner_buf[g]<0) continue;
+        repoint(vfts[i]->output, (g==i) ? plan_buffers[owner_buf[g]]->ptr : vfts[g]->output->ptr);
+        plan_layers.push_back(vfts[i]);
+        plan_source.push_back((g==i) ? nullptr : vfts[g]);
+    }
+}
+
+// Gives the planned outputs their own memory again
+void Net::drop_memory_plan(){
+    for(int i=0;i<plan_layers.size();i++)
+        repoint(plan_layers[i]->output, (plan_source[i]==nullptr) ? nullptr : plan_source[i]->output->ptr);
+
+    for(int i=0;i<plan_buffers.size();i++) delete plan_buffers[i];
+    plan_buffers.clear();
+    plan_layers.clear();
+    plan_source.clear();
+}
+
+// Gradient checkpointing (mem_level 3). vfts is split in segments that end at the checkpoint
+// layers, or every sqrt(N) layers when there are none. In training, the outputs that are only
+// read inside their segment are dropped once the segment has run forward, and the segment runs
+// again right before its backward. The last segment, the checkpoints and the outputs pinned by
+// output_groups keep their memory. Batch normalization layers are not run twice (their running
+// stats would move twice), so they keep their output too. Every recomputed layer gets its own
+// stream, rewound before running again, so dropout masks and the like do not change.
+void Net::make_checkpoints(){
+    // Back to full outputs before changing the segments
+    for(int s=0;s<ckpt_drop.size();s++) restore_segment(s);
+    ckpt_fseg.clear();
+    ckpt_bseg.clear();
+    ckpt_source.clear();
+    ckpt_drop.clear();
+    ckpt_counter.clear();
+
+    if ((mem_level<3) || (isrecurrent) || (dev!=DEV_CPU) || (vfts.empty())) return;
+
+    int n=vfts.size();
+    vector<int> group, last;
+    vector<bool> pinned;
+    output_groups(this, group, last, pinned);
+
+    map<Layer *, int> pos;
+    for(int i=0;i<n;i++) pos[vfts[i]]=i;
+
+    vector<bool> ends(n, false);
+    if (checkpoints.empty()) {
+        int k=(int)ceil(sqrt((double)n));
+        for(int i=k-1;i<n;i+=k) ends[i]=true;
+    }
+    for(int i=0;i<checkpoints.size();i++) {
+        auto it=pos.find(checkpoints[i]);
+        if (it==pos.end()) msg("Checkpoint "+checkpoints[i]->name+" is not in the net", "Net.make_checkpoints");
+        ends[it->second]=true;
+    }
+
+    ckpt_fseg.assign(n, 0);
+    for(int i=1;i<n;i++) ckpt_fseg[i]=ckpt_fseg[i-1]+ends[i-1];
+    int nseg=ckpt_fseg[n-1]+1;
+
+    for(int i=0;i<n;i++)
+        if ((ends[i]) || (dynamic_cast<LBatchNorm *>(vfts[i])!=nullptr)) pinned[group[i]]=true;
+
+    ckpt_drop.resize(nseg);
+    ckpt_source.assign(n, -1);
+    ckpt_counter.assign(n, 0);
+    for(int i=0;i<n;i++) {
+        int g=group[i], s=ckpt_fseg[i];
+        if ((pinned[g]) || (s==nseg-1) || (ckpt_fseg[last[g]]!=ckpt_fseg[g])) continue;
+
+        ckpt_drop[s].push_back(i);
+        if (g!=i) ckpt_source[i]=g;
+        if (vfts[i]->rng==nullptr) vfts[i]->set_seed(random_stream().next_seed());
+    }
+
+    for(int i=0;i<vbts.size();i++) {
+        auto it=pos.find(vbts[i]);
+        ckpt_bseg.push_back((it==pos.end()) ? -1 : ckpt_fseg[it->second]);
+    }
+}
+
+void Net::set_checkpoints(vlayer l){
+    checkpoints=l;
+    make_checkpoints();
+}
+
+// Gives memory back to the outputs dropped in segment s. False if none was dropped
+bool Net::restore_segment(int s){
+    bool dropped=false;
+    for(int i : ckpt_drop[s]) {
+        Tensor *t=vfts[i]->output;
+        if (ckpt_source[i]>=0) repoint(t, vfts[ckpt_source[i]]->output->ptr);
+        else if (t->ptr==nullptr) {
+            t->updateData(nullptr, nullptr, false);
+            dropped=true;
+        }
+    }
+    return dropped;
+}
+
+void Net::drop_segment(int s){
+    for(int i : ckpt_drop[s]) {
+        Tensor *t=vfts[i]->output;
+        if (t->isshared) {
+            if (t->ndim==2) { delete t->ptr2; t->ptr2=nullptr; }
+            t->ptr=nullptr;
+        }
+        else t->deleteData();
+    }
+}
+
+// Runs the dropped layers of segment s again, with the random numbers of their last forward
+void Net::recompute_segment(int s){
+    if (!restore_segment(s)) return;
+
+    for(int i : ckpt_drop[s]) {
+        Layer *l=vfts[i];
+        l->rng->counter=ckpt_counter[i];
+        set_random_stream(l->rng);
+        l->forward();
+        set_random_stream(nullptr);
+    }
+}
+
 void Net::set_compserv(CompServ *cs){
     int todev;
     this->cs=cs;
@@ -473,6 +804,9 @@ void Net::resize(int b)
   batch_size=b;
   if (VERBOSE) cout<<"Resizing Net to batch_size="<<batch_size<<"\n";
 
+  // The plan depends on the sizes of the outputs
+  for (i = 0; i < snets.size(); i++) snets[i]->drop_memory_plan();
+
   int c=snets.size();
   int bs,m;
 
@@ -502,6 +836,15 @@ void Net::resize(int b)
         snets[i]->layers[j]->resize(bs);
       }
 
+    // Deltas kept between batches (full_mem) are booked again with the new size
+    vector<Layer *> booked;
+    for (j = 0; j < snets[i]->layers.size(); j++)
+      if (snets[i]->layers[j]->delta!=nullptr) {
+        booked.push_back(snets[i]->layers[j]);
+        snets[i]->layers[j]->free_delta();
+      }
+    for (j = 0; j < booked.size(); j++) booked[j]->mem_delta();
+
     for (j = 0; j < snets[i]->lin.size(); j++)
         Xs[i].push_back(new Tensor(snets[i]->lin[j]->input->shape));
 
@@ -509,6 +852,9 @@ void Net::resize(int b)
         Ys[i].push_back(new Tensor(snets[i]->lout[j]->output->shape));
   }
 
+  if ((trmode==TSMODE) && (memory_plan))
+    for (i = 0; i < snets.size(); i++) snets[i]->make_memory_plan();
+
   reset();
 
 }
@@ -531,6 +877,129 @@ void Net::setTrainable(string lname, bool val)
   }//layers
 }
 
+void Net::setConvAlgorithm(int algo)
+{
+  for(int i=0;i<layers.size();i++) {
+    LConv *l=dynamic_cast<LConv *>(layers[i]);
+    if (l!=nullptr) l->cd->set_algorithm(algo);
+  }
+
+  for(int j=0;j<snets.size();j++)
+    if (snets[j]!=this) snets[j]->setConvAlgorithm(algo);
+}
+
+// Conv+Activation fusion (CPU): the convolution applies the activation on its output tiles
+// and the activation layer becomes a view of the convolution output. Every CPU algorithm
+// (im2col, Winograd and depthwise) runs it inside its kernel, see cpu_conv2D_epilogue
+void Net::fuse_layers()
+{
+  if ((snets[0]->dev != DEV_CPU) || (isrecurrent)) return;
+
+  for(int i=0;i<layers.size();i++) {
+    LConv *l=dynamic_cast<LConv *>(layers[i]);
+    if ((l==nullptr) || (l->child.size()!=1)) continue;
+
+    int o;
+    if (isIn(l,lout,o)) continue;
+
+    LActivation *a=dynamic_cast<LActivation *>(l->child[0]);
+    if ((a==nullptr) || (a->fused) || (!isIn(a,layers,o))) continue;
+
+    int act=getConvActivation(a->act);
+    if (act==ConvActNone) continue;
+    if ((act==ConvActLeakyReLU) && (a->params[0]<0.0f)) continue;
+
+    l->cd->act=act;
+    l->cd->act_param=(act==ConvActLeakyReLU) ? a->params[0] : 0.0f;
+    a->fuse();
+  }
+}
+
+// Layers whose backward does not read their own output, so a child can overwrite it
+static bool output_unused_in_backward(Layer *l){
+  return (dynamic_cast<LConv *>(l)!=nullptr) || (dynamic_cast<LDense *>(l)!=nullptr) ||
+         (dynamic_cast<LBatchNorm *>(l)!=nullptr) || (dynamic_cast<LMaxPool *>(l)!=nullptr) ||
+         (dynamic_cast<LAveragePool *>(l)!=nullptr) || (dynamic_cast<LAdd *>(l)!=nullptr) ||
+         (dynamic_cast<LConcat *>(l)!=nullptr);
+}
+
+// In-place execution (CPU): an element-wise layer that can run in place (see Layer::can_inplace)
+// writes its output over the output of its parent, and its delta is the parent delta, when
+// nothing else reads the parent output: a single child, not an input or output of the net, and
+// a backward that only needs its input and delta. Layers that can be views (see Layer::can_view)
+// write nothing, so they always become views
+void Net::inplace_layers()
+{
+  if ((snets[0]->dev != DEV_CPU) || (isrecurrent)) return;
+
+  for(int i=0;i<layers.size();i++) {
+    Layer *l=layers[i];
+    if ((l->inplace) || (l->parent.size()!=1)) continue;
+    if (l->can_view()) {
+      l->set_inplace();
+      continue;
+    }
+    if (!l->can_inplace()) continue;
+
+    int o;
+    Layer *p=l->parent[0];
+    if ((p->child.size()!=1) || (p->output->isshared) || (!isIn(p,layers,o)) || (isIn(p,lin,o)) || (isIn(p,lout,o))) continue;
+    if (!output_unused_in_backward(p)) continue;
+
+    l->set_inplace();
+  }
+}
+
+void Net::setLayout(int layout)
+{
+  if (!isbuild) msg("The model must be built before setting its layout", "Net::setLayout");
+  if ((layout != LayoutNCHW) && (snets[0]->dev != DEV_CPU)) msg("Channels-last layout is only available on CPU", "Net::setLayout");
+
+  // Candidates: 4D layers that can work channels-last and are not outputs of the net
+  map<Layer *, bool> nhwc;
+  for(int i=0;i<layers.size();i++) {
+    Layer *l=layers[i];
+    int s=l->layout_support();
+    int o=0;
+    nhwc[l]=(layout==LayoutNHWC) && ((s==LAYOUT_KEEP) || (s==LAYOUT_CONVERT)) &&
+            (l->output->ndim==4) && (l->child.size()>0) && (!isIn(l,lout,o));
+  }
+
+  // Drop candidates until every channels-last output only feeds layers that can read it,
+  // and every LAYOUT_KEEP layer only reads channels-last inputs
+  bool changed=true;
+  while (changed) {
+    changed=false;
+    for(int i=0;i<layers.size();i++) {
+      Layer *l=layers[i];
+      if (!nhwc[l]) continue;
+
+      bool ok=true;
+      if (l->layout_support()==LAYOUT_KEEP)
+        for(int j=0;j<l->parent.size();j++)
+          if (!nhwc[l->parent[j]]) ok=false;
+
+      for(int j=0;j<l->child.size();j++) {
+        int s=l->child[j]->layout_support();
+        if ((!nhwc[l->child[j]]) && (s!=LAYOUT_CONVERT) && (s!=LAYOUT_BOUNDARY)) ok=false;
+      }
+
+      if (!ok) {
+        nhwc[l]=false;
+        changed=true;
+      }
+    }
+  }
+
+  // Parents first, so every layer sees the final layout of its inputs
+  for(int i=0;i<vfts.size();i++)
+    vfts[i]->set_layout(nhwc[vfts[i]] ? LayoutNHWC : LayoutNCHW);
+
+  this->layout=layout;
+  for(int j=0;j<snets.size();j++)
+    if (snets[j]!=this) snets[j]->setLayout(layout);
+  if (rnet!=nullptr) rnet->setLayout(layout);
+}
 
 void Net::removeLayer(string lname)
 {
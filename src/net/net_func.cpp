@@ -41,6 +41,14 @@ void Net::do_reset() {
 }
 
 void Net::do_reset_grads() {
+  if (grad_arena!=nullptr) {
+    grad_arena->fill_(0.0);
+    // Row-sparse gradients also forget their rows
+    for (int i = 0; i != layers.size(); i++)
+      if (layers[i]->grad_rows(0)!=nullptr) layers[i]->zeroGrads();
+    return;
+  }
+
   for (int i = 0; i != layers.size(); i++) {
     layers[i]->zeroGrads();
   }
@@ -50,17 +58,29 @@ void Net::do_forward() {
   if (VERBOSE) {
     cout<<"START FORWARD\n";
   }
+  bool ckpt=!ckpt_fseg.empty();
   for (int i = 0; i < vfts.size(); i++) {
+    // Segments dropped by the checkpointing get their memory back before running
+    if (ckpt) {
+      if ((i==0) || (ckpt_fseg[i-1]!=ckpt_fseg[i])) restore_segment(ckpt_fseg[i]);
+      if (vfts[i]->rng!=nullptr) ckpt_counter[i]=vfts[i]->rng->counter;
+    }
+
     if (VERBOSE) {
       cout << vfts[i]->name << " Shape: ";
       for(int j=0;j<vfts[i]->parent.size();j++)
       fprintf(stdout, "  %s In[%d,%s]:%f\n", vfts[i]->name.c_str(), j, vfts[i]->parent[j]->name.c_str(),vfts[i]->parent[j]->output->sum());
     }
 
+    set_random_stream(vfts[i]->rng);
     vfts[i]->forward();
+    set_random_stream(nullptr);
     if (VERBOSE) {
       fprintf(stdout, "  %s Out:%f\n", vfts[i]->name.c_str(), vfts[i]->output->sum());
     }
+
+    if ((ckpt) && (trmode==TRMODE) && ((i==vfts.size()-1) || (ckpt_fseg[i+1]!=ckpt_fseg[i])))
+      drop_segment(ckpt_fseg[i]);
   }
   if (VERBOSE) {
     cout<<"END FORWARD\n";
@@ -72,10 +92,18 @@ void Net::do_backward() {
   if (VERBOSE) {
     cout<<"START BACKWARD\n";
   }
+  // Layers left to run backward in each checkpointed segment
+  vector<int> left(ckpt_drop.size(), 0);
+  for (int i = 0; i < ckpt_bseg.size(); i++)
+    if (ckpt_bseg[i]>=0) left[ckpt_bseg[i]]++;
+
   for (int i = 0; i < vbts.size(); i++) {
 
     if (!vbts[i]->trainable) return;
 
+    int s=ckpt_bseg.empty() ? -1 : ckpt_bseg[i];
+    if (s>=0) recompute_segment(s);
+
     if(this->verbosity_level >= 1){
       std::cout << vbts[i]->name << std::endl;
     }
@@ -93,6 +121,8 @@ void Net::do_backward() {
 
     // Delete this delta
     if(vbts[i]->mem_level) { vbts[i]->free_delta(); }
+
+    if ((s>=0) && (--left[s]==0)) drop_segment(s);
   }
   if (VERBOSE) {
     cout<<"END BACKWARD\n";
@@ -150,6 +180,23 @@ void Net::do_applygrads() {
 
 void Net::sync_weights() {
   //cout<<"\nSync weights...\n";
+
+  // Flat params: the same average over the whole arenas
+  bool flat=(param_arena!=nullptr);
+  for (int i = 0; i < snets.size(); i++)
+    flat=flat && (snets[i]->param_arena!=nullptr) && (snets[i]->param_arena->size==param_arena->size);
+
+  if (flat) {
+    param_arena->fill_(0.0);
+    for (int i = 0; i < snets.size(); i++)
+      Tensor::inc(snets[i]->param_arena, param_arena);
+    param_arena->div_(snets.size());
+
+    for (int i = 0; i < snets.size(); i++)
+      Tensor::copy(param_arena, snets[i]->param_arena);
+    return;
+  }
+
   for (int j = 0; j < layers.size(); j++)
   for (int k = 0; k < layers[j]->params.size(); k++) {
     // Taking average
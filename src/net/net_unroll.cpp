@@ -503,6 +503,8 @@ void Net::build_rnet(int inl,int outl) {
 
 
    rnet->build(optimizer->share(),lr,mr,cs->share(),false);
+   if (rng!=nullptr) rnet->set_seed(rng->next_seed());
+   if (layout!=LayoutNCHW) rnet->setLayout(layout);
 
    rnet->plot("rmodel.pdf","LR");
    rnet->name="rnet";
@@ -19,6 +19,33 @@ using namespace std;
 Optimizer::Optimizer() {
   isshared=false;
   clip_val=-1;
+  flat_params=nullptr;
+  flat_grads=nullptr;
+}
+
+Optimizer::~Optimizer() {
+  delete flat_params;
+  delete flat_grads;
+}
+
+void Optimizer::set_flat(Tensor *params, Tensor *grads)
+{
+  flat_params=params;
+  flat_grads=grads;
+}
+
+bool Optimizer::use_flat()
+{
+  if (flat_params==nullptr) return false;
+
+  for (int i = 0; i < layers.size(); i++) {
+    if ((!layers[i]->trainable) && (layers[i]->get_trainable_params_count()>0)) return false;
+    // Row-sparse gradients are stepped row by row
+    for (int j = 0; j < layers[i]->get_trainable_params_count(); j++)
+      if (layers[i]->grad_rows(j)!=nullptr) return false;
+  }
+
+  return true;
 }
 
 void Optimizer::set_clip_val(float v)
@@ -30,8 +57,25 @@ void Optimizer::clip()
 {
   if (clip_val<0) return;
 
+  if (use_flat()) {
+    flat_grads->clamp_(-clip_val,clip_val);
+    return;
+  }
+
   for (int i = 0; i < layers.size(); i++)
-    for (int j = 0; j < layers[i]->get_trainable_params_count(); j++)
-      layers[i]->gradients[j]->clamp_(-clip_val,clip_val);
+    for (int j = 0; j < layers[i]->get_trainable_params_count(); j++) {
+      Tensor *g = layers[i]->gradients[j];
+      const vector<int> *rows = layers[i]->grad_rows(j);
+      if (rows==nullptr) {
+        g->clamp_(-clip_val,clip_val);
+        continue;
+      }
+
+      int w = g->size / g->shape[0];
+      for (int r : *rows) {
+        Tensor row(vector<int>{w}, g->ptr + (long int)r*w, g->device);
+        row.clamp_(-clip_val,clip_val);
+      }
+    }
 
 }
@@ -12,6 +12,7 @@
 #include <iostream>
 
 #include "eddl/optimizers/optim.h"
+#include "eddl/tensor/nn/tensor_nn.h"
 
 using namespace std;
 
@@ -20,8 +21,70 @@ Adagrad::Adagrad(float lr, float epsilon, float weight_decay) : Optimizer() {
     this->lr = lr;
     this->epsilon = epsilon;
     this->weight_decay = weight_decay;
+    mT_flat = nullptr;
 }
 
 Adagrad::~Adagrad() {
     for(int i=0; i<mT.size(); i++){ delete mT[i]; }
-}
\ No newline at end of file
+    delete mT_flat;
+}
+void Adagrad::change(vector<float> &p) {
+    if (p.size()>0) lr = p[0];
+    cout<<"Optimizer Adagrad set new lr="<<lr<<"\n";
+}
+
+Optimizer *Adagrad::clone() {
+    Adagrad *n=new Adagrad(lr, epsilon, weight_decay);
+    n->clip_val=clip_val;
+
+    return n;
+}
+
+Optimizer *Adagrad::share() {
+    Adagrad *n=new Adagrad(lr, epsilon, weight_decay);
+    n->orig=this;
+    n->isshared=true;
+    n->clip_val=clip_val;
+    return n;
+}
+
+void Adagrad::setlayers(vlayer l) {
+    layers = l;
+
+    if (isshared) return;
+
+    // create accumulators of the squared gradients
+    for (int i = 0; i < layers.size(); i++)
+        for (int j = 0; j < layers[i]->get_trainable_params_count(); j++)
+            mT.push_back(Tensor::zeros_like(layers[i]->gradients[j]));
+}
+
+void Adagrad::set_flat(Tensor *params, Tensor *grads) {
+    Optimizer::set_flat(params, grads);
+    if ((isshared) || (mT.empty())) return;
+
+    mT_flat = Tensor::pack(mT);
+}
+
+void Adagrad::applygrads(int batch) {
+    if (isshared) {
+        orig->applygrads(batch);
+    }
+    else {
+        clip();
+        if (use_flat()) {
+            tensorNN::adagrad_step(flat_params, flat_grads, mT_flat, lr, epsilon, weight_decay);
+            return;
+        }
+
+        int p = 0;
+        for (int i = 0; i < layers.size(); i++) {
+            if (layers[i]->trainable) {
+                for (int j = 0; j < layers[i]->get_trainable_params_count(); j++, p++) {
+                    tensorNN::adagrad_step(layers[i]->params[j], layers[i]->gradients[j], mT[p], lr, epsilon, weight_decay);
+                }
+            }
+            else p+=layers[i]->get_trainable_params_count();
+        }
+    }
+}
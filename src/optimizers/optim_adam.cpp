@@ -12,6 +12,7 @@
 #include <iostream>
 
 #include "eddl/optimizers/optim.h"
+#include "eddl/tensor/nn/tensor_nn.h"
 
 using namespace std;
 
@@ -23,6 +24,9 @@ Adam::Adam(float lr, float beta_1, float beta_2, float epsilon, float weight_dec
     this->epsilon = epsilon;
     this->weight_decay = weight_decay;
     this->amsgrad = amsgrad;
+    this->decoupled = false;
+    mT_flat = nullptr;
+    vT_flat = nullptr;
 
     t=0;
 
@@ -31,8 +35,8 @@ Adam::Adam(float lr, float beta_1, float beta_2, float epsilon, float weight_dec
 Adam::~Adam() {
     for(int i=0; i<mT.size(); i++){ delete mT[i]; }
     for(int i=0; i<vT.size(); i++){ delete vT[i]; }
-    for(int i=0; i<mCap.size(); i++){ delete mCap[i]; }
-    for(int i=0; i<vCap.size(); i++){ delete vCap[i]; }
+    delete mT_flat;
+    delete vT_flat;
 }
 
 void Adam::change(vector<float> &p) {
@@ -42,12 +46,14 @@ void Adam::change(vector<float> &p) {
 
 Optimizer *Adam::clone() {
     Adam *n=new Adam(lr, beta_1, beta_2, epsilon, weight_decay, amsgrad);
+    n->decoupled=decoupled;
     n->clip_val=clip_val;
     
     return n;
 }
 Optimizer *Adam::share() {
     Adam *n=new Adam(lr, beta_1, beta_2, epsilon, weight_decay, amsgrad);
+    n->decoupled=decoupled;
     n->orig=this;
     n->isshared=true;
     n->clip_val=clip_val;
@@ -65,43 +71,64 @@ void Adam::setlayers(vlayer l) {
             mT.back()->fill_(0.0);
             vT.push_back(new Tensor(layers[i]->gradients[j]->getShape(), layers[i]->dev));
             vT.back()->fill_(0.0);
-            mCap.push_back(new Tensor(layers[i]->gradients[j]->getShape(), layers[i]->dev));
-            mCap.back()->fill_(0.0);
-            vCap.push_back(new Tensor(layers[i]->gradients[j]->getShape(), layers[i]->dev));
-            vCap.back()->fill_(0.0);
         }
 
 }
 
+void Adam::set_flat(Tensor *params, Tensor *grads) {
+    Optimizer::set_flat(params, grads);
+    if ((isshared) || (mT.empty())) return;
+
+    mT_flat = Tensor::pack(mT);
+    vT_flat = Tensor::pack(vT);
+}
+
 void Adam::applygrads(int batch) {
   if (isshared) {
     orig->applygrads(batch);
   }
   else {
     clip();
-    int p = 0;
     t++;
+    if (use_flat()) {
+        tensorNN::adam_step(flat_params, flat_grads, mT_flat, vT_flat, lr, beta_1, beta_2, epsilon, weight_decay, decoupled, t);
+        return;
+    }
+
+    int p = 0;
     for (int i = 0; i < layers.size(); i++)
       if (layers[i]->trainable) {
         for (int j = 0; j < layers[i]->get_trainable_params_count(); j++, p++) {
-            Tensor::add(beta_1,mT[p],(1-beta_1),layers[i]->gradients[j],mT[p],0);
-            layers[i]->gradients[j]->sqr_();
-            Tensor::add(beta_2,vT[p],(1-beta_2),layers[i]->gradients[j],vT[p],0);
-
-            Tensor::copy(mT[p],mCap[p]);
-            mCap[p]->div_(1-pow(beta_1,t));
-
-            Tensor::copy(vT[p],vCap[p]);
-            vCap[p]->div_(1-pow(beta_2,t));
-            vCap[p]->add_(epsilon);
-            vCap[p]->sqrt_();
-
-            Tensor::el_div(mCap[p],vCap[p],mCap[p],0);
-
-            Tensor::add(-lr, mCap[p],1.0,layers[i]->params[j], layers[i]->params[j], 0);
+            const vector<int> *rows = layers[i]->grad_rows(j);
+            if (rows != nullptr)
+                tensorNN::adam_step_rows(layers[i]->params[j], layers[i]->gradients[j], mT[p], vT[p], *rows,
+                                         lr, beta_1, beta_2, epsilon, weight_decay, decoupled, t);
+            else
+                tensorNN::adam_step(layers[i]->params[j], layers[i]->gradients[j], mT[p], vT[p],
+                                    lr, beta_1, beta_2, epsilon, weight_decay, decoupled, t);
         }
     }
     else p+=layers[i]->get_trainable_params_count();
   }
 
 }
+
+
+AdamW::AdamW(float lr, float beta_1, float beta_2, float epsilon, float weight_decay) : Adam(lr, beta_1, beta_2, epsilon, weight_decay, false) {
+    decoupled = true;
+}
+
+Optimizer *AdamW::clone() {
+    AdamW *n=new AdamW(lr, beta_1, beta_2, epsilon, weight_decay);
+    n->clip_val=clip_val;
+
+    return n;
+}
+
+Optimizer *AdamW::share() {
+    AdamW *n=new AdamW(lr, beta_1, beta_2, epsilon, weight_decay);
+    n->orig=this;
+    n->isshared=true;
+    n->clip_val=clip_val;
+    return n;
+}
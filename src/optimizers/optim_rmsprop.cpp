@@ -12,6 +12,7 @@
 #include <iostream>
 
 #include "eddl/optimizers/optim.h"
+#include "eddl/tensor/nn/tensor_nn.h"
 
 using namespace std;
 
@@ -21,12 +22,13 @@ RMSProp::RMSProp(float lr, float rho, float epsilon, float weight_decay) : Optim
     this->rho = rho;
     this->epsilon = epsilon;
     this->weight_decay = weight_decay;
+    gT_flat = nullptr;
 
 }
 
 RMSProp::~RMSProp() {
     for(int i=0; i<gT.size(); i++){ delete gT[i]; gT[i] = nullptr; }
-    for(int i=0; i<gT1.size(); i++){ delete gT1[i]; gT1[i] = nullptr;}
+    delete gT_flat;
 }
 
 void RMSProp::change(vector<float> &p) {
@@ -54,15 +56,21 @@ void RMSProp::setlayers(vlayer l) {
 
     if (isshared) return;
 
-    // create momemtum tensors
+    // create running averages of the squared gradients
     for (int i = 0; i < layers.size(); i++){
         for (int j = 0; j < layers[i]->get_trainable_params_count(); j++) {
-            gT1.emplace_back(Tensor::zeros_like(layers[i]->gradients[j]));
             gT.emplace_back(Tensor::zeros_like(layers[i]->gradients[j]));
         }
     }
 }
 
+void RMSProp::set_flat(Tensor *params, Tensor *grads) {
+    Optimizer::set_flat(params, grads);
+    if ((isshared) || (gT.empty())) return;
+
+    gT_flat = Tensor::pack(gT);
+}
+
 void RMSProp::applygrads(int batch) {
   if (isshared) {
     orig->applygrads(batch);
@@ -70,31 +78,16 @@ void RMSProp::applygrads(int batch) {
   else {
 
     clip();
+    if (use_flat()) {
+        tensorNN::rmsprop_step(flat_params, flat_grads, gT_flat, lr, rho, epsilon, weight_decay);
+        return;
+    }
 
     int p = 0;
     for (int i = 0; i < layers.size(); i++)
       if (layers[i]->trainable) {
         for (int j = 0; j < layers[i]->get_trainable_params_count(); j++, p++) {
-            Tensor::copy(layers[i]->gradients[j],gT[p]);
-            gT[p]->sqr_();
-            gT[p]->mult_(1.0f-rho);
-
-            gT1[p]->sqr_();
-            gT1[p]->mult_(rho);
-            Tensor::add(1.0,gT1[p],1.0,gT[p],gT[p],0);
-
-            gT[p]->add_(epsilon);
-            gT[p]->sqrt_();
-            Tensor::el_div(layers[i]->gradients[j],gT[p],gT[p],0);
-
-            Tensor::copy(layers[i]->gradients[j],gT1[p]);
-
-            Tensor::add(-lr, gT[p],1.0,layers[i]->params[j], layers[i]->params[j], 0);
-
-      			/*if (layers[i]->acc_gradients.size() > 0) {
-        				Tensor::add(-lr, gT[p],1.0,layers[i]->acc_gradients[j], layers[i]->acc_gradients[j], 0);
-      			}
-            */
+            tensorNN::rmsprop_step(layers[i]->params[j], layers[i]->gradients[j], gT[p], lr, rho, epsilon, weight_decay);
         }
     }
     else p+=layers[i]->get_trainable_params_count();
@@ -12,6 +12,7 @@
 #include <iostream>
 
 #include "eddl/optimizers/optim.h"
+#include "eddl/tensor/nn/tensor_nn.h"
 
 using namespace std;
 
@@ -21,11 +22,13 @@ SGD::SGD(float lr, float momentum, float weight_decay, bool nesterov) : Optimize
     this->mu = momentum;
     this->weight_decay = weight_decay;
     this->nesterov = nesterov;
+    mT_flat = nullptr;
 
 }
 
 SGD::~SGD() {
     for(int i=0; i<mT.size(); i++){ delete mT[i]; }
+    delete mT_flat;
 }
 
 void SGD::change(vector<float> &p) {
@@ -63,18 +66,33 @@ void SGD::setlayers(vlayer l) {
 
 }
 
+void SGD::set_flat(Tensor *params, Tensor *grads) {
+    Optimizer::set_flat(params, grads);
+    if ((isshared) || (mT.empty())) return;
+
+    mT_flat = Tensor::pack(mT);
+}
+
 void SGD::applygrads(int batch) {
     if (isshared) {
       orig->applygrads(batch);
     }
     else {
       clip();
+      if (use_flat()) {
+        tensorNN::sgd_step(flat_params, flat_grads, mT_flat, lr, mu, weight_decay, nesterov);
+        return;
+      }
+
       int p = 0;
       for (int i = 0; i < layers.size(); i++) {
         if (layers[i]->trainable) {
           for (int j = 0; j < layers[i]->get_trainable_params_count(); j++, p++) {
-            Tensor::add(lr , layers[i]->gradients[j], mu, mT[p], mT[p], 0);
-            Tensor::add(1.0, layers[i]->params[j], -1.0, mT[p], layers[i]->params[j], 0);
+            const vector<int> *rows = layers[i]->grad_rows(j);
+            if (rows != nullptr)
+              tensorNN::sgd_step_rows(layers[i]->params[j], layers[i]->gradients[j], mT[p], *rows, lr, mu, weight_decay, nesterov);
+            else
+              tensorNN::sgd_step(layers[i]->params[j], layers[i]->gradients[j], mT[p], lr, mu, weight_decay, nesterov);
           }
         }
         else p+=layers[i]->get_trainable_params_count();
@@ -66,3 +66,37 @@ float fast_randn(float mean, float sd, int seed) {
     if (posTable<0) posTable=-posTable;
     return (RTable[posTable] * sd) + mean;
 }
+
+
+PhiloxStream::PhiloxStream(uint64_t seed) : key(seed), counter(0) {}
+
+void PhiloxStream::seed(uint64_t seed) {
+    key = seed;
+    counter = 0;
+}
+
+uint64_t PhiloxStream::take(uint64_t n) {
+    return counter.fetch_add(n);
+}
+
+uint64_t PhiloxStream::next_seed() {
+    uint32_t r[4];
+    philox4x32(key, take(1), r);
+    return ((uint64_t)r[0] << 32) | r[1];
+}
+
+static PhiloxStream default_stream(((uint64_t)rd() << 32) | rd());
+static thread_local PhiloxStream *active_stream = nullptr;
+
+PhiloxStream &random_stream() {
+    return (active_stream != nullptr) ? *active_stream : default_stream;
+}
+
+void set_random_stream(PhiloxStream *s) {
+    active_stream = s;
+}
+
+void set_random_seed(uint64_t seed) {
+    default_stream.seed(seed);
+    gen.seed((std::mt19937::result_type)seed);
+}
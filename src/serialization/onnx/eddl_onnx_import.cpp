@@ -725,6 +725,7 @@ using namespace std;
 				case ONNX_LAYERS::CONV:
 					{
 						int filters;
+						int groups = 1;
 						vector<int> kernel_shape;
 						vector<int> strides;
 						vector<int> pads;
@@ -751,8 +752,8 @@ using namespace std;
 							else if (!attr_name.compare("dilations")) { //It isn't implemented in eddl
 
 							}
-							else if (!attr_name.compare("group")) { //We don't know if this exists in eddl
-
+							else if (!attr_name.compare("group")) {
+								groups = attribute.i();
 							}
 							else if (!attr_name.compare("kernel_shape")) { //
 								for( int h = 0; h<attribute.ints_size(); h++){
@@ -812,9 +813,9 @@ using namespace std;
 						ConvolDescriptor* convol_descriptor;
 						if(!auto_pad){
 							kernel_shape.insert(kernel_shape.begin(), filters); //Add number of filters to kernel shape
-							convol_descriptor = new ConvolDescriptor(kernel_shape, strides, pads);
+							convol_descriptor = new ConvolDescriptor(kernel_shape, strides, pads, mem, groups);
 						}
-						else convol_descriptor = new ConvolDescriptor(filters, kernel_shape, strides, auto_pad_option, node->input_size() > 2, mem);
+						else convol_descriptor = new ConvolDescriptor(filters, kernel_shape, strides, auto_pad_option, node->input_size() > 2, mem, groups);
 
 						if(conv1d) actual_layer = new LConv1D(parent, convol_descriptor, name, dev, mem);
                         else actual_layer = new LConv(parent, convol_descriptor, name, dev, mem);
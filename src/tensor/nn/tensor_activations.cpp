@@ -678,6 +678,19 @@ namespace tensorNN {
     }
 
 
+    void D_Activation_(Tensor *D, Tensor *O, int act, float param) {
+        if (!Tensor::sameDevice(D, O)) msg("Tensors in different devices", "Tensor::D_Activation_");
+        if (!Tensor::sameShape(D, O)) msg("Incompatible dims", "Tensor::D_Activation_");
+
+        if (D->isCPU()) {
+            cpu_d_activation_inplace(D, O, act, param);
+        }
+        else {
+            msg("Only implemented for CPU tensors", "Tensor::D_Activation_");
+        }
+    }
+
+
 // SOFTMAX
     void Softmax(Tensor *A, Tensor *B) {
         if (A->device != B->device) msg("Tensors in different devices", "Tensor::Softmax");
@@ -771,6 +784,18 @@ namespace tensorNN {
 
     }
 
+    void SoftmaxLSE(Tensor *A, Tensor *B, Tensor *LSE) {
+        if (!Tensor::sameDevice(A, B) || !Tensor::sameDevice(A, LSE)) msg("Tensors in different devices", "Tensor::SoftmaxLSE");
+        if (!Tensor::sameShape(A, B) || (LSE->size * A->shape[A->ndim-1] != A->size)) msg("Incompatible dims", "Tensor::SoftmaxLSE");
+
+        if (A->isCPU()) {
+            cpu_softmax_lse(A, B, LSE);
+        }
+        else {
+            msg("Only implemented for CPU tensors", "Tensor::SoftmaxLSE");
+        }
+    }
+
     // FULL SOFTMAX DERIVATIVE
     void D_FullSoftmax(Tensor *D, Tensor *I, Tensor *PD, int axis) {
         if (!Tensor::sameDevice(D, I) || !Tensor::sameDevice(D, PD))
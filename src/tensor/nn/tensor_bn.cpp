@@ -114,4 +114,53 @@ namespace tensorNN {
         PROFILING_FOOTER(permute_batch_last);
     }
 
-}
\ No newline at end of file
+
+    void BatchNormForward(Tensor *X, Tensor *Y, Tensor *opa, Tensor *mean, Tensor *variance, Tensor *bn_g, Tensor *bn_b,
+                          Tensor *bn_mean, Tensor *bn_var, bool trmode, float epsilon, float momentum, bool channels_last) {
+        if (!Tensor::sameShape(X, Y) || (X->size != opa->size)) msg("Incompatible dims", "Tensor::BatchNormForward");
+
+        if (X->isCPU()) {
+            cpu_batchnorm_forward(X, Y, opa, mean, variance, bn_g, bn_b, bn_mean, bn_var, trmode, epsilon, momentum, channels_last);
+        }
+        else {
+            msg("Only implemented for CPU tensors", "Tensor::BatchNormForward");
+        }
+    }
+
+    void BatchNormBackward(Tensor *D, Tensor *opa, Tensor *PD, Tensor *bn_g, Tensor *bn_var, Tensor *gbn_g, Tensor *gbn_b, bool channels_last) {
+        if (!Tensor::sameShape(D, PD) || (D->size != opa->size)) msg("Incompatible dims", "Tensor::BatchNormBackward");
+
+        if (D->isCPU()) {
+            cpu_batchnorm_backward(D, opa, PD, bn_g, bn_var, gbn_g, gbn_b, channels_last);
+        }
+        else {
+            msg("Only implemented for CPU tensors", "Tensor::BatchNormBackward");
+        }
+    }
+
+    void LayerNormForward(Tensor *X, Tensor *Y, Tensor *opa, Tensor *mean, Tensor *sd, Tensor *g, Tensor *b, float epsilon) {
+        if (!Tensor::sameShape(X, Y) || (X->size != opa->size) || (X->size % mean->size) || (mean->size != sd->size))
+            msg("Incompatible dims", "Tensor::LayerNormForward");
+        if ((g != nullptr) && ((X->size / mean->size) % g->size)) msg("Incompatible dims", "Tensor::LayerNormForward");
+
+        if (X->isCPU()) {
+            cpu_layernorm_forward(X, Y, opa, mean, sd, g, b, epsilon);
+        }
+        else {
+            msg("Only implemented for CPU tensors", "Tensor::LayerNormForward");
+        }
+    }
+
+    void LayerNormBackward(Tensor *D, Tensor *opa, Tensor *PD, Tensor *sd, Tensor *g, Tensor *gg, Tensor *gb) {
+        if (!Tensor::sameShape(D, PD) || (D->size != opa->size) || (D->size % sd->size))
+            msg("Incompatible dims", "Tensor::LayerNormBackward");
+
+        if (D->isCPU()) {
+            cpu_layernorm_backward(D, opa, PD, sd, g, gg, gb);
+        }
+        else {
+            msg("Only implemented for CPU tensors", "Tensor::LayerNormBackward");
+        }
+    }
+
+}
@@ -121,4 +121,20 @@ void Conv2D_back(ConvolDescriptor *D) {
     PROFILING_FOOTER(Conv2D_back);
 }
 
+void Conv2D_act_back(ConvolDescriptor *D) {
+    /////////////////////////////////////////////////////////////////////
+    //// Conv2D Act Back
+    //// Delta of the fused activation: D = D * f'(O)
+    //// D is a ConvolDescriptor
+    /////////////////////////////////////////////////////////////////////
+    if (D->act == ConvActNone) return;
+
+    if (D->I->isCPU()) {
+        cpu_conv2D_act_back(D);
+    }
+    else {
+        msg("Fused activations are only available on CPU", "Tensor::Conv2D_act_back");
+    }
+}
+
 }
@@ -103,6 +103,32 @@ namespace tensorNN {
 #endif
     }
 
+    float softmax_cross_entropy(Tensor* y_true, Tensor* X, Tensor* LSE){
+        if (!Tensor::sameDevice(y_true, X) || !Tensor::sameDevice(y_true, LSE)) {
+            msg("Tensors in different devices", "TensorNN::softmax_cross_entropy");
+        }
+        if (!Tensor::sameShape(y_true, X) || (LSE->size * X->shape[X->ndim-1] != X->size)) {
+            msg("Incompatible dims", "TensorNN::softmax_cross_entropy");
+        }
+
+        if (y_true->isCPU()) {
+            return cpu_softmax_cross_entropy(y_true, X, LSE);
+        }
+        msg("Only implemented for CPU tensors", "TensorNN::softmax_cross_entropy");
+        return 0.0f;
+    }
+
+    void d_softmax_cross_entropy(Tensor* y_true, Tensor* y_pred, Tensor* delta){
+        if (!Tensor::sameDevice(y_true, y_pred) || !Tensor::sameDevice(y_true, delta)) {
+            msg("Tensors in different devices", "TensorNN::d_softmax_cross_entropy");
+        }
+        if (!Tensor::sameShape(y_true, y_pred) || !Tensor::sameShape(y_true, delta)) {
+            msg("Incompatible dims", "TensorNN::d_softmax_cross_entropy");
+        }
+
+        Tensor::add(-1.0f, y_true, 1.0f, y_pred, delta, 0);
+    }
+
     float binary_cross_entropy(Tensor* y_true, Tensor* y_pred){
         if (!Tensor::sameDevice(y_true, y_pred)) {
             msg("Tensors in different devices", "TensorNN::binary_cross_entropy");
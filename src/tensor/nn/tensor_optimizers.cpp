@@ -0,0 +1,102 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cmath>
+
+#include "eddl/tensor/nn/tensor_nn.h"
+#include "eddl/tensor/tensor_expr.h"
+#include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
+
+using namespace expr;
+
+// CPU tensors run the single pass kernels. Other devices evaluate the same update as
+// expressions, one per state tensor.
+
+namespace tensorNN {
+
+    void sgd_step(Tensor *P, Tensor *G, Tensor *M, float lr, float mu, float weight_decay, bool nesterov) {
+        expr::check(P, {G, M}, "tensorNN::sgd_step");
+
+        if (P->isCPU()) {
+            cpu_sgd_step(P, G, M, lr, mu, weight_decay, nesterov);
+            return;
+        }
+
+        auto g = var(G) + weight_decay * var(P);
+        eval(M, mu * var(M) + lr * g);
+        if (nesterov) eval(P, var(P) - (mu * var(M) + lr * g));
+        else eval(P, var(P) - var(M));
+    }
+
+    void adam_step(Tensor *P, Tensor *G, Tensor *M, Tensor *V, float lr, float beta_1, float beta_2, float epsilon, float weight_decay, bool decoupled, int t) {
+        expr::check(P, {G, M, V}, "tensorNN::adam_step");
+
+        if (P->isCPU()) {
+            cpu_adam_step(P, G, M, V, lr, beta_1, beta_2, epsilon, weight_decay, decoupled, t);
+            return;
+        }
+
+        float step = lr / (1.0f - std::pow(beta_1, (float)t));
+        float ic2 = 1.0f / (1.0f - std::pow(beta_2, (float)t));
+        float l2 = decoupled ? 0.0f : weight_decay;
+        float keep = decoupled ? 1.0f - lr * weight_decay : 1.0f;
+
+        auto g = var(G) + l2 * var(P);
+        eval(M, beta_1 * var(M) + (1.0f - beta_1) * g);
+        eval(V, beta_2 * var(V) + (1.0f - beta_2) * sqr(g));
+        eval(P, keep * var(P) - step * var(M) / sqrt(var(V) * ic2 + epsilon));
+    }
+
+    void rmsprop_step(Tensor *P, Tensor *G, Tensor *V, float lr, float rho, float epsilon, float weight_decay) {
+        expr::check(P, {G, V}, "tensorNN::rmsprop_step");
+
+        if (P->isCPU()) {
+            cpu_rmsprop_step(P, G, V, lr, rho, epsilon, weight_decay);
+            return;
+        }
+
+        auto g = var(G) + weight_decay * var(P);
+        eval(V, rho * var(V) + (1.0f - rho) * sqr(g));
+        eval(P, var(P) - lr * g / sqrt(var(V) + epsilon));
+    }
+
+    void adagrad_step(Tensor *P, Tensor *G, Tensor *V, float lr, float epsilon, float weight_decay) {
+        expr::check(P, {G, V}, "tensorNN::adagrad_step");
+
+        if (P->isCPU()) {
+            cpu_adagrad_step(P, G, V, lr, epsilon, weight_decay);
+            return;
+        }
+
+        auto g = var(G) + weight_decay * var(P);
+        eval(V, var(V) + sqr(g));
+        eval(P, var(P) - lr * g / sqrt(var(V) + epsilon));
+    }
+
+    void sgd_step_rows(Tensor *P, Tensor *G, Tensor *M, const vector<int> &rows, float lr, float mu, float weight_decay, bool nesterov) {
+        expr::check(P, {G, M}, "tensorNN::sgd_step_rows");
+
+        if (P->isCPU()) {
+            cpu_sgd_step_rows(P, G, M, rows, lr, mu, weight_decay, nesterov);
+            return;
+        }
+        msg("Only implemented for CPU tensors", "tensorNN::sgd_step_rows");
+    }
+
+    void adam_step_rows(Tensor *P, Tensor *G, Tensor *M, Tensor *V, const vector<int> &rows, float lr, float beta_1, float beta_2, float epsilon, float weight_decay, bool decoupled, int t) {
+        expr::check(P, {G, M, V}, "tensorNN::adam_step_rows");
+
+        if (P->isCPU()) {
+            cpu_adam_step_rows(P, G, M, V, rows, lr, beta_1, beta_2, epsilon, weight_decay, decoupled, t);
+            return;
+        }
+        msg("Only implemented for CPU tensors", "tensorNN::adam_step_rows");
+    }
+
+}
@@ -0,0 +1,40 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include "eddl/tensor/nn/tensor_nn.h"
+#include "eddl/hardware/cpu/nn/cpu_tensor_nn.h"
+
+
+namespace tensorNN {
+
+    void LSTMForward(Tensor *X, Tensor *G, Tensor *bias, Tensor *cprev, Tensor *hprev, Tensor *mask, Tensor *C, Tensor *H, Tensor *TC) {
+        if ((G->ndim != 2) || (G->shape[1] != 4*C->shape[1]) || (bias->size != G->shape[1])) msg("Incompatible dims", "Tensor::LSTMForward");
+        if (!Tensor::sameShape(C, H) || !Tensor::sameShape(C, TC) || (G->shape[0] != C->shape[0])) msg("Incompatible dims", "Tensor::LSTMForward");
+
+        if (G->isCPU()) {
+            cpu_lstm_forward(X, G, bias, cprev, hprev, mask, C, H, TC);
+        }
+        else {
+            msg("Only implemented for CPU tensors", "Tensor::LSTMForward");
+        }
+    }
+
+    void LSTMBackward(Tensor *G, Tensor *TC, Tensor *cprev, Tensor *mask, Tensor *DH, Tensor *DC, Tensor *DHprev, Tensor *DCprev) {
+        if ((G->ndim != 2) || (G->shape[1] != 4*TC->shape[1]) || (G->shape[0] != TC->shape[0])) msg("Incompatible dims", "Tensor::LSTMBackward");
+        if (!Tensor::sameShape(TC, DH) || !Tensor::sameShape(TC, DC)) msg("Incompatible dims", "Tensor::LSTMBackward");
+
+        if (G->isCPU()) {
+            cpu_lstm_backward(G, TC, cprev, mask, DH, DC, DHprev, DCprev);
+        }
+        else {
+            msg("Only implemented for CPU tensors", "Tensor::LSTMBackward");
+        }
+    }
+
+}
@@ -149,11 +149,11 @@ void Tensor::deleteData(){
             // Delete eigen matrix
             if (this->ndim == 2){
                 delete this->ptr2; //double free or corruption (out)
-                delete[] this->ptr;
+                free_fmem(this->ptr);
                 this->ptr2 = nullptr;
                 this->ptr = nullptr;  // Redundant
             }else{
-                delete[] this->ptr;
+                free_fmem(this->ptr);
                 this->ptr = nullptr;  // Redundant
             }
 
@@ -343,7 +343,7 @@ void Tensor::toGPU(int dev){
 
         this->ptr = gpu_ptr;
         gpu_copy_to_gpu(cpu_ptr, this);
-        delete []cpu_ptr;
+        free_fmem(cpu_ptr);
     }
     else if (this->isGPU())
     {
@@ -660,6 +660,18 @@ Tensor* Tensor::select(const vector<string>& indices){
     return t;
 }
 
+Tensor* Tensor::slice(const vector<string>& indices){
+    if (this->isFPGA()) msg("Views are not supported on FPGA", "Tensor::slice");
+
+    SelDescriptor sd(indices, this->device);
+    sd.build_layout(this->shape);
+    if (!sd.is_view()) {
+        msg("The selection is not a contiguous block of memory. Use select() to copy it", "Tensor::slice");
+    }
+
+    return new Tensor(sd.oshape, this->ptr + sd.offset, this->device);
+}
+
 void Tensor::select(Tensor *A, Tensor* B, SelDescriptor *sd){
     if (A->isCPU() && B->isCPU()) {
         cpu_select(A, B, sd);
@@ -63,6 +63,34 @@ Tensor* Tensor::zeros_like(Tensor *A){
     return Tensor::zeros(A->shape, A->device);
 }
 
+Tensor* Tensor::pack(const vector<Tensor*> &tensors){
+    if (tensors.empty()) msg("No tensors to pack", "Tensor::pack");
+
+    int dev = tensors[0]->device;
+    if (tensors[0]->isFPGA()) msg("Packing is not available for FPGA tensors", "Tensor::pack");
+
+    // Every tensor starts at a multiple of 16 floats
+    vector<unsigned long int> offsets;
+    unsigned long int size = 0;
+    for (auto *t : tensors) {
+        if (t->device != dev) msg("Tensors in different devices", "Tensor::pack");
+        offsets.push_back(size);
+        size += (t->size + 15) / 16 * 16;
+    }
+
+    auto A = Tensor::zeros({(int)size}, dev);
+    for (int i = 0; i < tensors.size(); i++) {
+        Tensor *t = tensors[i];
+        auto view = new Tensor({(int)t->size}, A->ptr + offsets[i], dev);
+        Tensor::copy(t, view);
+        delete view;
+
+        t->deleteData();
+        t->updateData(A->ptr + offsets[i]);
+    }
+    return A;
+}
+
 Tensor* Tensor::ones(const vector<int> &shape, int dev){
     auto t = new Tensor(shape, dev);
     t->fill_(1.0f);
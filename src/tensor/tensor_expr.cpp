@@ -0,0 +1,54 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.8
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: November 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include "eddl/tensor/tensor_expr.h"
+
+using namespace std;
+
+
+namespace expr {
+
+    void check(Tensor *C, const vector<Tensor*> &leaves, const string &caller) {
+        for (auto *t : leaves) {
+            if (t->size != C->size)
+                msg("Tensors with different size (" + to_string(t->size) + " vs " + to_string(C->size) + ")", caller);
+            if (t->device != C->device)
+                msg("Tensors in different devices", caller);
+        }
+    }
+
+    // Fallback of the devices without a fused loop: one Tensor op per node
+    void apply_unary(int op, Tensor *A) {
+        switch (op) {
+            case EXPR_NEG: Tensor::neg(A, A); break;
+            case EXPR_ABS: Tensor::abs(A, A); break;
+            case EXPR_SQR: Tensor::sqr(A, A); break;
+            case EXPR_SQRT: Tensor::sqrt(A, A); break;
+            case EXPR_RSQRT: Tensor::rsqrt(A, A); break;
+            case EXPR_EXP: Tensor::exp(A, A); break;
+            case EXPR_LOG: Tensor::log(A, A); break;
+            case EXPR_TANH: Tensor::tanh(A, A); break;
+            case EXPR_SIGMOID: Tensor::sigmoid(A, A); break;
+            default: msg("Unknown unary op " + to_string(op), "expr::apply_unary");
+        }
+    }
+
+    void apply_binary(int op, Tensor *A, Tensor *B) {
+        switch (op) {
+            case EXPR_ADD: Tensor::add(1.0f, A, 1.0f, B, A, 0); break;
+            case EXPR_SUB: Tensor::add(1.0f, A, -1.0f, B, A, 0); break;
+            case EXPR_MULT: Tensor::el_mult(A, B, A, 0); break;
+            case EXPR_DIV: Tensor::el_div(A, B, A, 0); break;
+            case EXPR_MAX: Tensor::maximum(A, B, A); break;
+            case EXPR_MIN: Tensor::minimum(A, B, A); break;
+            default: msg("Unknown binary op " + to_string(op), "expr::apply_binary");
+        }
+    }
+
+}
@@ -31,6 +31,7 @@
 
 #include "eddl/system_info.h"
 #include "eddl/utils.h"
+#include "eddl/mempool.h"
 #include "eddl/profiling.h"
 
 #ifdef EDDL_LINUX
@@ -67,46 +68,23 @@ void msg(const string& text, const string& title) {
 }
 
 
+// CPU memory comes from the caching pool (see mempool.h): 64-byte aligned, and reused without
+// going to the system in the hot loops. A budget (mempool_set_budget) replaces the old check
+// of the free system memory on every call
 float *get_fmem(unsigned long int size, const string &str){
-    // Careful with memory overcommitment:
-    // https://stackoverflow.com/questions/48585079/malloc-on-linux-without-overcommitting
-    // TODO: This function does not work properly (...but it does, at least most of the time -for linux and mac-)
-    float* ptr = nullptr;
-    bool error = false;
+    auto *ptr = (float *)mempool_alloc(size * sizeof(float));
 
-
-    // Check if free memory is bigger than requested
-    unsigned long freemem = get_free_mem();
-    if (size*sizeof(float) > freemem) {
-        error=true;
-    }
-
-    // New vs Malloc *******************
-    // New is the C++ way of doing it
-    // New is type-safe, Malloc is not
-    // New calls your type constructor, Malloc not - Same for destructor
-    // New is an operator, Malloc a function (slower)
-    try{
-        ptr = new float[size];
-        //ptr=(float *)malloc(size*sizeof(float));
-        //ptr=(float *)aligned_alloc(64, size*sizeof(float));
-        //posix_memalign((void **)&ptr, 64, size*sizeof(float));
-
-    }
-    catch (std::bad_alloc& badAlloc){
-        error=true;
-    }
-
-    // Check for errors
-    // Not enough free memory
-    if (error) {
-        delete[] ptr;
+    if (ptr == nullptr) {
         throw std::runtime_error("Error allocating " + string(bytes2human(size * sizeof(float))) + " in " + string(str));
     }
 
     return ptr;
 }
 
+void free_fmem(float *ptr){
+    mempool_free(ptr);
+}
+
 
 string bytes2human(unsigned long long int bytes, int decimals){
     vector<string> prefix = {"B", "KB", "MB", "GB", "TB", "PB", "EB", "ZB", "YB"};
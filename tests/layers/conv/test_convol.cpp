@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <string>
 
+#include "eddl/tensor/tensor.h"
+#include "eddl/tensor/nn/tensor_nn.h"
 #include "eddl/descriptors/descriptors.h"
 
 
@@ -43,3 +45,251 @@ TEST(Convol2DTestSuite, output_size)
         }
     }
 }
+
+
+TEST(Convol2DTestSuite, conv2d_winograd_equivalent_im2col)
+{
+    // Sizes below and above the F(4x4,3x3) threshold
+    vector<string> padding = {"valid", "same"};
+    vector<int> input_sizes = {7, 19};
+
+    for(auto& p : padding){
+        for(auto& is : input_sizes){
+            Tensor* t_input = Tensor::randn({2, 8, is, is});
+
+            // Reference (im2col)
+            auto *cd_ref = new ConvolDescriptor(12, {3, 3}, {1, 1}, p, true);
+            cd_ref->set_algorithm(ConvAlgoIm2col);
+            cd_ref->build(t_input);
+            cd_ref->K->fill_rand_normal_(0.0f, 1.0f);
+            cd_ref->bias->fill_rand_normal_(0.0f, 1.0f);
+            cd_ref->ID = Tensor::zeros(cd_ref->I->getShape());
+            cd_ref->D = Tensor::randn(cd_ref->O->getShape());
+            cd_ref->gK->fill_(0.0f);
+            cd_ref->gbias->fill_(0.0f);
+
+            // Winograd
+            auto *cd_wino = new ConvolDescriptor(12, {3, 3}, {1, 1}, p, true);
+            cd_wino->set_algorithm(ConvAlgoWinograd);
+            cd_wino->build(t_input);
+            ASSERT_EQ(cd_wino->algo, ConvAlgoWinograd);
+            Tensor::copy(cd_ref->K, cd_wino->K);
+            Tensor::copy(cd_ref->bias, cd_wino->bias);
+            cd_wino->ID = Tensor::zeros(cd_wino->I->getShape());
+            cd_wino->D = cd_ref->D->clone();
+            cd_wino->gK->fill_(0.0f);
+            cd_wino->gbias->fill_(0.0f);
+
+            // Forward
+            tensorNN::Conv2D(cd_ref);
+            tensorNN::Conv2D(cd_wino);
+            ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->O, cd_wino->O, 1e-3f, 1e-3f));
+
+            // Backward
+            tensorNN::Conv2D_grad(cd_ref);
+            tensorNN::Conv2D_grad(cd_wino);
+            ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->gK, cd_wino->gK, 1e-3f, 1e-3f));
+
+            tensorNN::Conv2D_back(cd_ref);
+            tensorNN::Conv2D_back(cd_wino);
+            ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->ID, cd_wino->ID, 1e-3f, 1e-3f));
+        }
+    }
+}
+
+
+TEST(Convol2DTestSuite, conv2d_workspace_equivalent_full_lowering)
+{
+    // Enough rows and channels to split every sample into several workspace tiles
+    Tensor* t_input = Tensor::randn({3, 64, 30, 30});
+
+    // Reference (full_mem, whole batch lowering)
+    auto *cd_ref = new ConvolDescriptor(4, {5, 5}, {1, 1}, "same", true);
+    cd_ref->set_algorithm(ConvAlgoIm2col);
+    cd_ref->build(t_input);
+    cd_ref->K->fill_rand_normal_(0.0f, 1.0f);
+    cd_ref->bias->fill_rand_normal_(0.0f, 1.0f);
+    cd_ref->ID = Tensor::zeros(cd_ref->I->getShape());
+    cd_ref->D = Tensor::randn(cd_ref->O->getShape());
+    cd_ref->gK->fill_(0.0f);
+    cd_ref->gbias->fill_(0.0f);
+
+    // Tiled workspace (mid_mem)
+    auto *cd_ws = new ConvolDescriptor(4, {5, 5}, {1, 1}, "same", true, 1);
+    cd_ws->set_algorithm(ConvAlgoIm2col);
+    cd_ws->build(t_input);
+    ASSERT_GT(cd_ws->ws_threads, 0);
+    ASSERT_LT(cd_ws->ws_rows, cd_ws->r * cd_ws->c);
+    Tensor::copy(cd_ref->K, cd_ws->K);
+    Tensor::copy(cd_ref->bias, cd_ws->bias);
+    cd_ws->ID = Tensor::zeros(cd_ws->I->getShape());
+    cd_ws->D = cd_ref->D->clone();
+    cd_ws->gK->fill_(0.0f);
+    cd_ws->gbias->fill_(0.0f);
+
+    tensorNN::Conv2D(cd_ref);
+    tensorNN::Conv2D(cd_ws);
+    ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->O, cd_ws->O, 1e-3f, 1e-3f));
+
+    tensorNN::Conv2D_grad(cd_ref);
+    tensorNN::Conv2D_grad(cd_ws);
+    ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->gK, cd_ws->gK, 1e-3f, 1e-3f));
+
+    // The per-thread partial gradients are reduced in a fixed order
+    Tensor *gK_first = cd_ws->gK->clone();
+    cd_ws->gK->fill_(0.0f);
+    tensorNN::Conv2D_grad(cd_ws);
+    ASSERT_TRUE((bool) Tensor::equivalent(gK_first, cd_ws->gK, 0.0f, 0.0f));
+
+    tensorNN::Conv2D_back(cd_ref);
+    tensorNN::Conv2D_back(cd_ws);
+    ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->ID, cd_ws->ID, 1e-3f, 1e-3f));
+}
+
+
+TEST(Convol2DTestSuite, conv2d_fused_activation_equivalent)
+{
+    vector<string> acts = {"relu", "leaky_relu", "sigmoid", "tanh"};
+    vector<int> mems = {0, 1};
+    // {algorithm, filters, groups, layout}: every algorithm applies the epilogue in its own kernel
+    vector<vector<int>> algos = {
+            {ConvAlgoIm2col, 6, 1, LayoutNCHW},
+            {ConvAlgoWinograd, 6, 1, LayoutNCHW},
+            {ConvAlgoDepthwise, 8, 4, LayoutNCHW},
+            {ConvAlgoDepthwise, 8, 4, LayoutNHWC},
+    };
+    Tensor* t_input = Tensor::randn({2, 4, 9, 9});
+
+    for(auto& algo : algos){
+        for(auto& act : acts){
+            for(auto& mem : mems){
+                // Reference: convolution followed by the activation
+                auto *cd_ref = new ConvolDescriptor(algo[1], {3, 3}, {1, 1}, "same", true, mem, algo[2]);
+                cd_ref->set_algorithm(algo[0]);
+                cd_ref->build(t_input);
+                cd_ref->set_layout(algo[3], algo[3]);
+                ASSERT_EQ(cd_ref->algo, algo[0]);
+                cd_ref->K->fill_rand_normal_(0.0f, 1.0f);
+                cd_ref->bias->fill_rand_normal_(0.0f, 1.0f);
+                cd_ref->ID = Tensor::zeros(cd_ref->I->getShape());
+                cd_ref->gK->fill_(0.0f);
+                cd_ref->gbias->fill_(0.0f);
+
+                // Fused
+                auto *cd_fused = new ConvolDescriptor(algo[1], {3, 3}, {1, 1}, "same", true, mem, algo[2]);
+                cd_fused->set_algorithm(algo[0]);
+                cd_fused->build(t_input);
+                cd_fused->set_layout(algo[3], algo[3]);
+                cd_fused->act = getConvActivation(act);
+                cd_fused->act_param = 0.1f;
+                Tensor::copy(cd_ref->K, cd_fused->K);
+                Tensor::copy(cd_ref->bias, cd_fused->bias);
+                cd_fused->ID = Tensor::zeros(cd_fused->I->getShape());
+                cd_fused->gK->fill_(0.0f);
+                cd_fused->gbias->fill_(0.0f);
+
+                // Forward
+                Tensor *y = Tensor::zeros(cd_ref->O->getShape());
+                tensorNN::Conv2D(cd_ref);
+                if (act == "relu") tensorNN::ReLu(cd_ref->O, y);
+                else if (act == "leaky_relu") tensorNN::LeakyReLu(cd_ref->O, y, 0.1f);
+                else if (act == "sigmoid") tensorNN::Sigmoid(cd_ref->O, y);
+                else tensorNN::Tanh(cd_ref->O, y);
+
+                tensorNN::Conv2D(cd_fused);
+                ASSERT_TRUE((bool) Tensor::equivalent(y, cd_fused->O, 1e-4f, 1e-4f));
+
+                // Backward
+                Tensor *dy = Tensor::randn(y->getShape());
+                cd_ref->D = Tensor::zeros(y->getShape());
+                if (act == "relu") tensorNN::D_ReLu(dy, cd_ref->O, cd_ref->D);
+                else if (act == "leaky_relu") tensorNN::D_LeakyReLu(dy, cd_ref->O, cd_ref->D, 0.1f);
+                else if (act == "sigmoid") tensorNN::D_Sigmoid(dy, y, cd_ref->D);
+                else tensorNN::D_Tanh(dy, y, cd_ref->D);
+
+                cd_fused->D = dy->clone();
+                tensorNN::Conv2D_act_back(cd_fused);
+                ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->D, cd_fused->D, 1e-4f, 1e-4f));
+
+                tensorNN::Conv2D_grad(cd_ref);
+                tensorNN::Conv2D_grad(cd_fused);
+                ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->gK, cd_fused->gK, 1e-3f, 1e-3f));
+                ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->gbias, cd_fused->gbias, 1e-3f, 1e-3f));
+
+                tensorNN::Conv2D_back(cd_ref);
+                tensorNN::Conv2D_back(cd_fused);
+                ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->ID, cd_fused->ID, 1e-3f, 1e-3f));
+
+                delete y;
+                delete dy;
+            }
+        }
+    }
+}
+
+
+TEST(Convol2DTestSuite, conv2d_grouped_equivalent_dense)
+{
+    // {input channels, filters, groups, stride, algorithm}
+    vector<vector<int>> cases = {
+            {6, 6, 3, 1, ConvAlgoIm2col},
+            {4, 8, 4, 2, ConvAlgoAuto},  // depthwise, multiplier 2
+            {5, 5, 5, 1, ConvAlgoAuto},  // depthwise
+            {4, 4, 4, 1, ConvAlgoIm2col},
+    };
+    vector<vector<int>> layouts = {{LayoutNCHW, LayoutNCHW}, {LayoutNHWC, LayoutNHWC}, {LayoutNCHW, LayoutNHWC}};
+    vector<int> mems = {0, 1};
+
+    for(auto& cs : cases){
+        int iz = cs[0], nk = cs[1], groups = cs[2], st = cs[3];
+        int kz = iz / groups, gk = nk / groups;
+        Tensor* t_input = Tensor::randn({2, iz, 9, 9});
+
+        for(auto& l : layouts){
+            for(auto& mem : mems){
+                // Reference: dense convolution with block-diagonal kernels
+                auto *cd_ref = new ConvolDescriptor(nk, {3, 3}, {st, st}, "same", true, mem);
+                cd_ref->build(t_input);
+                cd_ref->set_layout(l[0], l[1]);
+                cd_ref->bias->fill_rand_normal_(0.0f, 1.0f);
+                cd_ref->ID = Tensor::zeros(cd_ref->I->getShape());
+                cd_ref->D = Tensor::randn(cd_ref->O->getShape());
+                cd_ref->gK->fill_(0.0f);
+                cd_ref->gbias->fill_(0.0f);
+
+                auto *cd_grp = new ConvolDescriptor(nk, {3, 3}, {st, st}, "same", true, mem, groups);
+                cd_grp->set_algorithm(cs[4]);
+                cd_grp->build(t_input);
+                cd_grp->set_layout(l[0], l[1]);
+                if (kz == 1 && cs[4] == ConvAlgoAuto) ASSERT_EQ(cd_grp->algo, ConvAlgoDepthwise);
+                cd_grp->K->fill_rand_normal_(0.0f, 1.0f);
+                Tensor::copy(cd_ref->bias, cd_grp->bias);
+                cd_grp->ID = Tensor::zeros(cd_grp->I->getShape());
+                cd_grp->D = cd_ref->D->clone();
+                cd_grp->gK->fill_(0.0f);
+                cd_grp->gbias->fill_(0.0f);
+
+                // Kernel "o" of the grouped convolution sees the channels [g*kz, (g+1)*kz)
+                cd_ref->K->fill_(0.0f);
+                for(int o=0; o<nk; o++)
+                    for(int i=0; i<kz*9; i++)
+                        cd_ref->K->ptr[(o*iz + (o/gk)*kz)*9 + i] = cd_grp->K->ptr[o*kz*9 + i];
+
+                tensorNN::Conv2D(cd_ref);
+                tensorNN::Conv2D(cd_grp);
+                ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->O, cd_grp->O, 1e-3f, 1e-3f));
+
+                tensorNN::Conv2D_grad(cd_ref);
+                tensorNN::Conv2D_grad(cd_grp);
+                for(int o=0; o<nk; o++)
+                    for(int i=0; i<kz*9; i++)
+                        ASSERT_NEAR(cd_ref->gK->ptr[(o*iz + (o/gk)*kz)*9 + i], cd_grp->gK->ptr[o*kz*9 + i], 1e-2f);
+                ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->gbias, cd_grp->gbias, 1e-3f, 1e-3f));
+
+                tensorNN::Conv2D_back(cd_ref);
+                tensorNN::Conv2D_back(cd_grp);
+                ASSERT_TRUE((bool) Tensor::equivalent(cd_ref->ID, cd_grp->ID, 1e-3f, 1e-3f));
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/layers/core/layer_core.h"
+
+#include "../../net/net_compare.h"
+
+
+using namespace eddl;
+
+
+static model embedding_net(bool sparse, optimizer opt, const string& mem){
+    layer in = Input({4});
+    layer l = Embedding(in, 50, 4, 3, false, "", sparse);
+    layer out = Dense(Flatten(Reshape(l, {4, 3})), 2);  // Views of the embeddings
+    model net = Model({in}, {out});
+
+    build(net, opt, {"mse"}, {"mse"}, CS_CPU(1, mem), true);
+    return net;
+}
+
+
+TEST(EmbeddingTestSuite, embedding_sparse_grad){
+    // Words 0..19 only, so rows 20..49 never get a gradient (a batch of 5 uses all of them)
+    batch_fn batches = [](int batch, Tensor *&x, Tensor *&y) {
+        x = new Tensor({batch, 4});
+        for(int i=0; i<x->size; i++) x->ptr[i] = (float)((i * 7) % 20);
+        y = Tensor::randn({batch, 2});
+    };
+
+    for(int o=0; o<4; o++) {
+        string mem = (o < 2) ? "full_mem" : "low_mem";
+        model net_ref = embedding_net(false, (o % 2 == 0) ? sgd(0.1f, 0.0f) : adam(0.01f), mem);
+        model net_sparse = embedding_net(true, (o % 2 == 0) ? sgd(0.1f, 0.0f) : adam(0.01f), mem);
+        set_parameters(net_sparse, get_parameters(net_ref, true));
+        Tensor *E0 = net_ref->layers[1]->params[0]->clone();
+
+        // Without momentum SGD matches the dense update; Adam only on its first step,
+        // as afterwards the dense moments keep moving the rows that got no gradient
+        if (o % 2 == 0) ASSERT_NO_FATAL_FAILURE(expect_same_training(net_ref, net_sparse, batches, {1, 6}));
+        else ASSERT_NO_FATAL_FAILURE(expect_same_training(net_ref, net_sparse, batches, {6}, 1));
+
+        auto *emb = (LEmbedding *)net_sparse->layers[1];
+        ASSERT_EQ(emb->grows.size(), 20);
+
+        Tensor *x, *y;
+        batches(6, x, y);
+        for(int i=0; i<5; i++) train_batch(net_sparse, {x}, {y});
+        Tensor *E = get_parameters(net_sparse, true)[1][0];
+        for(int k=20*3; k<E->size; k++) ASSERT_EQ(E->ptr[k], E0->ptr[k]);
+
+        zeroGrads(net_sparse);
+        ASSERT_EQ(emb->gE->sum_abs(), 0.0f);
+        ASSERT_TRUE(emb->grows.empty());
+
+        delete E0;
+        delete x;
+        delete y;
+        delete net_ref;
+        delete net_sparse;
+    }
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/tensor/nn/tensor_nn.h"
+
+
+// Checks the native BatchNorm against a straightforward double precision reference.
+// Memory is seen as {B,C,S} (S=H*W for channels-first 4D tensors, S=1 otherwise)
+static void check_batchnorm(const vector<int> &shape, bool channels_last, bool trmode){
+    int C = shape[1];
+    int S = (shape.size() == 4 && !channels_last) ? shape[2]*shape[3] : 1;
+
+    Tensor *x = Tensor::randn(shape);
+    x->add_(100.0f);  // Large offset: the statistics must not suffer from cancellation
+    int B = x->size / (C*S);
+    Tensor *y = Tensor::zeros(shape), *opa = Tensor::zeros(shape);
+    Tensor *mean = Tensor::randn({C}), *variance = Tensor::randu({C});
+    variance->add_(0.5f);
+    Tensor *g = Tensor::randn({C}), *b = Tensor::randn({C});
+    Tensor *bn_mean = Tensor::zeros({C}), *bn_var = Tensor::zeros({C});
+    Tensor *mean0 = mean->clone(), *variance0 = variance->clone();
+    float eps = 1e-5f, momentum = 0.9f;
+
+    tensorNN::BatchNormForward(x, y, opa, mean, variance, g, b, bn_mean, bn_var, trmode, eps, momentum, channels_last);
+
+    auto at = [&](int i, int c, int s) { return ((long int)i*C + c)*S + s; };
+    vector<double> m(C), sd(C);
+    long int N = (long int)B*S;
+    for(int c=0; c<C; c++) {
+        double sum = 0.0, sq = 0.0;
+        for(int i=0; i<B; i++) for(int s=0; s<S; s++) sum += x->ptr[at(i, c, s)];
+        double mu = sum / N;
+        for(int i=0; i<B; i++) for(int s=0; s<S; s++) sq += (x->ptr[at(i, c, s)] - mu) * (x->ptr[at(i, c, s)] - mu);
+        double var = sq / N;
+        if (trmode) {
+            ASSERT_NEAR(mean->ptr[c], momentum*mean0->ptr[c] + (1-momentum)*mu, 1e-3);
+            ASSERT_NEAR(variance->ptr[c], momentum*variance0->ptr[c] + (1-momentum)*var, 1e-3);
+            m[c] = mu; sd[c] = sqrt(var + eps);
+        } else {
+            m[c] = mean0->ptr[c]; sd[c] = sqrt(variance0->ptr[c] + eps);
+        }
+        ASSERT_NEAR(bn_var->ptr[c], sd[c], 1e-3);
+    }
+    for(int i=0; i<B; i++) for(int c=0; c<C; c++) for(int s=0; s<S; s++) {
+        double xh = (x->ptr[at(i, c, s)] - m[c]) / sd[c];
+        ASSERT_NEAR(opa->ptr[at(i, c, s)], xh, 1e-3);
+        ASSERT_NEAR(y->ptr[at(i, c, s)], g->ptr[c]*xh + b->ptr[c], 1e-3);
+    }
+
+    // Backward (accumulates into the parent delta and the gradients)
+    if (trmode) {
+        Tensor *dy = Tensor::randn(shape);
+        Tensor *pd = Tensor::ones(shape), *gg = Tensor::ones({C}), *gb = Tensor::ones({C});
+        tensorNN::BatchNormBackward(dy, opa, pd, g, bn_var, gg, gb, channels_last);
+        for(int c=0; c<C; c++) {
+            double sdy = 0.0, sdx = 0.0;
+            for(int i=0; i<B; i++) for(int s=0; s<S; s++) {
+                long int k = at(i, c, s);
+                sdy += dy->ptr[k];
+                sdx += dy->ptr[k] * (x->ptr[k] - m[c]) / sd[c];
+            }
+            ASSERT_NEAR(gg->ptr[c], 1.0 + sdx/N, 1e-3);
+            ASSERT_NEAR(gb->ptr[c], 1.0 + sdy/N, 1e-3);
+            for(int i=0; i<B; i++) for(int s=0; s<S; s++) {
+                long int k = at(i, c, s);
+                double xh = (x->ptr[k] - m[c]) / sd[c];
+                double dx = g->ptr[c] / sd[c] * (dy->ptr[k] - sdy/N - sdx/N*xh);
+                ASSERT_NEAR(pd->ptr[k], 1.0 + dx, 1e-3);
+            }
+        }
+        delete dy; delete pd; delete gg; delete gb;
+    }
+
+    delete x; delete y; delete opa; delete mean; delete variance; delete g; delete b;
+    delete bn_mean; delete bn_var; delete mean0; delete variance0;
+}
+
+
+TEST(BatchNormTestSuite, batchnorm_native_cpu){
+    for(int t=0; t<2; t++) {
+        check_batchnorm({37, 5}, false, t);
+        check_batchnorm({3, 4, 5, 6}, false, t);
+        check_batchnorm({3, 4, 5, 6}, true, t);
+        check_batchnorm({64, 16, 12, 12}, false, t);  // Large enough to run in parallel
+        check_batchnorm({64, 16, 12, 12}, true, t);
+    }
+}
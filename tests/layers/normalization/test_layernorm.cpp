@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/tensor/nn/tensor_nn.h"
+
+
+// Checks the native row normalization (LayerNorm with K=L, GroupNorm with K=channels per
+// group) against a straightforward double precision reference
+static void check_layernorm(int R, int L, int K, bool affine){
+    int S = L / K;
+    Tensor *x = Tensor::randn({R, L});
+    x->add_(50.0f);  // Large offset: the statistics must not suffer from cancellation
+    Tensor *y = Tensor::zeros({R, L}), *opa = Tensor::zeros({R, L});
+    Tensor *mean = Tensor::zeros({R}), *sd = Tensor::zeros({R});
+    Tensor *g = affine ? Tensor::randn({K}) : nullptr, *b = affine ? Tensor::randn({K}) : nullptr;
+    float eps = 1e-5f;
+
+    tensorNN::LayerNormForward(x, y, opa, mean, sd, g, b, eps);
+
+    Tensor *dy = Tensor::randn({R, L});
+    Tensor *pd = Tensor::ones({R, L});
+    Tensor *gg = affine ? Tensor::zeros({K}) : nullptr, *gb = affine ? Tensor::zeros({K}) : nullptr;
+    tensorNN::LayerNormBackward(dy, opa, pd, sd, g, gg, gb);
+
+    vector<double> rg(K, 0.0), rb(K, 0.0);
+    for(int r=0; r<R; r++) {
+        const float *p = x->ptr + (long int)r*L, *d = dy->ptr + (long int)r*L;
+        double mu = 0.0, var = 0.0;
+        for(int j=0; j<L; j++) mu += p[j];
+        mu /= L;
+        for(int j=0; j<L; j++) var += (p[j] - mu) * (p[j] - mu);
+        double s = sqrt(var / L + eps);
+        ASSERT_NEAR(mean->ptr[r], mu, 1e-3);
+        ASSERT_NEAR(sd->ptr[r], s, 1e-3);
+
+        double a = 0.0, c = 0.0;
+        for(int j=0; j<L; j++) {
+            double xh = (p[j] - mu) / s, gk = affine ? g->ptr[j/S] : 1.0;
+            ASSERT_NEAR(opa->ptr[(long int)r*L + j], xh, 1e-3);
+            ASSERT_NEAR(y->ptr[(long int)r*L + j], affine ? gk*xh + b->ptr[j/S] : xh, 1e-3);
+            a += gk*d[j];
+            c += gk*d[j]*xh;
+            rg[j/S] += d[j]*xh;
+            rb[j/S] += d[j];
+        }
+        for(int j=0; j<L; j++) {
+            double xh = (p[j] - mu) / s, gk = affine ? g->ptr[j/S] : 1.0;
+            ASSERT_NEAR(pd->ptr[(long int)r*L + j], 1.0 + (gk*d[j] - a/L - c/L*xh) / s, 1e-3);
+        }
+    }
+    if (affine) {
+        for(int k=0; k<K; k++) {
+            ASSERT_NEAR(gg->ptr[k], rg[k] / (R*S), 1e-3);
+            ASSERT_NEAR(gb->ptr[k], rb[k] / (R*S), 1e-3);
+        }
+    }
+
+    delete x; delete y; delete opa; delete mean; delete sd; delete dy; delete pd;
+    delete g; delete b; delete gg; delete gb;
+}
+
+
+TEST(LayerNormTestSuite, layernorm_native_cpu){
+    for(int a=0; a<2; a++) {
+        check_layernorm(7, 33, 33, a);      // LayerNorm over Dense outputs
+        check_layernorm(4, 3*5*5, 3, a);    // GroupNorm, 3 channels per group
+        check_layernorm(64, 512, 512, a);   // Large enough to run in parallel
+        check_layernorm(64, 4*8*8, 4, a);
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef EDDL_TESTS_POOL_REFERENCE_H
+#define EDDL_TESTS_POOL_REFERENCE_H
+
+#include <gtest/gtest.h>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/tensor/nn/tensor_nn.h"
+#include "eddl/descriptors/descriptors.h"
+
+
+// Naive pooling loops, to check the CPU kernels (interior/border split, channels-last) against
+
+// Address of (b, k, y, x) in a channels-first or channels-last map
+static inline int pool_test_index(bool nhwc, int b, int k, int y, int x, int z, int r, int c){
+    return nhwc ? ((b*r + y)*c + x)*z + k : ((b*z + k)*r + y)*c + x;
+}
+
+// Max pooling of pd->I and its backward of pd->D: the padding reads as zeros and the first maximum wins
+static inline void mpool_reference(PoolDescriptor *pd, bool nhwc, Tensor *ref_O, Tensor *ref_ID){
+    for(int b=0; b<pd->I->shape[0]; b++)
+        for(int k=0; k<pd->z; k++)
+            for(int y=0; y<pd->r; y++)
+                for(int x=0; x<pd->c; x++){
+                    float m = CPU_LOWEST_FLOAT;
+                    int my = -1, mx = -1;
+                    for(int ki=0; ki<pd->kr; ki++)
+                        for(int kj=0; kj<pd->kc; kj++){
+                            int iy = y*pd->sr - pd->padrt + ki;
+                            int ix = x*pd->sc - pd->padcl + kj;
+                            bool in = iy >= 0 && iy < pd->ir && ix >= 0 && ix < pd->ic;
+                            float v = in ? pd->I->ptr[pool_test_index(nhwc, b, k, iy, ix, pd->iz, pd->ir, pd->ic)] : 0.0f;
+                            if (v > m) { m = v; my = in ? iy : -1; mx = ix; }
+                        }
+                    int po = pool_test_index(nhwc, b, k, y, x, pd->z, pd->r, pd->c);
+                    ref_O->ptr[po] = m;
+                    if (my >= 0) ref_ID->ptr[pool_test_index(nhwc, b, k, my, mx, pd->iz, pd->ir, pd->ic)] += pd->D->ptr[po];
+                }
+}
+
+// Average pooling of pd->I and its backward of pd->D: the padding counts as zeros
+static inline void avgpool_reference(PoolDescriptor *pd, bool nhwc, Tensor *ref_O, Tensor *ref_ID){
+    float ksize = (float)(pd->kr * pd->kc);
+    for(int b=0; b<pd->I->shape[0]; b++)
+        for(int k=0; k<pd->z; k++)
+            for(int y=0; y<pd->r; y++)
+                for(int x=0; x<pd->c; x++){
+                    int po = pool_test_index(nhwc, b, k, y, x, pd->z, pd->r, pd->c);
+                    for(int ki=0; ki<pd->kr; ki++)
+                        for(int kj=0; kj<pd->kc; kj++){
+                            int iy = y*pd->sr - pd->padrt + ki;
+                            int ix = x*pd->sc - pd->padcl + kj;
+                            if (iy < 0 || iy >= pd->ir || ix < 0 || ix >= pd->ic) continue;
+                            int pi = pool_test_index(nhwc, b, k, iy, ix, pd->iz, pd->ir, pd->ic);
+                            ref_O->ptr[po] += pd->I->ptr[pi] / ksize;
+                            ref_ID->ptr[pi] += pd->D->ptr[po] / ksize;
+                        }
+                }
+}
+
+// Checks the CPU pooling of random images against the reference, for every window ({kr, kc, sr, sc}),
+// padding and layout
+static inline void expect_pool_reference(bool maxpool, const vector<vector<int>>& windows, const vector<int>& ishape){
+    vector<string> padding = {"valid", "same"};
+
+    for(auto& w : windows){
+        for(auto& p : padding){
+            for(int nhwc=0; nhwc<2; nhwc++){
+                SCOPED_TRACE("window " + std::to_string(w[0]) + "x" + std::to_string(w[1]) + ", " + p + (nhwc ? ", nhwc" : ", nchw"));
+                Tensor* t_image = Tensor::randn(ishape);
+
+                auto *pd = new PoolDescriptor({w[0], w[1]}, {w[2], w[3]}, p);
+                pd->build(t_image);
+                if (nhwc) pd->set_layout(LayoutNHWC, LayoutNHWC);
+                pd->ID = Tensor::zeros(pd->I->getShape());
+                pd->D = Tensor::randn(pd->O->getShape());
+
+                Tensor *ref_O = Tensor::zeros(pd->O->getShape());
+                Tensor *ref_ID = Tensor::zeros(pd->I->getShape());
+                if (maxpool) {
+                    pd->indX = new Tensor(pd->O->getShape());
+                    pd->indY = new Tensor(pd->O->getShape());
+                    tensorNN::MPool2D(pd);
+                    tensorNN::MPool2D_back(pd);
+                    mpool_reference(pd, nhwc, ref_O, ref_ID);
+                }
+                else {
+                    tensorNN::AvgPool2D(pd);
+                    tensorNN::AvgPool2D_back(pd);
+                    avgpool_reference(pd, nhwc, ref_O, ref_ID);
+                }
+
+                ASSERT_TRUE((bool) Tensor::equivalent(ref_O, pd->O, 10e-5f));
+                ASSERT_TRUE((bool) Tensor::equivalent(ref_ID, pd->ID, 10e-5f));
+            }
+        }
+    }
+}
+
+#endif //EDDL_TESTS_POOL_REFERENCE_H
@@ -4,6 +4,8 @@
 #include "eddl/tensor/nn/tensor_nn.h"
 #include "eddl/descriptors/descriptors.h"
 
+#include "pool_reference.h"
+
 
 TEST(AvgPoolTestSuite, avgpool_k2x2_s2x2_pad_valid)
 {
@@ -273,6 +275,13 @@ TEST(AvgPoolTestSuite, avgpool_k3x3_s2x2_pad_same)
 }
 
 
+TEST(AvgPoolTestSuite, avgpool_interior_border_equivalent_reference)
+{
+    // {kr, kc, sr, sc}: the specialized kernels and a generic one
+    expect_pool_reference(false, {{2, 2, 2, 2}, {3, 3, 2, 2}, {3, 2, 1, 1}}, {2, 3, 11, 8});
+}
+
+
 #ifdef cGPU
 TEST(MaxPoolTestSuite, avgpool_k2x2_s2x2_pad_valid_gpu)
 {
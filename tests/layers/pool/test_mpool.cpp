@@ -4,6 +4,8 @@
 #include "eddl/tensor/nn/tensor_nn.h"
 #include "eddl/descriptors/descriptors.h"
 
+#include "pool_reference.h"
+
 
 
 TEST(MaxPoolTestSuite, mpool_k2x2_s2x2_pad_valid)
@@ -271,6 +273,20 @@ TEST(MaxPoolTestSuite, mpool_k3x3_s2x2_pad_same){
     ASSERT_TRUE((bool) Tensor::equivalent(t_bwrd, pd->ID, 10e-5f));
 }
 
+TEST(MaxPoolTestSuite, mpool_interior_border_equivalent_reference)
+{
+    // {kr, kc, sr, sc}: the specialized kernels and a generic one
+    expect_pool_reference(true, {{2, 2, 2, 2}, {3, 3, 2, 2}, {3, 2, 1, 1}}, {2, 3, 11, 8});
+}
+
+
+TEST(MaxPoolTestSuite, mpool_large_window_reference)
+{
+    // {kr, kc, sr, sc}: too big for 8-bit in-window offsets, the argmax keeps input offsets
+    expect_pool_reference(true, {{17, 16, 2, 2}}, {2, 3, 20, 18});
+}
+
+
 #ifdef cGPU
 TEST(MaxPoolTestSuite, mpool_k2x2_s2x2_pad_valid_gpu)
 {
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/tensor/tensor.h"
+
+
+using namespace eddl;
+
+static double sigm(double x) { return 1.0 / (1.0 + exp(-x)); }
+
+
+// One SGD step (lr=1) of Dense(LSTM(x)) over a short sequence, compared with a plain BPTT
+// reference. With mask_zeros, an all-zero input step must leave the state untouched.
+static void check_lstm_step(bool mask_zeros){
+    int B = 3, T = 4, d = 5, u = 6, k = 2;
+
+    layer in = Input({d});
+    layer l = LSTM(in, u, mask_zeros);
+    layer out = Dense(l, k);
+    model net = Model({in}, {out});
+    build(net, sgd(1.0f, 0.0f), {"mse"}, {"mse"}, CS_CPU(1), true);
+
+    Tensor *x = Tensor::randn({B, T, d});
+    Tensor *y = Tensor::randn({B, 1, k});
+    if (mask_zeros) for(int j=0; j<d; j++) x->ptr[(0*T + 2)*d + j] = 0.0f;  // sample 0, step 2
+
+    // Build the unrolled net (lr=0 leaves the params untouched), then one step over the batch in order
+    setlr(net, {0.0f});
+    fit(net, {x}, {y}, B, 1);
+    setlr(net, {1.0f});
+
+    vector<vtensor> p0 = get_parameters(net, true);
+    vtensor xt, xtd, yt, tinr, toutr;
+    int inl, outl;
+    net->prepare_recurrent({x}, {y}, inl, outl, xt, xtd, yt, tinr, toutr);
+    vind sind;
+    for(int b=0; b<B; b++) sind.push_back(b);
+    net->rnet->train_batch(tinr, toutr, sind);
+    vector<vtensor> p1 = get_parameters(net, true);
+    for(auto *t : tinr) delete t;
+    for(auto *t : toutr) delete t;
+    for(auto *t : xt) delete t;
+    for(auto *t : yt) delete t;
+
+    // Params: LSTM {Wix,Wfx,Wox,Wcx, Wih,Wfh,Woh,Wch, bi,bf,bo,bc}, Dense {W,b}
+    vtensor &P = p0[1];
+    float *Wd = p0[2][0]->ptr, *bd = p0[2][1]->ptr;
+    vector<vector<double>> gW(12), gD(2);
+    for(int i=0; i<12; i++) gW[i].assign(P[i]->size, 0.0);
+    gD[0].assign(u*k, 0.0); gD[1].assign(k, 0.0);
+
+    for(int b=0; b<B; b++) {
+        // Forward, keeping every step
+        vector<vector<double>> h(T+1, vector<double>(u, 0.0)), c = h, gi = h, gf = h, go = h, gc = h;
+        vector<bool> masked(T, false);
+        for(int t=0; t<T; t++) {
+            const float *xt = x->ptr + (b*T + t)*d;
+            if (mask_zeros) {
+                masked[t] = true;
+                for(int j=0; j<d; j++) if (xt[j] != 0.0f) masked[t] = false;
+            }
+            if (masked[t]) { h[t+1] = h[t]; c[t+1] = c[t]; continue; }
+            for(int j=0; j<u; j++) {
+                double a[4];
+                for(int g=0; g<4; g++) {
+                    a[g] = P[8+g]->ptr[j];
+                    for(int q=0; q<d; q++) a[g] += xt[q] * P[g]->ptr[q*u + j];
+                    for(int q=0; q<u; q++) a[g] += h[t][q] * P[4+g]->ptr[q*u + j];
+                }
+                gi[t][j] = sigm(a[0]); gf[t][j] = sigm(a[1]); go[t][j] = sigm(a[2]); gc[t][j] = tanh(a[3]);
+                c[t+1][j] = gi[t][j]*gc[t][j] + gf[t][j]*c[t][j];
+                h[t+1][j] = go[t][j]*tanh(c[t+1][j]);
+            }
+        }
+
+        // Dense and mse delta (Y-T)/B on the last step
+        vector<double> dh(u, 0.0), dc(u, 0.0);
+        for(int o=0; o<k; o++) {
+            double yo = bd[o];
+            for(int j=0; j<u; j++) yo += h[T][j] * Wd[j*k + o];
+            double dy = (yo - y->ptr[b*k + o]) / B;
+            gD[1][o] += dy;
+            for(int j=0; j<u; j++) { gD[0][j*k + o] += h[T][j] * dy; dh[j] += dy * Wd[j*k + o]; }
+        }
+
+        // BPTT
+        for(int t=T-1; t>=0; t--) {
+            if (masked[t]) continue;  // Deltas go straight to the previous step
+            const float *xt = x->ptr + (b*T + t)*d;
+            vector<double> nh(u, 0.0), nc(u, 0.0);
+            for(int j=0; j<u; j++) {
+                double tc = tanh(c[t+1][j]);
+                double dcc = dc[j] + dh[j]*go[t][j]*(1 - tc*tc);
+                double da[4] = {dcc*gc[t][j]*gi[t][j]*(1 - gi[t][j]),
+                                dcc*c[t][j]*gf[t][j]*(1 - gf[t][j]),
+                                dh[j]*tc*go[t][j]*(1 - go[t][j]),
+                                dcc*gi[t][j]*(1 - gc[t][j]*gc[t][j])};
+                nc[j] = dcc*gf[t][j];
+                for(int g=0; g<4; g++) {
+                    gW[8+g][j] += da[g];
+                    for(int q=0; q<d; q++) gW[g][q*u + j] += xt[q]*da[g];
+                    for(int q=0; q<u; q++) { gW[4+g][q*u + j] += h[t][q]*da[g]; nh[q] += da[g]*P[4+g]->ptr[q*u + j]; }
+                }
+            }
+            dh = nh; dc = nc;
+        }
+    }
+
+    // lr=1: the update is the gradient
+    for(int i=0; i<12; i++)
+        for(int j=0; j<P[i]->size; j++)
+            ASSERT_NEAR(P[i]->ptr[j] - p1[1][i]->ptr[j], gW[i][j], 1e-4);
+    for(int i=0; i<2; i++)
+        for(int j=0; j<p0[2][i]->size; j++)
+            ASSERT_NEAR(p0[2][i]->ptr[j] - p1[2][i]->ptr[j], gD[i][j], 1e-4);
+
+    delete x;
+    delete y;
+    delete net;
+}
+
+
+TEST(LSTMTestSuite, lstm_fused_bptt){
+    check_lstm_step(false);
+    check_lstm_step(true);
+}
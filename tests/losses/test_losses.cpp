@@ -4,12 +4,17 @@
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 
 #include "eddl/apis/eddl.h"
 
 #include "eddl/tensor/tensor.h"
 #include "eddl/tensor/nn/tensor_nn.h"
 #include "eddl/descriptors/descriptors.h"
+#include "eddl/random.h"
+
+#include "../net/net_compare.h"
 
 
 using namespace eddl;
@@ -148,3 +153,70 @@ TEST(NetTestSuite, losses_binary_cross_entropy){
     delete t_gpu_delta;
 #endif
 }
+
+
+// -sum(t * log_softmax(x)) / rows, in double
+static double softmax_ce_ref(Tensor *T, Tensor *X, vector<double> &lse){
+    int n = X->shape[1];
+    double sum = 0.0;
+    lse.assign(X->shape[0], 0.0);
+    for(int r=0; r<X->shape[0]; r++) {
+        const float *x = X->ptr + r*n, *t = T->ptr + r*n;
+        double m = x[0], s = 0.0;
+        for(int j=1; j<n; j++) m = std::max(m, (double) x[j]);
+        for(int j=0; j<n; j++) s += std::exp(x[j] - m);
+        lse[r] = m + std::log(s);
+        for(int j=0; j<n; j++) sum -= t[j] * (x[j] - lse[r]);
+    }
+    return sum / X->shape[0];
+}
+
+static model softmax_ce_net(bool fusable, const string& mem){
+    layer in = Input({20});
+    layer l = Dense(ReLu(Dense(in, 16)), 10);
+
+    // Same layers, but a Linear(1) after the softmax leaves nothing to fuse
+    layer out = fusable ? Softmax(Linear(l, 1.0f)) : Linear(Softmax(l), 1.0f);
+    model net = Model({in}, {out});
+    build(net, sgd(0.1f), {"categorical_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1, mem), true);
+    return net;
+}
+
+TEST(NetTestSuite, losses_softmax_cross_entropy_fused){
+    // Loss from the logits and the log-sum-exp of each row
+    set_random_seed(1234);
+    Tensor *X = Tensor::randn({6, 10});
+    X->mult_(3.0f);
+    Tensor *T = Tensor::zeros({6, 10});
+    for(int i=0; i<6; i++) T->ptr[i*10 + (i*7)%10] = 1.0f;
+
+    Tensor *Y = Tensor::empty_like(X);
+    Tensor *LSE = Tensor::empty({6});
+    vector<double> lse;
+    for(float scale : {1.0f, 100.0f}) {
+        // Then large logits: the probabilities underflow, the loss from the logits does not
+        X->mult_(scale);
+        tensorNN::SoftmaxLSE(X, Y, LSE);
+        double ref = softmax_ce_ref(T, X, lse);
+        for(int i=0; i<6; i++) ASSERT_NEAR(LSE->ptr[i], lse[i], 1e-5 * std::fabs(lse[i]));
+        ASSERT_NEAR(tensorNN::softmax_cross_entropy(T, X, LSE), ref, 1e-5 * std::fabs(ref));
+    }
+
+    delete X; delete T; delete Y; delete LSE;
+
+    // Nets: Softmax + categorical_cross_entropy trains as the unfused composition
+    for(auto& mem : vector<string>{"full_mem", "low_mem"}) {
+        model net_ref = softmax_ce_net(false, mem);
+        model net_fused = softmax_ce_net(true, mem);
+        set_parameters(net_fused, get_parameters(net_ref, true));
+        ASSERT_NE(dynamic_cast<LSoftmaxCrossEntropy *>(net_fused->losses[0]), nullptr);
+        ASSERT_EQ(net_fused->losses[0]->name, "categorical_cross_entropy");
+        ASSERT_EQ(dynamic_cast<LSoftmaxCrossEntropy *>(net_ref->losses[0]), nullptr);
+
+        ASSERT_NO_FATAL_FAILURE(expect_same_training(net_ref, net_fused, onehot_batches({20}, 10), {1, 8}, 3, 1e-3f));
+        ASSERT_NEAR(net_ref->fiterr[0], net_fused->fiterr[0], 1e-3f);
+
+        delete net_ref;
+        delete net_fused;
+    }
+}
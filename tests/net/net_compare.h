@@ -0,0 +1,69 @@
+#ifndef EDDL_TESTS_NET_COMPARE_H
+#define EDDL_TESTS_NET_COMPARE_H
+
+#include <functional>
+
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+#include "eddl/tensor/tensor.h"
+
+
+using namespace eddl;
+
+// Shared checks of the tests that compare a net using some feature with the same net without it.
+// Nets are built with batch 1: a first batch of 1 runs without Net::resize (where the views made
+// at build time are still the ones in use) and the other batch sizes go through it.
+
+// Fills x and y with a batch of the given size
+typedef std::function<void(int batch, Tensor *&x, Tensor *&y)> batch_fn;
+
+// Random inputs of shape {batch}+ishape, one-hot targets of the given number of classes
+static inline batch_fn onehot_batches(const vector<int>& ishape, int classes){
+    return [ishape, classes](int batch, Tensor *&x, Tensor *&y) {
+        vector<int> shape = ishape;
+        shape.insert(shape.begin(), batch);
+        x = Tensor::randn(shape);
+        y = Tensor::zeros({batch, classes});
+        for(int i=0; i<batch; i++) y->ptr[i*classes + i%classes] = 1.0f;
+    };
+}
+
+static inline void expect_same_parameters(model net_ref, model net, float tol){
+    vector<vtensor> p_ref = get_parameters(net_ref, true);
+    vector<vtensor> p = get_parameters(net, true);
+    ASSERT_EQ(p_ref.size(), p.size());
+    for(int i=0; i<p_ref.size(); i++)
+        for(int j=0; j<p_ref[i].size(); j++)
+            ASSERT_TRUE((bool) Tensor::equivalent(p_ref[i][j], p[i][j], tol, tol)) << "layer " << net->layers[i]->name;
+}
+
+static inline void expect_same_predictions(model net_ref, model net, Tensor *x, float tol){
+    vtensor o_ref = predict(net_ref, {x});
+    vtensor o = predict(net, {x});
+    for(int i=0; i<o_ref.size(); i++) EXPECT_TRUE((bool) Tensor::equivalent(o_ref[i], o[i], tol, tol));
+    for(auto *t : o_ref) delete t;
+    for(auto *t : o) delete t;
+}
+
+// For every batch size in turn, checks that both nets predict the same, then trains them the given steps
+// and checks that they end up with the same parameters. net should start with the parameters of net_ref
+static inline void expect_same_training(model net_ref, model net, const batch_fn& batches, const vector<int>& sizes={1, 4},
+                                        int steps=3, float tol=1e-4f){
+    for(int b : sizes) {
+        SCOPED_TRACE("batch " + std::to_string(b));
+        Tensor *x, *y;
+        batches(b, x, y);
+        expect_same_predictions(net_ref, net, x, tol);
+        for(int i=0; i<steps; i++) {
+            train_batch(net_ref, {x}, {y});
+            train_batch(net, {x}, {y});
+        }
+        ASSERT_NO_FATAL_FAILURE(expect_same_parameters(net_ref, net, tol));
+        delete x;
+        delete y;
+    }
+}
+
+#endif //EDDL_TESTS_NET_COMPARE_H
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+#include "eddl/tensor/tensor.h"
+
+#include "net_compare.h"
+
+
+using namespace eddl;
+
+
+static model checkpoint_net(const string& mem){
+    layer in = Input({3, 8, 8});
+    layer l = ReLu(Conv(in, 4, {3, 3}));
+    for(int i=0; i<4; i++) {
+        layer r = Dropout(ReLu(BatchNormalization(Conv(l, 4, {3, 3}))), 0.3f);
+        l = Tanh(Add({l, Conv(r, 4, {3, 3})}));
+    }
+    layer out = Softmax(Dense(Reshape(l, {-1}), 5));
+    model net = Model({in}, {out});
+
+    build(net, sgd(0.05f, 0.9f), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1, mem), true);
+    set_seed(net, 1234);
+    return net;
+}
+
+TEST(NetTestSuite, gradient_checkpointing){
+    model net_ref = checkpoint_net("low_mem");
+    model net_ckpt = checkpoint_net("recompute_mem");
+    set_parameters(net_ckpt, get_parameters(net_ref, true));
+    ASSERT_GT(net_ckpt->ckpt_drop.size(), 2);
+
+    for(int k=0; k<2; k++) {
+        ASSERT_NO_FATAL_FAILURE(expect_same_training(net_ref, net_ckpt, onehot_batches({3, 8, 8}, 5)));
+
+        // The segments are dropped again after their backward
+        int dropped = 0;
+        for(auto *l : net_ckpt->layers) dropped += (l->output->ptr == nullptr);
+        ASSERT_GT(dropped, 10);
+
+        // Segments set by hand
+        set_checkpoints(net_ckpt, {net_ckpt->vfts[net_ckpt->vfts.size() / 2]});
+    }
+    ASSERT_EQ(net_ckpt->ckpt_drop.size(), 2);
+
+    delete net_ref;
+    delete net_ckpt;
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+#include "eddl/tensor/tensor.h"
+
+#include "net_compare.h"
+
+
+using namespace eddl;
+
+
+static model flat_net(bool flat, optimizer opt, const string& mem){
+    layer in = Input({3, 8, 8});
+    layer l = ReLu(BatchNormalization(Conv(in, 4, {3, 3}), true));
+    layer out = Softmax(Dense(Flatten(l), 5));
+    model net = Model({in}, {out});
+
+    opt->set_clip_val(0.5f);
+    build(net, opt, {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1, mem), true, flat);
+    return net;
+}
+
+
+TEST(NetTestSuite, flat_params){
+    for(int o=0; o<4; o++) {
+        string mem = (o < 2) ? "full_mem" : "low_mem";
+        model net_ref = flat_net(false, (o % 2 == 0) ? sgd(0.1f, 0.9f) : adam(0.01f), mem);
+        model net_flat = flat_net(true, (o % 2 == 0) ? sgd(0.1f, 0.9f) : adam(0.01f), mem);
+        set_parameters(net_flat, get_parameters(net_ref, true));
+
+        // Every param and gradient lives inside the arenas
+        ASSERT_NE(net_flat->param_arena, nullptr);
+        ASSERT_NE(net_flat->optimizer->flat_params, nullptr);
+        for(auto *l : net_flat->layers) {
+            for(auto *p : l->params) {
+                ASSERT_TRUE(p->ptr >= net_flat->param_arena->ptr);
+                ASSERT_TRUE(p->ptr + p->size <= net_flat->param_arena->ptr + net_flat->param_arena->size);
+            }
+            for(auto *g : l->gradients) {
+                ASSERT_TRUE(g->ptr >= net_flat->grad_arena->ptr);
+                ASSERT_TRUE(g->ptr + g->size <= net_flat->grad_arena->ptr + net_flat->grad_arena->size);
+            }
+        }
+
+        ASSERT_NO_FATAL_FAILURE(expect_same_training(net_ref, net_flat, onehot_batches({3, 8, 8}, 5)));
+
+        zeroGrads(net_flat);
+        ASSERT_EQ(net_flat->grad_arena->sum_abs(), 0.0f);
+
+        delete net_ref;
+        delete net_flat;
+    }
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+#include "eddl/tensor/tensor.h"
+
+#include "net_compare.h"
+
+
+using namespace eddl;
+
+
+static model fusion_net(bool fusable, const string& mem){
+    layer in = Input({3, 10, 10});
+    layer l = Conv(in, 6, {3, 3});
+
+    // ThresholdedReLu(0) is a ReLu that is not fused
+    layer a = fusable ? ReLu(l) : ThresholdedReLu(l, 0.0f);
+
+    // Views of both fused outputs
+    l = Tanh(Conv(a, 4, {3, 3}, {2, 2}));
+    layer out = Softmax(Dense(Concat({Flatten(a), Flatten(l)}), 5));
+    model net = Model({in}, {out});
+
+    build(net, sgd(0.1f), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1, mem), true);
+    return net;
+}
+
+
+TEST(NetTestSuite, conv_activation_fusion){
+    for(auto& mem : vector<string>{"full_mem", "low_mem"}) {
+        model net_ref = fusion_net(false, mem);
+        model net_fused = fusion_net(true, mem);
+        set_parameters(net_fused, get_parameters(net_ref, true));
+
+        int n = 0;
+        for(auto *l : net_fused->layers) {
+            auto *a = dynamic_cast<LActivation *>(l);
+            if (a != nullptr) n += a->fused;
+        }
+        ASSERT_EQ(n, 2);
+
+        ASSERT_NO_FATAL_FAILURE(expect_same_training(net_ref, net_fused, onehot_batches({3, 10, 10}, 5), {1, 4}, 2, 1e-3f));
+
+        delete net_ref;
+        delete net_fused;
+    }
+}
+
+
+TEST(NetTestSuite, conv_activation_fusion_views){
+    // Batch 1 is the build batch: no resize puts the views of the fused output right
+    layer in = Input({3, 6, 6});
+    layer a = ReLu(Conv(in, 4, {3, 3}));
+    layer r = Reshape(a, {-1});
+    layer out = Softmax(Dense(r, 5));
+    model net = Model({in}, {out});
+    build(net, sgd(0.1f), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1), true);
+    ASSERT_TRUE(((LActivation *) a)->fused);
+
+    Tensor *x = Tensor::randn({1, 3, 6, 6});
+    delete predict(net, {x})[0];
+    ASSERT_EQ(r->output->ptr, a->output->ptr);
+    for(int i=0; i<a->output->size; i++) ASSERT_GE(r->output->ptr[i], 0.0f);
+
+    delete x;
+    delete net;
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+#include "eddl/tensor/tensor.h"
+
+#include "net_compare.h"
+
+
+using namespace eddl;
+
+
+static model inplace_net(bool inplace, const string& mem){
+    layer in = Input({3, 8, 8});
+    layer l = ReLu(BatchNormalization(Conv(in, 4, {3, 3})));
+    l = Reshape(MaxPool(l, {2, 2}), {-1});
+    l = Dropout(Dense(l, 16), 0.3f);
+    l = Tanh(Dense(l, 16));
+    l = GaussianNoise(Dense(l, 16), 0.1f);
+    l = Reshape(Sigmoid(Dense(l, 16)), {4, 4});  // View of an in-place output
+    layer out = Softmax(Dense(Reshape(l, {-1}), 5));
+    model net = Model({in}, {out});
+
+    build(net, sgd(0.1f, 0.9f), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1, mem), true, false, inplace);
+    set_seed(net, 42);
+    return net;
+}
+
+
+TEST(NetTestSuite, inplace_layers){
+    for(auto& mem : vector<string>{"full_mem", "low_mem"}) {
+        model net_ref = inplace_net(false, mem);
+        model net_inplace = inplace_net(true, mem);
+        set_parameters(net_inplace, get_parameters(net_ref, true));
+
+        int n = 0;
+        for(auto *l : net_inplace->layers) {
+            if (!l->inplace) continue;
+            ASSERT_EQ(l->output->ptr, l->parent[0]->output->ptr);
+            n++;
+        }
+        ASSERT_EQ(n, 5);
+
+        ASSERT_NO_FATAL_FAILURE(expect_same_training(net_ref, net_inplace, onehot_batches({3, 8, 8}, 5), {1, 4, 2}));
+
+        delete net_ref;
+        delete net_inplace;
+    }
+}
+
+
+TEST(NetTestSuite, view_layers){
+    for(bool inplace : {false, true}) {
+        layer in = Input({1, 4, 5});
+        layer p = Permute(in, {1, 0, 2});  // Moves a size-1 axis: same memory order
+        layer s = Select(p, {":", "0", ":"});
+        layer c = Select(in, {":", "1:3", ":"});  // Part of each sample: copied
+        layer a = ReLu(Conv(Reshape(s, {1, 4, 5}), 2, {3, 3}));  // Fused
+        layer v = Select(a, {":", ":", ":"});
+        layer out = Softmax(Dense(Concat({Reshape(v, {-1}), Reshape(c, {-1})}), 3));
+        model net = Model({in}, {out});
+        build(net, sgd(0.1f), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1, "low_mem"), true, false, inplace);
+
+        // Views only with the opt-in
+        ASSERT_EQ(p->inplace && s->inplace && v->inplace, inplace);
+        ASSERT_FALSE(c->inplace);
+
+        // Batch 1 (the build batch) and another one
+        for(int b : {1, 3}) {
+            Tensor *x = Tensor::randn({b, 1, 4, 5});
+            Tensor *y = Tensor::zeros({b, 3});
+            for(int i=0; i<b; i++) y->ptr[i*3 + i] = 1.0f;
+            train_batch(net, {x}, {y});
+
+            if (inplace) {
+                ASSERT_EQ(s->output->ptr, in->output->ptr);
+                ASSERT_EQ(v->output->ptr, a->output->ptr);
+            }
+            ASSERT_EQ(s->output->shape, vector<int>({b, 4, 1, 5}));
+            Tensor *ref = x->select({":", "0", "1:3", ":"});
+            ASSERT_TRUE((bool) Tensor::equivalent(ref, c->output, 1e-6f, 1e-6f));
+            ASSERT_TRUE((bool) Tensor::equivalent(a->output, v->output, 1e-6f, 1e-6f));
+
+            delete ref;
+            delete x;
+            delete y;
+        }
+        delete net;
+    }
+}
+
+
+TEST(NetTestSuite, inplace_layers_views){
+    // Batch 1 is the build batch: no resize puts the views of the in-place output right
+    layer in = Input({8});
+    layer a = ReLu(Dense(in, 20));
+    layer r = Reshape(a, {4, 5});
+    layer out = Softmax(Dense(Reshape(r, {-1}), 3));
+    model net = Model({in}, {out});
+    build(net, sgd(0.1f), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1), true, false, true);
+    ASSERT_TRUE(a->inplace);
+
+    Tensor *x = Tensor::randn({1, 8});
+    delete predict(net, {x})[0];
+    ASSERT_EQ(r->output->ptr, a->output->ptr);
+    for(int i=0; i<a->output->size; i++) ASSERT_GE(r->output->ptr[i], 0.0f);
+
+    delete x;
+    delete net;
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+#include "eddl/tensor/tensor.h"
+
+#include "net_compare.h"
+
+
+using namespace eddl;
+
+
+static model layout_net(const string& mem){
+    layer in = Input({3, 12, 12});
+    layer l = in;
+
+    l = ReLu(BatchNormalization(Conv(l, 8, {3, 3})));
+    layer skip = l;
+    l = ReLu(Conv(l, 8, {3, 3}, {1, 1}, "same", false));
+    l = Add({l, skip});
+    l = MaxPool(l, {2, 2});
+    l = AveragePool(Conv(l, 4, {3, 3}, {2, 2}), {2, 2}, {1, 1}, "same");
+    l = Flatten(l);
+
+    layer out = Softmax(Dense(l, 5));
+    model net = Model({in}, {out});
+
+    build(net, sgd(0.1f), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1, mem), true);
+    return net;
+}
+
+
+TEST(NetTestSuite, nhwc_layout_equivalent_nchw){
+    for(auto& mem : vector<string>{"full_mem", "low_mem"}) {
+        model net_ref = layout_net(mem);
+        model net_nhwc = layout_net(mem);
+        set_parameters(net_nhwc, get_parameters(net_ref, true));
+
+        setLayout(net_nhwc, "nhwc");
+
+        // Every layer but the input boundary and the head works channels-last
+        int n = 0;
+        for(auto *l : net_nhwc->layers) n += (l->layout == LayoutNHWC);
+        ASSERT_EQ(n, 9);
+
+        ASSERT_NO_FATAL_FAILURE(expect_same_training(net_ref, net_nhwc, onehot_batches({3, 12, 12}, 5), {1, 4}, 1, 1e-3f));
+
+        // Back to channels-first
+        setLayout(net_nhwc, "nchw");
+        Tensor *x = Tensor::randn({2, 3, 12, 12});
+        expect_same_predictions(net_ref, net_nhwc, x, 1e-4f);
+
+        delete x;
+        delete net_ref;
+        delete net_nhwc;
+    }
+}
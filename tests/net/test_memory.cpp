@@ -611,3 +611,43 @@ TEST(NetTestSuite, net_delete_nlp_machine_translation){
     );
     delete net;
 }
+
+
+static model resize_net(const string& mem){
+    layer in = Input({2, 6, 6});
+    layer l = ReLu(Conv(in, 4, {3, 3}));
+    l = Reshape(l, {-1});
+    layer out = Softmax(Dense(l, 3));
+    model net = Model({in}, {out});
+
+    build(net, sgd(0.1f), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1, mem), true);
+    return net;
+}
+
+TEST(NetTestSuite, full_mem_train_after_resize){
+    // With full_mem the deltas outlive a batch, so a new batch size has to book them again
+    model net_ref = resize_net("low_mem");
+    model net = resize_net("full_mem");
+    set_parameters(net, get_parameters(net_ref, true));
+
+    for(int b : {1, 4}) {
+        Tensor *x = Tensor::randn({b, 2, 6, 6});
+        Tensor *y = Tensor::zeros({b, 3});
+        for(int i=0; i<b; i++) y->ptr[i*3 + i%3] = 1.0f;
+
+        train_batch(net_ref, {x}, {y});
+        train_batch(net, {x}, {y});
+
+        delete x;
+        delete y;
+    }
+
+    vector<vtensor> p_ref = get_parameters(net_ref, true);
+    vector<vtensor> p = get_parameters(net, true);
+    for(int i=0; i<p_ref.size(); i++)
+        for(int j=0; j<p_ref[i].size(); j++)
+            ASSERT_TRUE((bool) Tensor::equivalent(p_ref[i][j], p[i][j], 1e-4f, 1e-4f));
+
+    delete net_ref;
+    delete net;
+}
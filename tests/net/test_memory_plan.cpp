@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+#include "eddl/tensor/tensor.h"
+
+
+using namespace eddl;
+
+
+static layer res_block(layer l, int filters){
+    layer r = ReLu(BatchNormalization(Conv(l, filters, {3, 3})));
+    r = Conv(r, filters, {3, 3});
+    return ReLu(Add({l, r}));
+}
+
+TEST(NetTestSuite, inference_memory_plan){
+    layer in = Input({3, 8, 8});
+    layer l = ReLu(Conv(in, 4, {3, 3}));
+    for(int i=0; i<4; i++) l = res_block(l, 4);
+    l = Reshape(l, {-1});
+    layer out = Softmax(Dense(l, 5));
+    model net = Model({in}, {out});
+    build(net, sgd(0.1f), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1, "low_mem"), true);
+
+    Tensor *x = Tensor::randn({4, 3, 8, 8});
+    Tensor *y = Tensor::zeros({4, 5});
+    for(int i=0; i<4; i++) y->ptr[i*5 + i] = 1.0f;
+    Tensor *x2 = Tensor::randn({2, 3, 8, 8});
+
+    Tensor *o_ref = predict(net, {x})[0];
+    ASSERT_TRUE(net->plan_layers.empty());
+
+    plan_memory(net);
+    Tensor *o_plan = predict(net, {x})[0];
+    ASSERT_TRUE((bool) Tensor::equivalent(o_ref, o_plan, 1e-5f, 1e-5f));
+
+    // Depth does not add buffers: a few of them hold the outputs of every planned layer
+    long int planned = 0, buffers = 0;
+    for(int i=0; i<net->plan_layers.size(); i++)
+        if (net->plan_source[i] == nullptr) planned += net->plan_layers[i]->output->size;
+    for(auto *b : net->plan_buffers) buffers += b->size;
+    ASSERT_GT(net->plan_layers.size(), 20);
+    ASSERT_LE(net->plan_buffers.size(), 4);
+    ASSERT_LT(4 * buffers, planned);
+
+    // Other batch sizes are planned again
+    Tensor *o2_plan = predict(net, {x2})[0];
+    ASSERT_FALSE(net->plan_layers.empty());
+
+    plan_memory(net, false);
+    ASSERT_TRUE(net->plan_buffers.empty());
+    Tensor *o2_ref = predict(net, {x2})[0];
+    ASSERT_TRUE((bool) Tensor::equivalent(o2_ref, o2_plan, 1e-5f, 1e-5f));
+
+    // Training gives every layer its memory back
+    plan_memory(net);
+    delete predict(net, {x2})[0];
+    train_batch(net, {x}, {y});
+    ASSERT_TRUE(net->plan_layers.empty());
+    ASSERT_TRUE(net->plan_buffers.empty());
+
+    delete o_ref;
+    delete o_plan;
+    delete o2_plan;
+    delete o2_ref;
+    delete x;
+    delete x2;
+    delete y;
+    delete net;
+}
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <cmath>
 #include <random>
 #include <string>
 
@@ -150,4 +151,60 @@ TEST(TensorTestSuite, tensor_nn_full_softmax_nd2){
 TEST(TensorTestSuite, tensor_nn_full_softmax_nd3){
     int axis = 3;
     test_softmax_nd(axis);
-}
\ No newline at end of file
+}
+
+TEST(TensorTestSuite, tensor_nn_optimizer_steps){
+    // Fused steps against the textbook updates, computed element by element
+    Tensor* p0 = Tensor::randn({4, 37});
+    Tensor* g = Tensor::randn({4, 37});
+    int n = p0->size;
+    float lr = 0.1f, mu = 0.9f, wd = 0.01f, b1 = 0.9f, b2 = 0.999f, eps = 1e-6f, rho = 0.9f;
+
+    for (int opt = 0; opt < 5; opt++) {
+        Tensor* p = p0->clone();
+        Tensor* m = Tensor::zeros_like(p0);
+        Tensor* v = Tensor::zeros_like(p0);
+        vector<double> rp(p0->ptr, p0->ptr + n), rm(n, 0.0), rv(n, 0.0);
+
+        for (int t = 1; t <= 3; t++) {
+            if (opt == 0) tensorNN::sgd_step(p, g, m, lr, mu, wd, false);
+            else if (opt == 1) tensorNN::sgd_step(p, g, m, lr, mu, wd, true);
+            else if (opt == 2) tensorNN::adam_step(p, g, m, v, lr, b1, b2, eps, wd, t % 2 == 0, t);
+            else if (opt == 3) tensorNN::rmsprop_step(p, g, v, lr, rho, eps, wd);
+            else tensorNN::adagrad_step(p, g, v, lr, eps, wd);
+
+            for (int i = 0; i < n; i++) {
+                double gi = g->ptr[i] + wd * rp[i];
+                if (opt <= 1) {
+                    rm[i] = mu * rm[i] + lr * gi;
+                    rp[i] -= (opt == 1) ? mu * rm[i] + lr * gi : rm[i];
+                } else if (opt == 2) {
+                    bool decoupled = (t % 2 == 0);
+                    if (decoupled) gi = g->ptr[i];
+                    rm[i] = b1 * rm[i] + (1 - b1) * gi;
+                    rv[i] = b2 * rv[i] + (1 - b2) * gi * gi;
+                    double upd = (rm[i] / (1 - pow(b1, t))) / sqrt(rv[i] / (1 - pow(b2, t)) + eps);
+                    rp[i] = (decoupled ? 1 - lr * wd : 1.0) * rp[i] - lr * upd;
+                } else if (opt == 3) {
+                    rv[i] = rho * rv[i] + (1 - rho) * gi * gi;
+                    rp[i] -= lr * gi / sqrt(rv[i] + eps);
+                } else {
+                    rv[i] += gi * gi;
+                    rp[i] -= lr * gi / sqrt(rv[i] + eps);
+                }
+            }
+        }
+
+        for (int i = 0; i < n; i++) ASSERT_NEAR(p->ptr[i], rp[i], 1e-4) << "optimizer " << opt;
+        delete p;
+        delete m;
+        delete v;
+    }
+
+    Tensor* small = Tensor::zeros({3});
+    ASSERT_THROW(tensorNN::rmsprop_step(p0, g, small, lr, rho, eps, wd), std::runtime_error);
+
+    delete p0;
+    delete g;
+    delete small;
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/tensor/tensor_expr.h"
+
+
+using namespace std;
+
+
+TEST(TensorTestSuite, tensor_expr_equivalent_ops){
+    Tensor* a = Tensor::randn({4, 7, 5});
+    Tensor* b = Tensor::randu({4, 7, 5});
+    Tensor* c = Tensor::empty_like(a);
+
+    // Reference with one op per pass: c = sqrt(b + 0.5) * exp(-|a|) - max(a, 0.1) / 3
+    Tensor* r = b->clone(); r->add_(0.5f); r->sqrt_();
+    Tensor* aux = a->clone(); aux->abs_(); aux->neg_(); aux->exp_();
+    Tensor::el_mult(r, aux, r, 0);
+    Tensor::maximum(a, aux, 0.1f); aux->div_(3.0f);
+    Tensor::add(1.0f, r, -1.0f, aux, r, 0);
+
+    using namespace expr;
+    eval(c, sqrt(var(b) + 0.5f) * exp(-abs(var(a))) - maximum(var(a), 0.1f) / 3.0f);
+    ASSERT_TRUE((bool) Tensor::equivalent(c, r, 1e-5f, 1e-5f));
+
+    // The output can be read by the expression
+    Tensor* r2 = r->clone(); r2->mult_(0.9f);
+    Tensor::add(1.0f, r2, 0.1f, a, r2, 0);
+    eval(c, 0.9f*var(c) + 0.1f*var(a));
+    ASSERT_TRUE((bool) Tensor::equivalent(c, r2, 1e-5f, 1e-5f));
+
+    // Fused reduction
+    Tensor* d = a->clone(); Tensor::el_mult(d, b, d, 0);
+    ASSERT_NEAR(sum(var(a)*var(b)), d->sum(), 1e-3f);
+
+    // Sizes must match
+    Tensor* e = Tensor::zeros({3});
+    ASSERT_THROW(eval(e, var(a) + 1.0f), std::runtime_error);
+
+    delete a; delete b; delete c;
+    delete r; delete r2; delete aux; delete d; delete e;
+}
@@ -84,3 +84,54 @@ TEST(TensorTestSuite, tensor_indexing_where){
 
 #endif
 }
+
+
+TEST(TensorTestSuite, tensor_indexing_slice){
+    Tensor* t = Tensor::randn({6, 4, 5});
+
+    // Contiguous blocks are views
+    Tensor* v1 = t->slice({"2:4"});
+    ASSERT_EQ(v1->shape, vector<int>({2, 4, 5}));
+    ASSERT_EQ(v1->ptr, t->ptr + 40);
+    ASSERT_TRUE(v1->isshared);
+
+    Tensor* v2 = t->slice({"3", "1:3"});
+    ASSERT_EQ(v2->shape, vector<int>({1, 2, 5}));
+    ASSERT_EQ(v2->ptr, t->ptr + 65);
+
+    Tensor* s2 = t->select({"3", "1:3"});
+    ASSERT_TRUE(Tensor::equivalent(s2, v2, 10e-6));
+
+    // Selections and permutations moving whole runs match the address tables
+    vector<vector<string>> selections = {{":", "1:3", ":"}, {"1:5", ":", "2:4"}, {"0", ":", "3"}};
+    for(auto &indices : selections) {
+        auto *sd = new SelDescriptor(indices, DEV_CPU);
+        sd->build(t->shape);
+        Tensor* ref = new Tensor(sd->oshape);
+        for(int i=0; i<ref->size; i++) ref->ptr[i] = t->ptr[sd->cpu_addresses[i]];
+
+        Tensor* s = t->select(indices);
+        ASSERT_TRUE(Tensor::equivalent(ref, s, 10e-6));
+
+        Tensor* back = Tensor::zeros(t->shape);
+        Tensor::select_back(s, back, sd);
+        Tensor* back_ref = Tensor::zeros(t->shape);
+        for(int i=0; i<ref->size; i++) back_ref->ptr[sd->cpu_addresses[i]] += ref->ptr[i];
+        ASSERT_TRUE(Tensor::equivalent(back_ref, back, 10e-6));
+
+        delete sd; delete ref; delete s; delete back; delete back_ref;
+    }
+
+    Tensor* p = Tensor::permute(t, {1, 0, 2});
+    auto *pd = new PermuteDescriptor({1, 0, 2}, DEV_CPU);
+    pd->build(t->shape);
+    ASSERT_EQ(pd->run, 5);
+    for(int i=0; i<p->size; i++) ASSERT_EQ(p->ptr[i], t->ptr[pd->cpu_addresses[i]]);
+
+    delete pd;
+    delete p;
+    delete s2;
+    delete v1;
+    delete v2;
+    delete t;
+}
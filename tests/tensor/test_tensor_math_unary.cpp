@@ -1,10 +1,13 @@
 #include <gtest/gtest.h>
 #include <random>
+#include <cstring>
+#include <limits>
 #include <string>
 
 #include "eddl/tensor/tensor.h"
 #include "eddl/tensor/nn/tensor_nn.h"
 #include "eddl/descriptors/descriptors.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
 
 
 using namespace std;
@@ -1936,3 +1939,97 @@ TEST(TensorTestSuite, tensor_math_unary_var){
     
 #endif
 }
+
+
+// Error in units in the last place of the float closest to ref
+static double ulp_error(float y, double ref){
+    double ulp = std::ldexp(1.0, std::ilogb((float)ref) - 23);
+    return std::fabs(y - ref)/ulp;
+}
+
+// Bit checks, since the tests can be built with -ffast-math
+static bool is_nan_bits(float v){
+    unsigned int b; std::memcpy(&b, &v, sizeof(b));
+    return ((b & 0x7f800000u) == 0x7f800000u) && (b & 0x007fffffu);
+}
+
+static bool is_inf_bits(float v, bool negative){
+    unsigned int b; std::memcpy(&b, &v, sizeof(b));
+    return b == (negative ? 0xff800000u : 0x7f800000u);
+}
+
+TEST(TensorTestSuite, tensor_math_unary_simd_ulp){
+    vector<float> x;
+    for(float v=-100.0f; v<=100.0f; v+=0.0031f) x.push_back(v);
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for(int i=0; i<20000; i++) x.push_back(std::ldexp(dist(gen), -(i%40)));
+    vector<float> pos(x.size());
+    for(int i=0; i<x.size(); i++) pos[i] = std::fabs(x[i]) + 1e-30f;
+
+    struct Case { void (*f)(const float*, float*, long int); double (*ref)(double); bool positive; double ulps; };
+    vector<Case> cases = {
+        {cpu_vexp, [](double v){ return std::exp(v); }, false, 1.5},
+        {cpu_vlog, [](double v){ return std::log(v); }, true, 1.0},
+        {cpu_vtanh, [](double v){ return std::tanh(v); }, false, 2.0},
+        {cpu_vsigmoid, [](double v){ return 1.0/(1.0 + std::exp(-v)); }, false, 4.5},
+        {cpu_vsoftplus, [](double v){ return std::max(v, 0.0) + std::log1p(std::exp(-std::fabs(v))); }, false, 4.5},
+    };
+
+    int isa_orig = cpu_isa();
+    for(int isa=CPU_ISA_SCALAR; isa<=isa_orig; isa++){
+        cpu_set_isa(isa);
+
+        // The bounds are those of the polynomials, the scalar path is up to libm
+        for(auto &c : cases){
+            if(isa == CPU_ISA_SCALAR) break;
+            vector<float> &in = c.positive ? pos : x;
+            vector<float> y(in.size());
+            c.f(in.data(), y.data(), (long int)in.size());
+            for(int i=0; i<in.size(); i++){
+                double ref = c.ref(in[i]);
+                if(std::fabs(ref) < 1.17549435e-38 || std::fabs(ref) > 3.40282347e+38) continue;  // Denormals and overflows
+                ASSERT_LE(ulp_error(y[i], ref), c.ulps) << "isa " << isa << ", case " << (&c - cases.data()) << ", x=" << in[i];
+            }
+        }
+
+        // Special values, also in the tail
+        vector<float> sp = {std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(),
+                            -std::numeric_limits<float>::infinity(), 0.0f, -200.0f, 200.0f, -5.0f};
+        vector<float> y(sp.size());
+        cpu_vexp(sp.data(), y.data(), sp.size());
+        ASSERT_TRUE(is_nan_bits(y[0])); ASSERT_TRUE(is_inf_bits(y[1], false)); ASSERT_EQ(y[2], 0.0f); ASSERT_EQ(y[3], 1.0f);
+        cpu_vlog(sp.data(), y.data(), sp.size());
+        ASSERT_TRUE(is_nan_bits(y[0])); ASSERT_TRUE(is_inf_bits(y[1], false)); ASSERT_TRUE(is_inf_bits(y[3], true)); ASSERT_TRUE(is_nan_bits(y[6]));
+        cpu_vsigmoid(sp.data(), y.data(), sp.size());
+        ASSERT_EQ(y[4], 0.0f); ASSERT_NEAR(y[5], 1.0f, 1e-6f);
+        cpu_vsoftplus(sp.data(), y.data(), sp.size());
+        ASSERT_NEAR(y[5], 200.0f, 1e-4f);
+        cpu_vtanh(sp.data(), y.data(), sp.size());
+        ASSERT_NEAR(y[4], -1.0f, 1e-6f); ASSERT_NEAR(y[5], 1.0f, 1e-6f);
+    }
+    cpu_set_isa(isa_orig);
+}
+
+
+TEST(TensorTestSuite, tensor_math_unary_grain_size){
+    Tensor* t = Tensor::randn({10, 1000});
+    vector<Tensor*> out;
+
+    // Forked and inline runs must match
+    long int grain_orig = cpu_grain;
+    for(long int grain : {1L, (long int)t->size}){
+        cpu_set_grain(grain);
+        Tensor* r = t->clone();
+        r->sigmoid_();
+        r->mult_(3.0f);
+        r->add_(t);
+        out.push_back(r);
+    }
+    cpu_set_grain(grain_orig);
+    ASSERT_TRUE((bool) Tensor::equivalent(out[0], out[1], 1e-6f, 1e-6f));
+    ASSERT_THROW(cpu_set_grain(0), std::runtime_error);
+
+    delete t;
+    for(auto *r : out) delete r;
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/mempool.h"
+#include "eddl/utils.h"
+
+using namespace std;
+
+
+TEST(TensorTestSuite, tensor_mempool){
+    mempool_release();
+    MemPoolStats s0 = mempool_stats();
+
+    // Aligned, and the block of a freed tensor is reused by the next one of its size
+    Tensor *a = new Tensor({1000, 3});
+    ASSERT_EQ((uintptr_t)a->ptr % 64, 0);
+    float *p = a->ptr;
+    delete a;
+
+    MemPoolStats s1 = mempool_stats();
+    ASSERT_EQ(s1.bytes_in_use, s0.bytes_in_use);
+    ASSERT_GE(s1.bytes_cached, 3000 * sizeof(float));
+
+    Tensor *b = new Tensor({2990});
+    ASSERT_EQ(b->ptr, p);
+    MemPoolStats s2 = mempool_stats();
+    ASSERT_EQ(s2.hits, s1.hits + 1);
+    ASSERT_EQ(s2.misses, s1.misses);
+    ASSERT_GE(s2.peak_bytes, s2.bytes_in_use);
+    delete b;
+
+    // Budget: requests that do not fit throw, the cache is released to make room
+    mempool_set_budget(s2.bytes_in_use + (1 << 20));
+    ASSERT_THROW(get_fmem(1 << 20, "tensor_mempool"), std::runtime_error);
+    float *q = get_fmem(1 << 16, "tensor_mempool");
+    free_fmem(q);
+    mempool_set_budget(0);
+
+    mempool_release();
+    ASSERT_EQ(mempool_stats().bytes_cached, 0);
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <omp.h>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/random.h"
+
+using namespace std;
+
+
+TEST(TensorTestSuite, tensor_random_philox){
+    // Known answers of Philox4x32-10 (Random123)
+    uint32_t r[4];
+    philox4x32(0, 0, r);
+    ASSERT_EQ(r[0], 0x6627e8d5u);
+    ASSERT_EQ(r[1], 0xe169c58du);
+    ASSERT_EQ(r[2], 0xbc57ac4cu);
+    ASSERT_EQ(r[3], 0x9b00dbd8u);
+
+    // Same values for any number of threads
+    int nth = omp_get_max_threads();
+    Tensor *a = new Tensor({100003});
+    Tensor *b = new Tensor({100003});
+    set_random_seed(42);
+    omp_set_num_threads(1);
+    a->fill_rand_normal_(0.0f, 1.0f);
+    set_random_seed(42);
+    omp_set_num_threads(max(nth, 4));
+    b->fill_rand_normal_(0.0f, 1.0f);
+    omp_set_num_threads(nth);
+    for(int i=0; i<a->size; i++) ASSERT_EQ(a->ptr[i], b->ptr[i]);
+
+    ASSERT_NEAR(a->mean(), 0.0f, 0.02f);
+    ASSERT_NEAR(a->std(), 1.0f, 0.02f);
+
+    // The stream moves on
+    b->fill_rand_normal_(0.0f, 1.0f);
+    ASSERT_FALSE((bool) Tensor::equivalent(a, b, 1e-5f, 1e-5f));
+
+    a->fill_rand_binary_(0.25f);
+    ASSERT_NEAR(a->mean(), 0.25f, 0.01f);
+
+    delete a;
+    delete b;
+}
@@ -2,11 +2,14 @@
 #include <random>
 #include <string>
 #include <ctime>
+#include <cmath>
+#include <algorithm>
 
 #include "eddl/tensor/tensor.h"
 #include "eddl/tensor/tensor_reduction.h"
 #include "eddl/tensor/nn/tensor_nn.h"
 #include "eddl/descriptors/descriptors.h"
+#include "eddl/hardware/cpu/cpu_tensor.h"
 
 
 using namespace std;
@@ -641,4 +644,99 @@ TEST(TensorTestSuite, tensor_math_reduction_median) {
     delete t_gpu_median;
 
 #endif
-}
\ No newline at end of file
+}
+
+// Elements of every reduction of A, outputs in row-major order and each one with the first
+// reduced axis running fastest (the order of argmax)
+static vector<vector<float>> reduce_groups(Tensor *A, const vector<int> &axis){
+    int nout = 1, nred = 1;
+    for(int d=0; d<A->ndim; d++) {
+        if (find(axis.begin(), axis.end(), d) != axis.end()) nred *= A->shape[d];
+        else nout *= A->shape[d];
+    }
+    vector<vector<float>> g(nout, vector<float>(nred));
+    for(int k=0; k<A->size; k++) {
+        int r = k, o = 0, ow = 1, p = 0, pw = 1;
+        vector<int> c(A->ndim);
+        for(int d=A->ndim-1; d>=0; d--) { c[d] = r % A->shape[d]; r /= A->shape[d]; }
+        for(int d=A->ndim-1; d>=0; d--)
+            if (find(axis.begin(), axis.end(), d) == axis.end()) { o += c[d]*ow; ow *= A->shape[d]; }
+        for(int d=0; d<A->ndim; d++)
+            if (find(axis.begin(), axis.end(), d) != axis.end()) { p += c[d]*pw; pw *= A->shape[d]; }
+        g[o][p] = A->ptr[k];
+    }
+    return g;
+}
+
+TEST(TensorTestSuite, tensor_math_reduction_strided){
+    long int grain = cpu_grain;
+    vector<vector<int>> axes = {{0}, {1}, {3}, {0, 2}, {1, 2}, {2, 3}, {0, 1, 3}, {0, 1, 2}};
+
+    for(long int gs : {grain, 8L}) {  // Serial and parallel paths
+        cpu_set_grain(gs);
+        Tensor *A = Tensor::randn({3, 4, 5, 67});
+        A->mult_(2.0f); A->round_();  // Plenty of ties for argmax/argmin
+
+        for(auto &axis : axes) {
+            auto g = reduce_groups(A, axis);
+            Tensor *sum = A->sum(axis, false), *mean = A->mean(axis, false);
+            Tensor *max = A->max(axis, false), *argmax = A->argmax(axis, false);
+            Tensor *min = A->min(axis, false), *argmin = A->argmin(axis, false);
+            Tensor *median = A->median(axis, false), *norm = A->norm(axis, false);
+
+            ASSERT_EQ(sum->size, (int)g.size());
+            for(int i=0; i<g.size(); i++) {
+                float s = 0.0f, n2 = 0.0f;
+                for(float v : g[i]) { s += v; n2 += v*v; }
+                int imax = (int)(max_element(g[i].begin(), g[i].end()) - g[i].begin());
+                int imin = (int)(min_element(g[i].begin(), g[i].end()) - g[i].begin());
+                vector<float> sorted(g[i]);
+                sort(sorted.begin(), sorted.end());
+                int mid = sorted.size()/2;
+                float med = (sorted.size() % 2 == 1) ? sorted[mid] : (sorted[mid-1] + sorted[mid]) / 2.0f;
+
+                ASSERT_NEAR(sum->ptr[i], s, 1e-3f);
+                ASSERT_NEAR(mean->ptr[i], s / g[i].size(), 1e-4f);
+                ASSERT_EQ(max->ptr[i], g[i][imax]);
+                ASSERT_EQ((int)argmax->ptr[i], imax);
+                ASSERT_EQ(min->ptr[i], g[i][imin]);
+                ASSERT_EQ((int)argmin->ptr[i], imin);
+                ASSERT_NEAR(median->ptr[i], med, 1e-5f);
+                ASSERT_NEAR(norm->ptr[i], ::sqrtf(n2), 1e-3f);
+            }
+            delete sum; delete mean; delete max; delete argmax;
+            delete min; delete argmin; delete median; delete norm;
+        }
+
+        // Reduction layers: mean with keepdims (forward and backward) and max with its addresses
+        for(auto &axis : axes) {
+            auto g = reduce_groups(A, axis);
+
+            auto *RD = new ReduceDescriptor(A, axis, "mean", true);
+            RD->D = Tensor::ones(A->shape);
+            RD->ID = Tensor::zeros(A->shape);
+            reduction(RD);
+            reduction_back(RD);
+            Tensor *mean = A->mean(axis, true);
+            for(int k=0; k<A->size; k++) ASSERT_NEAR(RD->ID->ptr[k], 1.0f, 1e-5f);
+            for(int i=0; i<g.size(); i++) {
+                float s = 0.0f;
+                for(float v : g[i]) s += v;
+                ASSERT_NEAR(mean->ptr[i], s / g[i].size(), 1e-4f);
+            }
+            float total = RD->O->sum();
+            ASSERT_NEAR(total, A->sum(), 1e-2f);
+            delete mean; delete RD->O; delete RD->D; delete RD->ID; delete RD;
+
+            RD = new ReduceDescriptor(A, axis, "max", false);
+            reduction(RD);
+            for(int i=0; i<g.size(); i++) {
+                ASSERT_EQ(RD->O->ptr[i], *max_element(g[i].begin(), g[i].end()));
+                ASSERT_EQ(A->ptr[(int)RD->S->ptr[i]], RD->O->ptr[i]);
+            }
+            delete RD->O; delete RD->S; delete RD;
+        }
+        delete A;
+    }
+    cpu_set_grain(grain);
+}